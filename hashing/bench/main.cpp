@@ -0,0 +1,506 @@
+#include <malloc.h>  // mallinfo2
+#include <unistd.h>  // mkdtemp
+
+#include <algorithm>                     // std::sort
+#include <chrono>                        // std::chrono
+#include <cstdint>                       // uint64_t
+#include <cstdio>                        // std::printf
+#include <cstdlib>                       // std::system, std::getenv
+#include <fstream>                       // std::ifstream
+#include <functional>                    // std::function
+#include <map>                           // std::map
+#include <random>                        // std::mt19937_64
+#include <string>                        // std::string
+#include <thread>                        // std::thread
+#include <vector>                        // std::vector
+#include "../include/account_store.h"    // ac::AccountStore
+#include "../include/compact_hashtbl.h"  // ac::CompactHashTbl
+#include "../include/durable_hashtbl.h"  // ac::DurableHashTbl
+#include "../include/flat_hashtbl.h"     // ac::FlatHashTbl
+#include "../include/paged_hashtbl.h"    // ac::PagedHashTbl
+#include "../include/perfect_hash.h"     // ac::StaticHashTbl
+#include "../include/sampled_hashtbl.h"  // ac::SampledHashTbl
+#include "../include/small_hashtbl.h"    // ac::SmallHashTbl
+#include "../include/table_diff.h"       // ac::diff
+#include "../include/ttl_hashtbl.h"      // ac::TtlHashTbl
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+using Clock = std::chrono::steady_clock;
+
+//! \brief Seconds elapsed since start.
+double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//! \brief Creates a scratch directory (in $TMPDIR, or /tmp).
+std::string scratch_dir(void) {
+        const char* tmp = std::getenv("TMPDIR");
+        std::string tmpl = std::string(tmp ? tmp : "/tmp") + "/hashtbl_benchXXXXXX";
+        return mkdtemp(&tmpl[0]);
+}
+
+//! \brief Bytes allocated by malloc (heap and mmap) and not yet freed.
+size_t heap_bytes(void) {
+        auto info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+//! \brief Write throughput of the durable table for different group commit sizes.
+void bench_wal(void) {
+        const size_t n_writes = 20000;
+        std::string dir = scratch_dir();
+
+        std::printf("%-12s %14s %10s\n", "group size", "writes/s", "fsyncs");
+        for (size_t group : {1, 8, 64, 512, 4096}) {
+                std::string path = dir + "/wal_" + std::to_string(group);
+                ac::DurableHashTbl<uint64_t, uint64_t> table(path, group);
+
+                auto start = Clock::now();
+                for (uint64_t i = 0; i < n_writes; i++) table.insert(i % 1000, i);
+                table.sync();
+                double elapsed = seconds_since(start);
+
+                std::printf("%-12zu %14.0f %10zu\n", group, n_writes / elapsed,
+                            (n_writes + group - 1) / group);
+        }
+
+        std::system(("rm -rf " + dir).c_str());
+}
+
+//! \brief Agency queries with the secondary index against a scan of every account.
+void bench_accounts(void) {
+        const int n_accounts = 200000, n_queries = 100;
+        ac::AccountStore indexed(ac::AccountStore::BY_AGENCY), plain(ac::AccountStore::NONE);
+        for (int i = 0; i < n_accounts; i++) {
+                Account account("Client " + std::to_string(i % 5000), i % 10, i % 1000, i);
+                indexed.insert(account);
+                plain.insert(account);
+        }
+
+        std::printf("%-12s %14s %14s\n", "store", "us/query", "accounts");
+        for (auto store : {&indexed, &plain}) {
+                size_t found = 0;
+                auto start = Clock::now();
+                for (int q = 0; q < n_queries; q++) found += store->by_agency(q % 10, q).size();
+                double elapsed = seconds_since(start);
+
+                std::printf("%-12s %14.2f %14zu\n", store == &indexed ? "indexed" : "scan",
+                            elapsed * 1e6 / n_queries, found);
+        }
+}
+
+//! \brief Nightly reconciliation of two account tables: nested lookups against ac::diff.
+void bench_diff(void) {
+        using Table = ac::HashTbl<Account::AcctKey, Account, AcctKeyHash, AcctKeyEqual>;
+        const int n_accounts = 1000000;
+
+        // A day later: 1% of the balances moved, 0.1% of the accounts opened or closed.
+        Table before, after;
+        for (int i = 0; i < n_accounts; i++) {
+                Account account("Client " + std::to_string(i % 5000), i % 10, i % 1000, i, i);
+                before.insert(account.getKey(), account);
+                if (i % 1000 == 0) continue;
+                if (i % 100 == 1) account.m_balance += 1;
+                after.insert(account.getKey(), account);
+        }
+        for (int i = n_accounts; i < n_accounts + n_accounts / 1000; i++) {
+                Account account("Client " + std::to_string(i % 5000), i % 10, i % 1000, i, i);
+                after.insert(account.getKey(), account);
+        }
+
+        // What the reconciliation did so far: look every key up in the other table.
+        auto start = Clock::now();
+        size_t n_changes = 0;
+        before.for_each([&](const Account::AcctKey& key, const Account& account) {
+                Account other;
+                if (!after.retrieve(key, other) || !AcctBalanceEqual()(account, other)) n_changes++;
+        });
+        after.for_each([&](const Account::AcctKey& key, const Account&) {
+                Account other;
+                if (!before.retrieve(key, other)) n_changes++;
+        });
+        double elapsed = seconds_since(start);
+        std::printf("%-16s %14s %14s\n", "method", "ms", "changes");
+        std::printf("%-16s %14.2f %14zu\n", "nested lookups", elapsed * 1e3, n_changes);
+
+        // One worker, then one per hardware thread (if there are more).
+        std::vector<size_t> workers{1};
+        if (std::thread::hardware_concurrency() > 1) {
+                workers.push_back(std::thread::hardware_concurrency());
+        }
+        for (size_t threads : workers) {
+                start = Clock::now();
+                auto delta = ac::diff(before, after, threads);
+                elapsed = seconds_since(start);
+
+                std::string name = "diff x" + std::to_string(threads);
+                std::printf("%-16s %14.2f %14zu\n", name.c_str(), elapsed * 1e3,
+                            delta.m_added.size() + delta.m_removed.size() + delta.m_changed.size());
+        }
+        std::printf("same bucket count: %s\n",
+                    before.bucket_count() == after.bucket_count() ? "yes" : "no");
+}
+
+//! \brief Prefix queries (top 10) on client names, with the radix tree against a scan.
+void bench_names(void) {
+        // One account per word of the Portuguese dictionary (ISO-8859-1, CRLF).
+        std::ifstream file(SOURCE_DIR "/../huffman/assets/tests/dicionario.txt");
+        std::vector<std::string> names;
+        for (std::string line; std::getline(file, line);) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                names.push_back(line);
+        }
+        if (names.empty()) {
+                std::printf("dictionary not found\n");
+                return;
+        }
+
+        ac::AccountStore indexed(ac::AccountStore::BY_PREFIX), plain(ac::AccountStore::NONE);
+        auto start = Clock::now();
+        for (size_t i = 0; i < names.size(); i++) indexed.insert(Account(names[i], 1, 1, i));
+        std::printf("%zu names indexed in %.2f s\n", names.size(), seconds_since(start));
+        for (size_t i = 0; i < names.size(); i++) plain.insert(Account(names[i], 1, 1, i));
+
+        // Prefixes of 1 to 4 characters of random names.
+        std::mt19937_64 rng(42);
+        std::vector<std::string> prefixes;
+        for (int q = 0; q < 1000; q++) {
+                const std::string& name = names[rng() % names.size()];
+                prefixes.push_back(name.substr(0, 1 + q % 4));
+        }
+
+        std::printf("%-12s %14s %14s\n", "store", "us/query", "accounts");
+        for (auto store : {&indexed, &plain}) {
+                size_t n_queries = store == &indexed ? prefixes.size() : 20, found = 0;
+                start = Clock::now();
+                for (size_t q = 0; q < n_queries; q++) {
+                        found += store->by_prefix(prefixes[q], 10).size();
+                }
+                double elapsed = seconds_since(start);
+
+                std::printf("%-12s %14.2f %14.2f\n", store == &indexed ? "radix tree" : "scan",
+                            elapsed * 1e6 / n_queries, double(found) / n_queries);
+        }
+}
+
+//! \brief Full scan of a chained table against the compact, insertion-ordered one.
+void bench_compact(void) {
+        const uint64_t n_keys = 1000000;
+        ac::HashTbl<uint64_t, uint64_t> chained;
+        ac::CompactHashTbl<uint64_t, uint64_t> compact;
+        for (uint64_t i = 0; i < n_keys; i++) {
+                chained.insert(i * 7919, i);
+                compact.insert(i * 7919, i);
+        }
+
+        std::printf("%-12s %14s\n", "table", "ns/entry");
+        uint64_t sum = 0;
+        auto start = Clock::now();
+        chained.for_each([&](uint64_t, uint64_t d) { sum += d; });
+        std::printf("%-12s %14.2f\n", "HashTbl", seconds_since(start) * 1e9 / n_keys);
+
+        start = Clock::now();
+        compact.for_each([&](uint64_t, uint64_t d) { sum -= d; });
+        std::printf("%-12s %14.2f\n", "Compact", seconds_since(start) * 1e9 / n_keys);
+
+        if (sum != 0) std::printf("scans disagree\n");
+}
+
+//! \brief Full scans of a table after months of churn, before and after compact().
+void bench_churn(void) {
+        const uint64_t n_keys = 1000000;
+        ac::HashTbl<uint64_t, uint64_t> table;
+        for (uint64_t i = 0; i < n_keys; i++) table.insert(i, i);
+
+        // Erase and insert random keys: each new node takes the place freed by another bucket.
+        std::mt19937_64 rng(42);
+        for (uint64_t i = 0; i < 3 * n_keys; i++) {
+                table.erase(rng() % (2 * n_keys));
+                table.insert(rng() % (2 * n_keys), i);
+        }
+
+        auto scan = [&]() {
+                uint64_t sum = 0;
+                auto start = Clock::now();
+                table.for_each([&](uint64_t, uint64_t d) { sum += d; });
+                return seconds_since(start) * 1e9 / table.size() + (sum == 0);
+        };
+
+        std::printf("%-12s %14s %14s %14s\n", "layout", "ns/entry", "pages", "fragmentation");
+        auto stats = table.stats();
+        std::printf("%-12s %14.2f %14zu %14.3f\n", "churned", scan(), stats.m_pages,
+                    stats.fragmentation());
+
+        auto start = Clock::now();
+        table.compact();
+        double elapsed = seconds_since(start);
+        stats = table.stats();
+        std::printf("%-12s %14.2f %14zu %14.3f\n", "compacted", scan(), stats.m_pages,
+                    stats.fragmentation());
+        std::printf("compact(): %.0f ms\n", elapsed * 1e3);
+}
+
+//! \brief Memory of many tiny maps, and lookup time in them.
+template <typename Table>
+void bench_tiny_maps(const char* name, size_t n_maps, uint64_t n_entries) {
+        size_t before = heap_bytes();
+        auto start = Clock::now();
+        std::vector<Table> maps(n_maps);
+        for (size_t m = 0; m < n_maps; m++) {
+                for (uint64_t i = 0; i < n_entries; i++) maps[m].insert(i * 31 + m, i);
+        }
+        double build = seconds_since(start);
+        size_t bytes = heap_bytes() - before;
+
+        uint64_t sum = 0, data;
+        start = Clock::now();
+        for (size_t m = 0; m < n_maps; m++) {
+                for (uint64_t i = 0; i < n_entries; i++) sum += maps[m].retrieve(i * 31 + m, data);
+        }
+        double lookups = seconds_since(start);
+
+        if (sum != n_maps * n_entries) std::printf("lookups failed\n");
+        std::printf("%-14s %8zu %14.1f %14.2f %14.2f\n", name, size_t(n_entries),
+                    double(bytes) / n_maps, build * 1e9 / (n_maps * n_entries),
+                    lookups * 1e9 / (n_maps * n_entries));
+}
+
+//! \brief Many tiny maps: chained HashTbl against the inline SmallHashTbl.
+void bench_small(void) {
+        const size_t n_maps = 200000;
+
+        std::printf("%-14s %8s %14s %14s %14s\n", "table", "entries", "bytes/map", "ns/insert",
+                    "ns/lookup");
+        for (uint64_t n_entries : {2, 4, 8}) {
+                bench_tiny_maps<ac::HashTbl<uint64_t, uint64_t>>("HashTbl", n_maps, n_entries);
+                bench_tiny_maps<ac::SmallHashTbl<uint64_t, uint64_t>>("SmallHashTbl", n_maps,
+                                                                      n_entries);
+        }
+}
+
+//! \brief Build (with every resize), copy and lookups of a table of integers.
+template <typename Table>
+void bench_int_table(const char* name, uint64_t n_keys) {
+        auto start = Clock::now();
+        Table table;
+        for (uint64_t i = 0; i < n_keys; i++) table.insert(ac::detail::mix64(i), i);
+        double build = seconds_since(start);
+
+        start = Clock::now();
+        Table copy(table);
+        double clone = seconds_since(start);
+
+        uint64_t sum = 0, data;
+        start = Clock::now();
+        for (uint64_t i = 0; i < n_keys; i++) sum += copy.retrieve(ac::detail::mix64(i), data);
+        double lookups = seconds_since(start);
+
+        if (sum != n_keys) std::printf("lookups failed\n");
+        std::printf("%-12s %14.2f %14.2f %14.2f\n", name, build * 1e9 / n_keys,
+                    clone * 1e9 / n_keys, lookups * 1e9 / n_keys);
+}
+
+//! \brief Chained HashTbl against FlatHashTbl on trivially copyable entries.
+void bench_flat(void) {
+        const uint64_t n_keys = 1000000;
+
+        std::printf("%-12s %14s %14s %14s\n", "table", "ns/insert", "ns/copied", "ns/lookup");
+        bench_int_table<ac::HashTbl<uint64_t, uint64_t>>("HashTbl", n_keys);
+        bench_int_table<ac::FlatHashTbl<uint64_t, uint64_t>>("FlatHashTbl", n_keys);
+}
+
+//! \brief Lookups of a sequence of keys.
+//! \return Nanoseconds per lookup.
+template <typename Table, typename Key, typename Data>
+double bench_lookups(const Table& table, const std::vector<Key>& keys, Data data) {
+        size_t found = 0;
+        auto start = Clock::now();
+        for (const auto& key : keys) found += table.retrieve(key, data);
+        double elapsed = seconds_since(start);
+
+        if (found != keys.size()) std::printf("lookups failed\n");
+        return elapsed * 1e9 / keys.size();
+}
+
+//! \brief Build time and memory of a StaticHashTbl made from a HashTbl, and lookups in both.
+void bench_perfect(void) {
+        const uint64_t n_keys = 1000000;
+        std::vector<uint64_t> keys(n_keys);
+        for (uint64_t i = 0; i < n_keys; i++) keys[i] = ac::detail::mix64(i);
+
+        size_t before = heap_bytes();
+        auto start = Clock::now();
+        ac::HashTbl<uint64_t, uint64_t> table;
+        for (uint64_t i = 0; i < n_keys; i++) table.insert(keys[i], i);
+        double build = seconds_since(start);
+        size_t bytes = heap_bytes() - before;
+
+        std::printf("%-14s %14s %14s %14s\n", "table", "ns/key built", "bytes/key", "ns/lookup");
+        std::printf("%-14s %14.2f %14.1f %14.2f\n", "HashTbl", build * 1e9 / n_keys,
+                    double(bytes) / n_keys, bench_lookups(table, keys, uint64_t()));
+
+        // The HashTbl stays alive: the bytes counted are those of the StaticHashTbl alone.
+        before = heap_bytes();
+        start = Clock::now();
+        ac::StaticHashTbl<uint64_t, uint64_t> frozen(table);
+        build = seconds_since(start);
+        bytes = heap_bytes() - before;
+        std::printf("%-14s %14.2f %14.1f %14.2f\n", "StaticHashTbl", build * 1e9 / n_keys,
+                    double(bytes) / n_keys, bench_lookups(frozen, keys, uint64_t()));
+        std::printf("index: %.2f bits/key\n", double(frozen.index().bits()) / n_keys);
+}
+
+//! \brief Cost of the sampling on retrieve(), for a table of n entries made by make(i).
+//!
+//! The same table is read through HashTbl (no sampling), with the sampling disabled and enabled,
+//! so that the three runs hit the same memory. Keys i < 10 take (10 - i)% of the lookups.
+template <typename Table, typename Make>
+void bench_sampled_table(const char* name, uint64_t n_entries, Make make) {
+        const size_t n_lookups = 2000000;
+        Table table;
+        for (uint64_t i = 0; i < n_entries; i++) table.insert(make(i).first, make(i).second);
+
+        std::mt19937_64 rng(42);
+        std::vector<decltype(make(0).first)> keys;
+        for (size_t i = 0; i < n_lookups; i++) {
+                uint64_t r = rng() % 100, hot = 0;
+                while (hot < 10 && r >= 10 - hot) r -= 10 - hot++;
+                keys.push_back(make(hot < 10 ? hot : 10 + rng() % (n_entries - 10)).first);
+        }
+
+        // Interleave the runs, and keep the best of each, to smooth out the noise.
+        const typename Table::Table& base = table.unsampled();
+        double plain = 1e9, disabled = 1e9, enabled = 1e9;
+        for (int run = 0; run < 10; run++) {
+                plain = std::min(plain, bench_lookups(base, keys, make(0).second));
+                table.set_period(0);
+                disabled = std::min(disabled, bench_lookups(table, keys, make(0).second));
+                table.set_period(64);
+                enabled = std::min(enabled, bench_lookups(table, keys, make(0).second));
+        }
+
+        std::printf("%-10s %14.2f %14.2f %14.2f %14.2f\n", name, plain,
+                    (disabled / plain - 1) * 100, (enabled / plain - 1) * 100,
+                    100.0 * table.estimate(make(0).first) / (n_lookups * 10 / 100));
+}
+
+//! \brief Overhead of the hot key sampling on retrieve().
+void bench_sampling(void) {
+        using Accounts = ac::SampledHashTbl<Account::AcctKey, Account, AcctKeyHash, AcctKeyEqual>;
+
+        std::printf("%-10s %14s %14s %14s %14s\n", "keys", "ns/lookup", "% off", "% 1/64",
+                    "key 0 est. %");
+        bench_sampled_table<Accounts>("accounts", 1000000, [](uint64_t i) {
+                Account account("Client " + std::to_string(i % 5000), i % 10, i % 1000, i);
+                return std::make_pair(account.getKey(), account);
+        });
+        bench_sampled_table<ac::SampledHashTbl<uint64_t, uint64_t>>(
+            "integers", 1000000, [](uint64_t i) { return std::make_pair(i, i); });
+}
+
+//! \brief Cold lookups in a disk-resident table much larger than its buffer pool.
+void bench_paged(void) {
+        const uint64_t n_keys = 1000000;
+        const size_t n_lookups = 20000;
+        std::string dir = scratch_dir();
+
+        ac::PagedHashTbl<uint64_t, uint64_t> table(dir + "/paged", 64);
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < n_keys; i++) table.insert(i, i);
+        table.flush();
+        std::printf("build: %zu keys, %zu pages in %.2f s\n", table.size(), table.page_count(),
+                    seconds_since(start));
+
+        table.drop_caches();
+        std::mt19937_64 rng(42);
+        size_t reads = table.page_reads(), found = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < n_lookups; i++) {
+                uint64_t data;
+                found += table.retrieve(rng() % n_keys, data);
+        }
+        double elapsed = seconds_since(start);
+
+        std::printf("%-12s %14s %14s\n", "lookups", "us/lookup", "reads/lookup");
+        std::printf("%-12zu %14.2f %14.3f\n", found, elapsed * 1e6 / n_lookups,
+                    double(table.page_reads() - reads) / n_lookups);
+
+        std::system(("rm -rf " + dir).c_str());
+}
+
+//! \brief Expiry of 1M entries by the timing wheel, against sweeping the whole table.
+void bench_ttl(void) {
+        const uint64_t n_keys = 1000000;
+        const auto horizon = std::chrono::milliseconds(500);
+
+        // Entries expire all along the horizon while lookups go on.
+        ac::TtlHashTbl<uint64_t, uint64_t> table;
+        std::mt19937_64 rng(42);
+        for (uint64_t i = 0; i < n_keys; i++) {
+                table.insert(i, i, std::chrono::milliseconds(1 + rng() % horizon.count()));
+        }
+
+        std::vector<double> latencies;
+        auto start = Clock::now();
+        while (Clock::now() - start < horizon + std::chrono::milliseconds(50)) {
+                uint64_t data;
+                auto op = Clock::now();
+                table.retrieve(rng() % n_keys, data);
+                latencies.push_back(seconds_since(op));
+        }
+        double elapsed = seconds_since(start);
+        std::sort(latencies.begin(), latencies.end());
+
+        std::printf("%-12s %14s %14s %14s\n", "expiry", "ns/op", "p99.9 us/op", "left");
+        std::printf("%-12s %14.2f %14.2f %14zu\n", "wheel", elapsed * 1e9 / latencies.size(),
+                    latencies[latencies.size() * 999 / 1000] * 1e6, table.size());
+
+        // A sweep stops everything to look at every entry, expired or not.
+        ac::HashTbl<uint64_t, uint64_t> swept;
+        for (uint64_t i = 0; i < n_keys; i++) swept.insert(i, rng() % horizon.count());
+        start = Clock::now();
+        std::vector<uint64_t> expired;
+        swept.for_each([&](uint64_t key, uint64_t expiry) {
+                if (expiry < 10) expired.push_back(key);
+        });
+        for (auto key : expired) swept.erase(key);
+        std::printf("%-12s %14s %14.2f %14zu\n", "sweep", "-", seconds_since(start) * 1e6,
+                    swept.size());
+}
+
+int main(int argc, char** argv) {
+        std::map<std::string, std::function<void(void)>> benchmarks{
+            {"accounts", bench_accounts},
+            {"churn", bench_churn},
+            {"compact", bench_compact},
+            {"diff", bench_diff},
+            {"flat", bench_flat},
+            {"names", bench_names},
+            {"paged", bench_paged},
+            {"perfect", bench_perfect},
+            {"sampling", bench_sampling},
+            {"small", bench_small},
+            {"ttl", bench_ttl},
+            {"wal", bench_wal},
+        };
+
+        // Run the benchmarks named in the command line, or all of them.
+        for (const auto& b : benchmarks) {
+                bool selected = argc == 1;
+                for (int i = 1; i < argc; i++) selected = selected || b.first == argv[i];
+                if (!selected) continue;
+
+                std::printf("=== %s ===\n", b.first.c_str());
+                b.second();
+                std::printf("\n");
+        }
+
+        return 0;
+}
@@ -1,7 +1,10 @@
 #ifndef ACCOUNT_H
 #define ACCOUNT_H
 
+#include <functional>
+#include <iostream>
 #include <string>
+#include <tuple>
 #include <utility>
 
 class Account {
@@ -25,7 +28,9 @@ class Account {
 
         //! \brief Get hash made by client name, bank number, agency number and account number.
         //! \return Key associated to data.
-        AcctKey getKey(void) { return std::make_tuple(m_name, bank_num, agency_num, acc_num); }
+        AcctKey getKey(void) const {
+                return std::make_tuple(m_name, bank_num, agency_num, acc_num);
+        }
 
         //! \brief Tests equality.
         //! \return True if equal, false otherwise.
@@ -50,4 +55,42 @@ class Account {
         }
 };
 
+//! \brief Hash of an account key, combining the hashes of its four fields.
+struct AcctKeyHash {
+        std::size_t operator()(const Account::AcctKey& k_) const {
+                std::size_t hash = std::hash<std::string>()(std::get<0>(k_));
+                for (int field : {std::get<1>(k_), std::get<2>(k_), std::get<3>(k_)}) {
+                        // Same mixing as boost::hash_combine.
+                        hash ^= std::size_t(field) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                }
+
+                return hash;
+        }
+};
+
+//! \brief Equality of accounts, balance included (Account::operator== compares the keys only).
+struct AcctBalanceEqual {
+        bool operator()(const Account& lhs_, const Account& rhs_) const {
+                return lhs_ == rhs_ && lhs_.m_balance == rhs_.m_balance;
+        }
+};
+
+namespace ac {
+
+template <typename DataType>
+struct DataEqual;
+
+//! \brief The diffs of account tables see balance changes too (see table_diff.h).
+template <>
+struct DataEqual<Account> : AcctBalanceEqual {};
+
+}  // namespace ac
+
+//! \brief Equality of account keys.
+struct AcctKeyEqual {
+        bool operator()(const Account::AcctKey& lhs_, const Account::AcctKey& rhs_) const {
+                return lhs_ == rhs_;
+        }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+#ifndef ACCOUNT_STORE_H
+#define ACCOUNT_STORE_H
+
+#include <algorithm>     // std::sort.
+#include <cmath>         // std::isfinite.
+#include <cstdint>       // uint32_t, uint64_t.
+#include <set>           // std::multiset.
+#include <stdexcept>     // std::invalid_argument.
+#include <string>        // std::string.
+#include <utility>       // std::pair.
+#include <vector>        // std::vector.
+#include "account.h"     // Account, AcctKeyHash, AcctKeyEqual.
+#include "hash_set.h"    // ac::HashSet.
+#include "hashtbl.h"     // ac::HashTbl, ac::detail::mix64.
+#include "radix_tree.h"  // ac::RadixTree.
+
+namespace ac {
+
+//! \brief Accounts indexed by their key, and optionally by bank, by agency and by client name.
+//!
+//! The primary index maps the account key to the account. Each secondary index maps a field (or
+//! the pair bank, agency) to the set of keys having it, so a query costs one lookup plus the
+//! accounts it returns, instead of a scan of every account. The indexed fields are part of the
+//! key, so an update (the same key with a new balance) leaves the secondary indexes untouched;
+//! insert and erase keep them in step with the primary index.
+//!
+//! The store can also keep aggregates of the balances per bank and per agency, updated with each
+//! change so that reading one does not look at the accounts. Count and sum are updated in O(1);
+//! min and max need an ordered set of the balances, updated in O(log n) and read in O(1).
+class AccountStore {
+       public:
+        //! \brief Aggregates of the balances of a group of accounts.
+        struct Aggregate {
+                size_t count;  //!< Number of accounts.
+                double sum;    //!< Total balance.
+                float min;     //!< Smallest balance (0 if there are no accounts).
+                float max;     //!< Largest balance (0 if there are no accounts).
+
+                //! \brief Returns the average balance (0 if there are no accounts).
+                double average(void) const { return count == 0 ? 0 : sum / count; }
+        };
+
+        //! \brief Secondary indexes, to be combined with |.
+        enum Index : unsigned {
+                NONE = 0,        //!< Primary index only.
+                BY_BANK = 1,     //!< Index on bank_num.
+                BY_AGENCY = 2,   //!< Index on (bank_num, agency_num).
+                BY_NAME = 4,     //!< Index on m_name.
+                AGGREGATES = 8,  //!< Aggregates per bank and per agency.
+                BY_PREFIX = 16,  //!< Sorted index on m_name, for prefix queries.
+                ALL = 31,        //!< Every secondary index and the aggregates.
+        };
+
+        //! \brief Constructs an empty store.
+        //! \param indexes Secondary indexes to maintain.
+        explicit AccountStore(unsigned indexes = ALL) : m_indexes{indexes} {}
+
+        //! \brief Inserts an account, or updates the account with the same key.
+        //! \param account Account to store.
+        //! \throw std::invalid_argument if the balance is not finite: the aggregates need an order.
+        //! \return True if the key was not in the store, false otherwise.
+        bool insert(const Account& account) {
+                if (!std::isfinite(account.m_balance)) {
+                        throw std::invalid_argument("AccountStore: balance is not finite");
+                }
+
+                const Account* old = m_accounts.find(account.getKey());
+                if (old != nullptr) {
+                        if (m_indexes & AGGREGATES) {
+                                totals_of(account).update(old->m_balance, account.m_balance);
+                                totals_of_agency(account).update(old->m_balance, account.m_balance);
+                        }
+                        m_accounts.insert(account.getKey(), account);
+                        return false;
+                }
+
+                m_accounts.insert(account.getKey(), account);
+                if (m_indexes & AGGREGATES) {
+                        totals_of(account).add(account.m_balance);
+                        totals_of_agency(account).add(account.m_balance);
+                }
+
+                if (m_indexes & BY_BANK) m_by_bank[account.bank_num].insert(account.getKey());
+                if (m_indexes & BY_AGENCY) {
+                        Agency agency(account.bank_num, account.agency_num);
+                        m_by_agency[agency].insert(account.getKey());
+                }
+                if (m_indexes & BY_NAME) m_by_name[account.m_name].insert(account.getKey());
+                if (m_indexes & BY_PREFIX) m_by_prefix[account.m_name].insert(account.getKey());
+
+                return true;
+        }
+
+        //! \brief Erases an account.
+        //! \param key_ Key of the account.
+        //! \return True if erased, false otherwise.
+        bool erase(const Account::AcctKey& key_) {
+                const Account* old = m_accounts.find(key_);
+                if (old == nullptr) return false;
+
+                if (m_indexes & AGGREGATES) {
+                        remove_balance(m_bank_totals, old->bank_num, old->m_balance);
+                        remove_balance(m_agency_totals, Agency(old->bank_num, old->agency_num),
+                                       old->m_balance);
+                }
+                m_accounts.erase(key_);
+
+                if (m_indexes & BY_BANK) unindex(m_by_bank, std::get<1>(key_), key_);
+                if (m_indexes & BY_AGENCY) {
+                        unindex(m_by_agency, Agency(std::get<1>(key_), std::get<2>(key_)), key_);
+                }
+                if (m_indexes & BY_NAME) unindex(m_by_name, std::get<0>(key_), key_);
+                if (m_indexes & BY_PREFIX) unindex(m_by_prefix, std::get<0>(key_), key_);
+
+                return true;
+        }
+
+        //! \brief Retrieves an account.
+        //! \param key_ Key of the account.
+        //! \param account Store the account.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const Account::AcctKey& key_, Account& account) const {
+                return m_accounts.retrieve(key_, account);
+        }
+
+        //! \brief Changes the balance of an account.
+        //! \param key_ Key of the account.
+        //! \param balance New balance.
+        //! \throw std::invalid_argument if the balance is not finite.
+        //! \return True if the account exists, false otherwise.
+        bool set_balance(const Account::AcctKey& key_, float balance) {
+                const Account* old = m_accounts.find(key_);
+                if (old == nullptr) return false;
+
+                Account account = *old;
+                account.m_balance = balance;
+                insert(account);
+                return true;
+        }
+
+        //! \brief Returns the aggregates of the balances of a bank, in O(1).
+        //! \param bank_num Bank number.
+        //! \return Aggregates (computed by a scan if the store keeps none).
+        Aggregate bank_aggregate(int bank_num) const {
+                if (m_indexes & AGGREGATES) return aggregate_of(m_bank_totals.find(bank_num));
+
+                return recompute([&](const Account& a) { return a.bank_num == bank_num; });
+        }
+
+        //! \brief Returns the aggregates of the balances of an agency, in O(1).
+        //! \param bank_num Bank number.
+        //! \param agency_num Agency number.
+        //! \return Aggregates (computed by a scan if the store keeps none).
+        Aggregate agency_aggregate(int bank_num, int agency_num) const {
+                if (m_indexes & AGGREGATES) {
+                        return aggregate_of(m_agency_totals.find(Agency(bank_num, agency_num)));
+                }
+
+                return recompute([&](const Account& a) {
+                        return a.bank_num == bank_num && a.agency_num == agency_num;
+                });
+        }
+
+        //! \brief Computes the aggregates of the accounts matching a predicate, with a full scan.
+        //! \param pred Predicate called as pred(account).
+        //! \return Aggregates.
+        template <typename Predicate>
+        Aggregate recompute(Predicate pred) const {
+                Totals totals;
+                m_accounts.for_each([&](const Account::AcctKey&, const Account& a) {
+                        if (pred(a)) totals.add(a.m_balance);
+                });
+                return aggregate_of(&totals);
+        }
+
+        //! \brief Returns the accounts of a bank.
+        //! \param bank_num Bank number.
+        //! \return Accounts, in no particular order.
+        std::vector<Account> by_bank(int bank_num) const {
+                if (m_indexes & BY_BANK) return lookup(m_by_bank, bank_num);
+
+                return scan([&](const Account& a) { return a.bank_num == bank_num; });
+        }
+
+        //! \brief Returns the accounts of an agency.
+        //! \param bank_num Bank number.
+        //! \param agency_num Agency number.
+        //! \return Accounts, in no particular order.
+        std::vector<Account> by_agency(int bank_num, int agency_num) const {
+                if (m_indexes & BY_AGENCY) return lookup(m_by_agency, Agency(bank_num, agency_num));
+
+                return scan([&](const Account& a) {
+                        return a.bank_num == bank_num && a.agency_num == agency_num;
+                });
+        }
+
+        //! \brief Returns the accounts of a client.
+        //! \param name Client name.
+        //! \return Accounts, in no particular order.
+        std::vector<Account> by_name(const std::string& name) const {
+                if (m_indexes & BY_NAME) return lookup(m_by_name, name);
+
+                return scan([&](const Account& a) { return a.m_name == name; });
+        }
+
+        //! \brief Returns the first accounts, sorted by client name, whose name has a prefix.
+        //! \param prefix Prefix of the client names.
+        //! \param k Largest number of accounts returned.
+        //! \return Accounts, sorted by client name (in no particular order for a same name).
+        std::vector<Account> by_prefix(const std::string& prefix, size_t k) const {
+                std::vector<Account> result;
+                if (m_indexes & BY_PREFIX) {
+                        m_by_prefix.for_each_prefix(
+                            prefix, k, [&](const std::string&, const Keys& keys) {
+                                    for (const auto& key : keys) {
+                                            if (result.size() == k) return;
+                                            result.push_back(*m_accounts.find(key));
+                                    }
+                            });
+                        return result;
+                }
+
+                result = scan([&](const Account& a) {
+                        return a.m_name.compare(0, prefix.size(), prefix) == 0;
+                });
+                std::sort(result.begin(), result.end(), [](const Account& a, const Account& b) {
+                        return a.m_name < b.m_name;
+                });
+                if (result.size() > k) result.resize(k);
+                return result;
+        }
+
+        //! \brief Checks whether the store is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_accounts.empty(); }
+
+        //! \brief Returns the number of accounts
+        //! \return Number of accounts.
+        inline size_t size(void) const { return m_accounts.size(); }
+
+        //! \brief Applies a function to every account.
+        //! \param fn Function called as fn(key, account) for each account.
+        template <typename Function>
+        void for_each(Function fn) const {
+                m_accounts.for_each(fn);
+        }
+
+       private:
+        using Accounts = HashTbl<Account::AcctKey, Account, AcctKeyHash, AcctKeyEqual>;
+        using Keys = HashSet<Account::AcctKey, AcctKeyHash, AcctKeyEqual>;  //!< Keys of an index.
+        using Agency = std::pair<int, int>;                                //!< Bank and agency.
+
+        // \brief Hash of a (bank, agency) pair.
+        struct AgencyHash {
+                size_t operator()(const Agency& a) const {
+                        uint64_t both = uint64_t(uint32_t(a.first)) << 32 | uint32_t(a.second);
+                        return detail::mix64(both);
+                }
+        };
+
+        //! \brief Running aggregates of a group of accounts.
+        struct Totals {
+                size_t m_count = 0;               //!< Number of accounts.
+                double m_sum = 0;                 //!< Total balance.
+                std::multiset<float> m_balances;  //!< Balances, for min and max.
+
+                void add(float balance) {
+                        m_count++;
+                        m_sum += balance;
+                        m_balances.insert(balance);
+                }
+
+                void remove(float balance) {
+                        m_count--;
+                        m_sum -= balance;
+                        auto it = m_balances.find(balance);
+                        if (it != m_balances.end()) m_balances.erase(it);
+                }
+
+                void update(float old_balance, float balance) {
+                        remove(old_balance);
+                        add(balance);
+                }
+        };
+
+        unsigned m_indexes;                                   //!< Indexes maintained.
+        Accounts m_accounts;                                  //!< Primary index: account by key.
+        HashTbl<int, Keys> m_by_bank;                         //!< Keys by bank.
+        HashTbl<Agency, Keys, AgencyHash> m_by_agency;        //!< Keys by (bank, agency).
+        HashTbl<std::string, Keys> m_by_name;                 //!< Keys by client name.
+        RadixTree<Keys> m_by_prefix;                          //!< Keys by client name, sorted.
+        HashTbl<int, Totals> m_bank_totals;                   //!< Aggregates by bank.
+        HashTbl<Agency, Totals, AgencyHash> m_agency_totals;  //!< Aggregates by (bank, agency).
+
+        // \brief Aggregates of the bank of an account.
+        Totals& totals_of(const Account& account) { return m_bank_totals[account.bank_num]; }
+
+        // \brief Aggregates of the agency of an account.
+        Totals& totals_of_agency(const Account& account) {
+                return m_agency_totals[Agency(account.bank_num, account.agency_num)];
+        }
+
+        // \brief Removes a balance from a group, dropping the group once empty.
+        template <typename Table, typename Field>
+        static void remove_balance(Table& totals, const Field& field, float balance) {
+                totals[field].remove(balance);
+                if (totals[field].m_count == 0) totals.erase(field);
+        }
+
+        // \brief Aggregates of a group (nullptr for a group with no accounts).
+        static Aggregate aggregate_of(const Totals* totals) {
+                if (totals == nullptr || totals->m_count == 0) return Aggregate{0, 0, 0, 0};
+
+                return Aggregate{totals->m_count, totals->m_sum, *totals->m_balances.begin(),
+                                 *totals->m_balances.rbegin()};
+        }
+
+        // \brief Removes a key from an index, dropping the set once empty.
+        template <typename Table, typename Field>
+        static void unindex(Table& index, const Field& field, const Account::AcctKey& key_) {
+                index[field].erase(key_);
+                if (index[field].empty()) index.erase(field);
+        }
+
+        // \brief Returns the accounts whose keys an index holds for a field.
+        template <typename Table, typename Field>
+        std::vector<Account> lookup(const Table& index, const Field& field) const {
+                std::vector<Account> result;
+                const Keys* keys = index.find(field);
+                if (keys == nullptr) return result;
+
+                result.reserve(keys->size());
+                for (const auto& key : *keys) result.push_back(*m_accounts.find(key));
+                return result;
+        }
+
+        // \brief Returns the accounts matching a predicate, scanning them all.
+        template <typename Predicate>
+        std::vector<Account> scan(Predicate pred) const {
+                std::vector<Account> result;
+                m_accounts.for_each([&](const Account::AcctKey&, const Account& a) {
+                        if (pred(a)) result.push_back(a);
+                });
+                return result;
+        }
+};
+
+}  // namespace ac
+
+#endif
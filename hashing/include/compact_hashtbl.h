@@ -0,0 +1,344 @@
+#ifndef COMPACT_HASHTBL_H
+#define COMPACT_HASHTBL_H
+
+#include <cstdint>     // uint8_t, uint16_t, uint32_t.
+#include <cstring>     // std::memcpy.
+#include <functional>  // std::hash, std::equal_to.
+#include <iostream>    // std::ostream.
+#include <stdexcept>   // std::out_of_range
+#include <utility>     // std::move.
+#include <vector>      // std::vector.
+#include "hashtbl.h"   // ac::HashEntry.
+
+namespace ac {
+
+//! \brief Hash table with a compact, insertion-ordered layout (as the CPython dict).
+//!
+//! Entries are appended to a dense array, in insertion order. Hashing is done by a separate
+//! index of slot numbers, with open addressing; a slot takes 1, 2 or 4 bytes, the narrowest
+//! type able to number the entries the index can hold. A full scan is a linear walk over the
+//! entries, and it visits them in insertion order.
+//!
+//! Erasing leaves a hole in the entries (skipped by the scans) and a tombstone in the index.
+//! Both are dropped when the index is rebuilt, which happens once the used slots of the index
+//! (entries and tombstones) fill 2/3 of it. A lookup stops at the first empty slot, so the
+//! tombstones must count: insert/erase churn would otherwise leave no empty slot at all.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class CompactHashTbl {
+       public:
+        using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in hash table.
+
+        //! \brief Constructs the hash table with room for some elements.
+        //! \param n_elements Number of elements that fit before the first rebuild.
+        CompactHashTbl(size_t n_elements = 0) : m_count{0} { reset(capacity_for(n_elements)); }
+
+        //! \brief Constructs the hash table with values from a std::initializer_list.
+        //! \param ilist List of elements.
+        CompactHashTbl(std::initializer_list<Entry> ilist) : CompactHashTbl(ilist.size()) {
+                for (auto& value : ilist) this->insert(value.m_key, value.m_data);
+        }
+
+        //! \brief Access or insert element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return Data associated to the key.
+        DataType& operator[](const KeyType& key_);
+
+        //! \brief Inserts data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if the key was not in the table, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_);
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                size_t slot = find(key_, hash_of(key_));
+                if (slot == NO_SLOT) return false;
+
+                data_item_ = m_entries[index_at(slot)].m_data;
+                return true;
+        }
+
+        //! \brief Access element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \throw std::out_of_range
+        //! \return Data associated to the key.
+        DataType& at(const KeyType& key_) {
+                size_t slot = find(key_, hash_of(key_));
+                if (slot == NO_SLOT) throw std::out_of_range("error: index is out of range!\n");
+
+                return m_entries[index_at(slot)].m_data;
+        }
+
+        //! \brief Clears the contents.
+        inline void clear(void) {
+                m_count = 0;
+                reset(capacity_for(0));
+        }
+
+        //! \brief Checks whether the hash table is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_count == 0; }
+
+        //! \brief Returns the number of elements
+        //! \return Number of elements.
+        inline size_t size(void) const { return m_count; }
+
+        //! \brief Returns the size in bytes of a slot of the index (1, 2 or 4).
+        inline size_t index_width(void) const { return m_width; }
+
+        //! \brief Applies a function to every entry of the table, in insertion order.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                for (size_t i = 0; i < m_entries.size(); i++) {
+                        if (!m_erased[i]) fn(m_entries[i].m_key, m_entries[i].m_data);
+                }
+        }
+
+        //! \brief Extractor operator.
+        friend std::ostream& operator<<(std::ostream& os, const CompactHashTbl& table) {
+                table.for_each(
+                    [&](const KeyType&, const DataType& data) { os << ">>>" << data << "\n\n"; });
+
+                return os;
+        }
+
+       private:
+        static const size_t MIN_CAPACITY = 8;      //!< Smallest index (a power of two).
+        static const size_t NO_SLOT = size_t(-1);  //!< Result of an unsuccessful search.
+
+        size_t m_count;                //!< Number of elements in the table.
+        size_t m_used;                 //!< Slots of the index not EMPTY (entries and DUMMY).
+        size_t m_width;                //!< Bytes per slot of the index.
+        size_t m_mask;                 //!< Number of slots of the index minus one.
+        std::vector<uint8_t> m_index;  //!< Slot numbers of the entries, or EMPTY/DUMMY.
+        std::vector<Entry> m_entries;  //!< Entries, in insertion order.
+        std::vector<size_t> m_hashes;  //!< Hash of each entry, so rebuilds do not rehash.
+        std::vector<bool> m_erased;    //!< True for the holes left by erase.
+
+        // \brief Slot value of a slot never used.
+        inline size_t empty_slot(void) const { return (size_t(1) << (8 * m_width)) - 1; }
+
+        // \brief Slot value of an erased entry (a tombstone).
+        inline size_t dummy_slot(void) const { return empty_slot() - 1; }
+
+        // \brief Number of used slots (tombstones included) before the index is rebuilt.
+        inline size_t usable(void) const { return (m_mask + 1) * 2 / 3; }
+
+        // \brief Smallest power of two index holding n entries within the 2/3 load.
+        static size_t capacity_for(size_t n) {
+                size_t capacity = MIN_CAPACITY;
+                while (capacity * 2 / 3 < n) capacity *= 2;
+                return capacity;
+        }
+
+        // \brief Hash of a key.
+        static size_t hash_of(const KeyType& key_) {
+                KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+                return hashFunc(key_);
+        }
+
+        // \brief Returns the value of a slot of the index.
+        inline size_t index_at(size_t slot) const {
+                switch (m_width) {
+                        case 1:
+                                return m_index[slot];
+                        case 2: {
+                                uint16_t v;
+                                std::memcpy(&v, &m_index[slot * 2], sizeof v);
+                                return v;
+                        }
+                        default: {
+                                uint32_t v;
+                                std::memcpy(&v, &m_index[slot * 4], sizeof v);
+                                return v;
+                        }
+                }
+        }
+
+        // \brief Sets the value of a slot of the index.
+        inline void set_index(size_t slot, size_t value) {
+                switch (m_width) {
+                        case 1:
+                                m_index[slot] = uint8_t(value);
+                                break;
+                        case 2: {
+                                uint16_t v = uint16_t(value);
+                                std::memcpy(&m_index[slot * 2], &v, sizeof v);
+                                break;
+                        }
+                        default: {
+                                uint32_t v = uint32_t(value);
+                                std::memcpy(&m_index[slot * 4], &v, sizeof v);
+                                break;
+                        }
+                }
+        }
+
+        // \brief Returns the slot of the index holding a key, or NO_SLOT.
+        size_t find(const KeyType& key_, size_t hash) const;
+
+        // \brief Returns the first slot where a new key with this hash can go.
+        size_t free_slot(size_t hash) const;
+
+        // \brief Appends an entry known not to be in the table.
+        // \return Position of the entry.
+        size_t append(const KeyType& key_, const DataType& data_item_, size_t hash);
+
+        // \brief Empties the index and the entries, with a given number of slots.
+        void reset(size_t capacity);
+
+        // \brief Drops the holes and rebuilds the index for the live entries.
+        void rebuild(void);
+};
+
+// Probe sequence of the CPython dict: i = 5 * i + 1 + perturb, with perturb taking the high bits
+// of the hash. It visits every slot, and the high bits break the clusters of linear probing.
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::find(const KeyType& key_,
+                                                                   size_t hash) const {
+        KeyEqual equalFunc;  // Instantiate the "functor" for the equal to test.
+        size_t perturb = hash;
+        size_t slot = hash & m_mask;
+
+        for (;;) {
+                size_t ix = index_at(slot);
+                if (ix == empty_slot()) return NO_SLOT;
+                if (ix != dummy_slot() && m_hashes[ix] == hash &&
+                    true == equalFunc(m_entries[ix].m_key, key_)) {
+                        return slot;
+                }
+
+                perturb >>= 5;
+                slot = (slot * 5 + 1 + perturb) & m_mask;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::free_slot(size_t hash) const {
+        size_t perturb = hash;
+        size_t slot = hash & m_mask;
+
+        // Tombstones are reused, so a slot is always found: the load is below 2/3.
+        for (;;) {
+                size_t ix = index_at(slot);
+                if (ix == empty_slot() || ix == dummy_slot()) return slot;
+
+                perturb >>= 5;
+                slot = (slot * 5 + 1 + perturb) & m_mask;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::append(const KeyType& key_,
+                                                                     const DataType& data_item_,
+                                                                     size_t hash) {
+        // Each entry, live or hole, holds a slot, so the entries never outnumber the used slots.
+        if (m_used >= usable()) rebuild();
+
+        size_t ix = m_entries.size();
+        size_t slot = free_slot(hash);
+        if (index_at(slot) == empty_slot()) m_used++;
+        set_index(slot, ix);
+        m_entries.push_back(Entry(key_, data_item_));
+        m_hashes.push_back(hash);
+        m_erased.push_back(false);
+        m_count++;
+
+        return ix;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+DataType& CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyType& key_) {
+        size_t hash = hash_of(key_);
+        size_t slot = find(key_, hash);
+        if (slot != NO_SLOT) return m_entries[index_at(slot)].m_data;
+
+        // Create new entry if not located.
+        return m_entries[append(key_, DataType(), hash)].m_data;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
+                                                                  const DataType& data_item_) {
+        size_t hash = hash_of(key_);
+        size_t slot = find(key_, hash);
+        if (slot != NO_SLOT) {
+                m_entries[index_at(slot)].m_data = data_item_;
+                return false;
+        }
+
+        append(key_, data_item_, hash);
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+        size_t slot = find(key_, hash_of(key_));
+        if (slot == NO_SLOT) return false;
+
+        size_t ix = index_at(slot);
+        set_index(slot, dummy_slot());
+        m_erased[ix] = true;
+        m_count--;
+
+        // Trailing holes can be dropped at once: nothing is after them.
+        while (!m_entries.empty() && m_erased.back()) {
+                m_entries.pop_back();
+                m_hashes.pop_back();
+                m_erased.pop_back();
+        }
+
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::reset(size_t capacity) {
+        // The two largest values of a slot are EMPTY and DUMMY; entries are numbered below them.
+        m_width = capacity * 2 / 3 < 0xfe ? 1 : capacity * 2 / 3 < 0xfffe ? 2 : 4;
+        m_mask = capacity - 1;
+        m_used = 0;
+        m_index.assign(capacity * m_width, 0xff);  // Every slot EMPTY.
+
+        m_entries.clear();
+        m_hashes.clear();
+        m_erased.clear();
+        m_entries.reserve(usable());
+        m_hashes.reserve(usable());
+        m_erased.reserve(usable());
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void CompactHashTbl<KeyType, DataType, KeyHash, KeyEqual>::rebuild() {
+        std::vector<Entry> entries;
+        std::vector<size_t> hashes;
+        entries.swap(m_entries);
+        hashes.swap(m_hashes);
+        std::vector<bool> erased(std::move(m_erased));
+
+        // Grow with the live entries only: a table emptied by erase shrinks back.
+        reset(capacity_for(m_count * 3 / 2 + 1));
+
+        for (size_t i = 0; i < entries.size(); i++) {
+                if (erased[i]) continue;
+
+                set_index(free_slot(hashes[i]), m_entries.size());
+                m_entries.push_back(entries[i]);
+                m_hashes.push_back(hashes[i]);
+                m_erased.push_back(false);
+        }
+        m_used = m_entries.size();
+}
+
+}  // namespace ac
+
+#endif
@@ -0,0 +1,400 @@
+#ifndef COW_HASHTBL_H
+#define COW_HASHTBL_H
+
+#include <array>         // std::array.
+#include <atomic>        // std::atomic.
+#include <forward_list>  // std::forward_list.
+#include <functional>    // std::hash, std::equal_to.
+#include <stdexcept>     // std::out_of_range
+#include <utility>       // std::forward, std::swap.
+#include <vector>        // std::vector.
+#include "hashtbl.h"     // ac::HashEntry, ac::detail::next_prime.
+
+namespace ac {
+
+namespace detail {
+
+//! \brief Reference counted pointer whose unique() can decide to write in place.
+//!
+//! std::shared_ptr::use_count() is a relaxed load: seeing 1 does not order the reads the other
+//! owners made before releasing the object, possibly on other threads, before the writes that
+//! follow. Here a release drops the count with release semantics and unique() reads it with
+//! acquire semantics, so once unique() returns true every other owner is done with the object.
+template <typename T>
+class CowPtr {
+       public:
+        //! \brief Constructs a null pointer.
+        CowPtr() noexcept : m_node{nullptr} {}
+
+        //! \brief Constructs a new object, owned by the pointer alone.
+        //! \param args Arguments of the constructor of T.
+        template <typename... Args>
+        static CowPtr make(Args&&... args) {
+                CowPtr ptr;
+                ptr.m_node = new Node(std::forward<Args>(args)...);
+                return ptr;
+        }
+
+        CowPtr(const CowPtr& other) noexcept : m_node{other.m_node} {
+                // A new owner comes from an existing one: no ordering is needed.
+                if (m_node != nullptr) m_node->m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        CowPtr(CowPtr&& other) noexcept : m_node{other.m_node} { other.m_node = nullptr; }
+
+        CowPtr& operator=(CowPtr other) noexcept {
+                std::swap(m_node, other.m_node);
+                return *this;
+        }
+
+        ~CowPtr() {
+                if (m_node != nullptr &&
+                    m_node->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        delete m_node;
+                }
+        }
+
+        //! \brief Checks whether no other pointer owns the object (the pointer must not be null).
+        //! \return True if the object can be modified in place, false otherwise.
+        bool unique(void) const { return m_node->m_refs.load(std::memory_order_acquire) == 1; }
+
+        //! \brief Returns the object, or nullptr. A const pointer gives a const object.
+        T* get(void) { return m_node == nullptr ? nullptr : &m_node->m_value; }
+        const T* get(void) const { return m_node == nullptr ? nullptr : &m_node->m_value; }
+
+        T& operator*(void) { return m_node->m_value; }
+        const T& operator*(void) const { return m_node->m_value; }
+        T* operator->(void) { return &m_node->m_value; }
+        const T* operator->(void) const { return &m_node->m_value; }
+        explicit operator bool(void) const { return m_node != nullptr; }
+
+       private:
+        //! \brief Object with its reference count.
+        struct Node {
+                template <typename... Args>
+                explicit Node(Args&&... args) : m_refs{1}, m_value(std::forward<Args>(args)...) {}
+
+                std::atomic<size_t> m_refs;  //!< Number of pointers owning the object.
+                T m_value;                   //!< The object.
+        };
+
+        Node* m_node;  //!< Object owned, or nullptr.
+};
+
+}  // namespace detail
+
+//! \brief Hash table with O(1) immutable snapshots.
+//!
+//! Buckets are shared between the table and its snapshots and copied on the first write after a
+//! snapshot (copy-on-write). The bucket directory is split in pages, so a write after a snapshot
+//! copies the page pointers, one page of bucket pointers and the bucket it changes; the extra
+//! memory grows with the number of buckets modified since the snapshot. Old buckets are freed by
+//! reference counting once the last snapshot that sees them is destroyed. The counts order the
+//! reads of a snapshot released on another thread before the writes that reuse its buckets.
+//!
+//! The table itself is not thread-safe: writes and snapshot() must be serialized by the caller.
+//! Snapshots are immutable and may be read from any number of threads while the writer goes on.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class CowHashTbl {
+       public:
+        using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in hash table.
+
+       private:
+        static const short DEFAULT_SIZE = 11;  //!< Hash table’s default size.
+        static const size_t PAGE_SIZE = 64;    //!< Buckets per page of the directory.
+
+        using Bucket = std::forward_list<Entry>;                     //!< Collision list.
+        using Page = std::array<detail::CowPtr<Bucket>, PAGE_SIZE>;  //!< Page of buckets.
+
+        //! \brief Bucket directory, shared with the snapshots.
+        struct Table {
+                size_t m_size;                               //!< Hash table size.
+                size_t m_count;                              //!< Number of elements in the table.
+                std::vector<detail::CowPtr<Page>> m_pages;  //!< Pages of buckets (or null).
+
+                explicit Table(size_t size_)
+                    : m_size{size_}, m_count{0}, m_pages((size_ + PAGE_SIZE - 1) / PAGE_SIZE) {}
+
+                // \brief Returns the bucket at addr, or nullptr if it is empty.
+                const Bucket* bucket(size_t addr) const {
+                        const auto& page = m_pages[addr / PAGE_SIZE];
+                        return page ? (*page)[addr % PAGE_SIZE].get() : nullptr;
+                }
+
+                // \brief Locates the entry of a key.
+                const Entry* find(const KeyType& key_) const {
+                        KeyHash hashFunc;                    // "Functor" for primary hash.
+                        KeyEqual equalFunc;                  // "Functor" for the equal to test.
+                        auto addr(hashFunc(key_) % m_size);  // Apply double hashing method.
+
+                        const Bucket* list = bucket(addr);
+                        if (list == nullptr) return nullptr;
+
+                        for (auto it = list->begin(); it != list->end(); it++) {
+                                //  Comparing keys inside the collision list.
+                                if (true == equalFunc((*it).m_key, key_)) return &(*it);
+                        }
+
+                        return nullptr;
+                }
+
+                // \brief Applies fn(key, data) to every entry.
+                template <typename Function>
+                void for_each(Function fn) const {
+                        for (const auto& page : m_pages) {
+                                if (!page) continue;
+                                for (const auto& list : *page) {
+                                        if (!list) continue;
+                                        for (const auto& e : *list) fn(e.m_key, e.m_data);
+                                }
+                        }
+                }
+        };
+
+       public:
+        //! \brief Immutable view of the table at the time snapshot() was called.
+        class Snapshot {
+               public:
+                //! \brief Constructs an empty snapshot.
+                Snapshot() : m_table{detail::CowPtr<Table>::make(size_t(1))} {}
+
+                //! \brief Retrieves data associated to a key.
+                //! \param key_ Key associated to data.
+                //! \param data_item_ Store the data associated to key.
+                //! \return True if retrieved, false otherwise.
+                bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                        const Entry* entry = m_table->find(key_);
+                        if (entry == nullptr) return false;
+
+                        data_item_ = entry->m_data;
+                        return true;
+                }
+
+                //! \brief Access element associated to a key.
+                //! \param key_ Key associated to data.
+                //! \throw std::out_of_range
+                //! \return Data associated to the key.
+                const DataType& at(const KeyType& key_) const {
+                        const Entry* entry = m_table->find(key_);
+                        if (entry == nullptr) {
+                                throw std::out_of_range("error: index is out of range!\n");
+                        }
+
+                        return entry->m_data;
+                }
+
+                //! \brief Checks whether the snapshot is empty
+                inline bool empty(void) const { return m_table->m_count == 0; }
+
+                //! \brief Returns the number of elements
+                inline size_t size(void) const { return m_table->m_count; }
+
+                //! \brief Applies a function to every entry of the snapshot.
+                //! \param fn Function called as fn(key, data) for each entry.
+                template <typename Function>
+                void for_each(Function fn) const {
+                        m_table->for_each(fn);
+                }
+
+               private:
+                friend class CowHashTbl;
+
+                explicit Snapshot(const detail::CowPtr<Table>& table) : m_table{table} {}
+
+                detail::CowPtr<Table> m_table;  //!< Directory seen by the snapshot (read only).
+        };
+
+        //! \brief Constructs the hash table with a specific size.
+        //! \param tbl_size_ Size of the hash table (rounded up to the next prime).
+        CowHashTbl(size_t tbl_size_ = DEFAULT_SIZE)
+            : m_table{detail::CowPtr<Table>::make(detail::next_prime(tbl_size_))} {}
+
+        //! \brief Returns an immutable snapshot of the table, in O(1).
+        //! \return Snapshot sharing every bucket with the table.
+        Snapshot snapshot(void) const { return Snapshot(m_table); }
+
+        //! \brief Access or insert element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return Data associated to the key.
+        DataType& operator[](const KeyType& key_);
+
+        //! \brief Inserts data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if not collision ocurred, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_);
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                const Entry* entry = m_table->find(key_);
+                if (entry == nullptr) return false;
+
+                data_item_ = entry->m_data;
+                return true;
+        }
+
+        //! \brief Clears the contents. Snapshots keep their own contents.
+        inline void clear(void) { m_table = detail::CowPtr<Table>::make(size_t(DEFAULT_SIZE)); }
+
+        //! \brief Checks whether the hash table is empty
+        inline bool empty(void) const { return m_table->m_count == 0; }
+
+        //! \brief Returns the number of elements
+        inline size_t size(void) const { return m_table->m_count; }
+
+        //! \brief Returns the number of buckets.
+        //! \return Number of buckets.
+        inline size_t bucket_count(void) const { return m_table->m_size; }
+
+        //! \brief Applies a function to every entry of the table.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                m_table->for_each(fn);
+        }
+
+       private:
+        const float DEFAULT_LOAD_FACTOR = 1;  //!< Hash table’s default load factor.
+        detail::CowPtr<Table> m_table;        //!< Current directory.
+
+        // \brief Makes the directory, the page and the bucket at addr private to the table.
+        // \return The bucket, ready to be modified.
+        Bucket& writable_bucket(size_t addr);
+
+        // \brief Change Hash table size if load factor λ > 1.0.
+        void rehash(void);
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+typename CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::Bucket&
+CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::writable_bucket(size_t addr) {
+        // Only the table sees a unique object: it can be changed in place.
+        if (!m_table.unique()) m_table = detail::CowPtr<Table>::make(*m_table);
+
+        auto& page = m_table->m_pages[addr / PAGE_SIZE];
+        if (!page) {
+                page = detail::CowPtr<Page>::make();
+        } else if (!page.unique()) {
+                page = detail::CowPtr<Page>::make(*page);
+        }
+
+        auto& list = (*page)[addr % PAGE_SIZE];
+        if (!list) {
+                list = detail::CowPtr<Bucket>::make();
+        } else if (!list.unique()) {
+                list = detail::CowPtr<Bucket>::make(*list);
+        }
+
+        return *list;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+DataType& CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyType& key_) {
+        // Grow as insert() does, but before the new entry: a rehash would move it.
+        if (m_table->find(key_) == nullptr &&
+            float(m_table->m_count + 1) / m_table->m_size >= DEFAULT_LOAD_FACTOR) {
+                rehash();
+        }
+
+        KeyHash hashFunc;                             // "Functor" for primary hash.
+        KeyEqual equalFunc;                           // "Functor" for the equal to test.
+        auto addr(hashFunc(key_) % m_table->m_size);  // Apply double hashing method.
+
+        // The reference may be used to write, so the bucket must be private.
+        Bucket& list = writable_bucket(addr);
+        for (auto it = list.begin(); it != list.end(); it++) {
+                //  Comparing keys inside the collision list.
+                if (true == equalFunc((*it).m_key, key_)) {
+                        return (*it).m_data;
+                }
+        }
+        m_table->m_count++;  // Update the number of elements in the list.
+
+        // Create new entry if not located.
+        list.push_front(Entry(key_, DataType()));
+
+        return list.front().m_data;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
+                                                              const DataType& data_item_) {
+        KeyHash hashFunc;                             // "Functor" for primary hash.
+        KeyEqual equalFunc;                           // "Functor" for the equal to test.
+        auto addr(hashFunc(key_) % m_table->m_size);  // Apply double hashing method.
+
+        Bucket& list = writable_bucket(addr);
+        for (auto it = list.begin(); it != list.end(); it++) {
+                //  Comparing keys inside the collision list.
+                if (true == equalFunc((*it).m_key, key_)) {
+                        (*it).m_data = data_item_;
+                        return false;
+                }
+        }
+
+        list.push_front(Entry(key_, data_item_));
+        m_table->m_count++;
+
+        if (float(m_table->m_count) / m_table->m_size >= DEFAULT_LOAD_FACTOR) {
+                rehash();
+        }
+
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+        // Look before writing, so that a miss does not copy anything.
+        if (m_table->find(key_) == nullptr) return false;
+
+        KeyHash hashFunc;                             // "Functor" for primary hash.
+        KeyEqual equalFunc;                           // "Functor" for the equal to test.
+        auto addr(hashFunc(key_) % m_table->m_size);  // Apply double hashing method.
+
+        Bucket& list = writable_bucket(addr);
+        auto it = list.begin();
+        auto before_it = list.before_begin();
+        for (; it != list.end(); it++, before_it++) {
+                //  Comparing keys inside the collision list.
+                if (true == equalFunc((*it).m_key, key_)) {
+                        list.erase_after(before_it);
+                        m_table->m_count--;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>::rehash() {
+        // Snapshots keep the old directory; the new one shares nothing with it.
+        auto new_table = detail::CowPtr<Table>::make(detail::next_prime(m_table->m_size * 2));
+        KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+
+        m_table->for_each([&](const KeyType& k, const DataType& d) {
+                auto addr(hashFunc(k) % new_table->m_size);
+                auto& page = new_table->m_pages[addr / PAGE_SIZE];
+                if (!page) page = detail::CowPtr<Page>::make();
+                auto& list = (*page)[addr % PAGE_SIZE];
+                if (!list) list = detail::CowPtr<Bucket>::make();
+
+                list->push_front(Entry(k, d));
+                new_table->m_count++;
+        });
+
+        m_table = new_table;
+}
+
+}  // namespace ac
+
+#endif
@@ -0,0 +1,604 @@
+#ifndef DURABLE_HASHTBL_H
+#define DURABLE_HASHTBL_H
+
+#include <fcntl.h>   // open.
+#include <unistd.h>  // write, fdatasync, close, unlink, lseek, ftruncate.
+
+#include <cerrno>         // errno.
+#include <cstdint>        // uint8_t, uint32_t, uint64_t.
+#include <cstdio>         // std::rename.
+#include <cstring>        // std::memcpy, std::strerror.
+#include <exception>      // std::exception_ptr.
+#include <functional>     // std::hash, std::equal_to.
+#include <mutex>          // std::mutex.
+#include <stdexcept>      // std::runtime_error.
+#include <string>         // std::string.
+#include <thread>         // std::thread.
+#include <tuple>          // std::tuple.
+#include <type_traits>    // std::enable_if, std::is_arithmetic.
+#include <vector>         // std::vector.
+#include "cow_hashtbl.h"  // ac::CowHashTbl.
+
+namespace ac {
+
+//! \brief Binary encoding of a type, used by the log and the snapshots.
+//!
+//! A specialization provides write(out, value), which appends the value to out, and
+//! read(first, last, value), which decodes it and advances first (false if malformed).
+template <typename T, typename Enable = void>
+struct Codec;
+
+//! \brief Arithmetic types are stored as their bytes.
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+        static void write(std::string& out, const T& value) {
+                out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        static bool read(const char*& first, const char* last, T& value) {
+                if (size_t(last - first) < sizeof(T)) return false;
+                std::memcpy(&value, first, sizeof(T));
+                first += sizeof(T);
+                return true;
+        }
+};
+
+//! \brief Strings are stored as their length followed by their characters.
+template <>
+struct Codec<std::string> {
+        static void write(std::string& out, const std::string& value) {
+                Codec<uint32_t>::write(out, uint32_t(value.size()));
+                out.append(value);
+        }
+
+        static bool read(const char*& first, const char* last, std::string& value) {
+                uint32_t length;
+                if (!Codec<uint32_t>::read(first, last, length)) return false;
+                if (size_t(last - first) < length) return false;
+                value.assign(first, length);
+                first += length;
+                return true;
+        }
+};
+
+namespace detail {
+
+// \brief Encodes the elements [I, N) of a tuple.
+template <size_t I, size_t N>
+struct TupleCodec {
+        template <typename Tuple>
+        static void write(std::string& out, const Tuple& value) {
+                using T = typename std::tuple_element<I, Tuple>::type;
+                Codec<T>::write(out, std::get<I>(value));
+                TupleCodec<I + 1, N>::write(out, value);
+        }
+
+        template <typename Tuple>
+        static bool read(const char*& first, const char* last, Tuple& value) {
+                using T = typename std::tuple_element<I, Tuple>::type;
+                return Codec<T>::read(first, last, std::get<I>(value)) &&
+                       TupleCodec<I + 1, N>::read(first, last, value);
+        }
+};
+
+template <size_t N>
+struct TupleCodec<N, N> {
+        template <typename Tuple>
+        static void write(std::string&, const Tuple&) {}
+
+        template <typename Tuple>
+        static bool read(const char*&, const char*, Tuple&) {
+                return true;
+        }
+};
+
+// \brief CRC-32 (IEEE) of a buffer, to detect torn or corrupted log records.
+inline uint32_t crc32(const char* data, size_t length) {
+        static const std::vector<uint32_t> table = []() {
+                std::vector<uint32_t> t(256);
+                for (uint32_t i = 0; i < 256; i++) {
+                        uint32_t c = i;
+                        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                        t[i] = c;
+                }
+                return t;
+        }();
+
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = 0; i < length; i++) {
+                crc = table[(crc ^ uint8_t(data[i])) & 0xff] ^ (crc >> 8);
+        }
+
+        return crc ^ 0xffffffffu;
+}
+
+// \brief Throws the last system error.
+inline void throw_errno(const std::string& what) {
+        throw std::runtime_error("error: " + what + ": " + std::strerror(errno) + "\n");
+}
+
+// \brief Writes the whole buffer to a file descriptor.
+inline void write_all(int fd, const char* data, size_t length) {
+        while (length > 0) {
+                ssize_t n = ::write(fd, data, length);
+                if (n < 0) {
+                        if (errno == EINTR) continue;
+                        throw_errno("write");
+                }
+                data += n;
+                length -= n;
+        }
+}
+
+// \brief Reads a whole file. Returns false if it does not exist.
+inline bool read_file(const std::string& path, std::string& contents) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+                if (errno == ENOENT) return false;
+                throw_errno("open " + path);
+        }
+
+        contents.clear();
+        char buffer[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) != 0) {
+                if (n < 0) {
+                        if (errno == EINTR) continue;
+                        ::close(fd);
+                        throw_errno("read " + path);
+                }
+                contents.append(buffer, n);
+        }
+        ::close(fd);
+
+        return true;
+}
+
+// \brief Flushes the directory of a path, so that renames and creations are durable.
+inline void sync_parent(const std::string& path) {
+        auto slash = path.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd >= 0) {
+                ::fsync(fd);
+                ::close(fd);
+        }
+}
+
+}  // namespace detail
+
+//! \brief Tuples are stored element by element.
+template <typename... Types>
+struct Codec<std::tuple<Types...>> {
+        static void write(std::string& out, const std::tuple<Types...>& value) {
+                detail::TupleCodec<0, sizeof...(Types)>::write(out, value);
+        }
+
+        static bool read(const char*& first, const char* last, std::tuple<Types...>& value) {
+                return detail::TupleCodec<0, sizeof...(Types)>::read(first, last, value);
+        }
+};
+
+//! \brief Hash table whose changes are kept in a write-ahead log.
+//!
+//! Every insert(), erase() and write through operator[] appends a record to the current log
+//! segment (base.log.N). Records are buffered and written with a single fdatasync() every
+//! group_size records (group commit); sync() forces it. On construction the table loads the last
+//! snapshot (base.snap) and replays the log segments written after it, ignoring a torn last record.
+//!
+//! compact() folds the log into a new snapshot: it switches to a new log segment, takes an O(1)
+//! snapshot of the table and writes it from a background thread while writers go on. When the
+//! snapshot is durable, the segments it covers are deleted.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>, typename KeyCodec = Codec<KeyType>,
+          typename DataCodec = Codec<DataType>>
+class DurableHashTbl {
+       public:
+        using Table = CowHashTbl<KeyType, DataType, KeyHash, KeyEqual>;  //!< In-memory table.
+
+        //! \brief Write-through reference returned by operator[].
+        class Reference {
+               public:
+                //! \brief Reads the data.
+                operator DataType() const {
+                        DataType data;
+                        m_owner->m_table.retrieve(m_key, data);
+                        return data;
+                }
+
+                //! \brief Writes and logs the data.
+                Reference& operator=(const DataType& data_item_) {
+                        m_owner->insert(m_key, data_item_);
+                        return *this;
+                }
+
+               private:
+                friend class DurableHashTbl;
+
+                Reference(DurableHashTbl* owner, const KeyType& key_)
+                    : m_owner{owner}, m_key{key_} {}
+
+                DurableHashTbl* m_owner;  //!< Table of the data.
+                KeyType m_key;            //!< Key associated to data.
+        };
+
+        //! \brief Opens (or creates) a durable table and recovers its contents.
+        //! \param path Base path of the files (base.snap and base.log.N).
+        //! \param group_size Records written per fdatasync().
+        //! \throw std::runtime_error
+        explicit DurableHashTbl(const std::string& path, size_t group_size = DEFAULT_GROUP_SIZE);
+
+        //! \brief Flushes the log and waits for a running compaction.
+        virtual ~DurableHashTbl();
+
+        DurableHashTbl(const DurableHashTbl&) = delete;
+        DurableHashTbl& operator=(const DurableHashTbl&) = delete;
+
+        //! \brief Access or insert element associated to a key; writes are logged.
+        //! \param key_ Key associated to data.
+        //! \return Reference to the data associated to the key.
+        Reference operator[](const KeyType& key_) {
+                DataType data;
+                if (!m_table.retrieve(key_, data)) insert(key_, DataType());
+
+                return Reference(this, key_);
+        }
+
+        //! \brief Inserts data associated to a key, and logs it.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if not collision ocurred, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_) {
+                log_insert(key_, data_item_);
+                return m_table.insert(key_, data_item_);
+        }
+
+        //! \brief Erases data associated to a key, and logs it.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_) {
+                if (!m_table.erase(key_)) return false;
+
+                log_erase(key_);
+                return true;
+        }
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                return m_table.retrieve(key_, data_item_);
+        }
+
+        //! \brief Checks whether the hash table is empty
+        inline bool empty(void) const { return m_table.empty(); }
+
+        //! \brief Returns the number of elements
+        inline size_t size(void) const { return m_table.size(); }
+
+        //! \brief Applies a function to every entry of the table.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                m_table.for_each(fn);
+        }
+
+        //! \brief Writes the pending records and waits until they are on disk. Until then, a crash
+        //! loses them.
+        //! \throw std::runtime_error if the write fails; the records stay pending for a retry.
+        void sync(void);
+
+        //! \brief Starts folding the log into a new snapshot, in a background thread.
+        //! \return False if a compaction is already running.
+        //! \throw std::runtime_error if the log cannot be synced or switched; nothing is started.
+        bool compact(void);
+
+        //! \brief Waits for the running compaction, if any.
+        //! \throw std::runtime_error if it failed.
+        void wait_compaction(void);
+
+       private:
+        static const size_t DEFAULT_GROUP_SIZE = 64;             //!< Default records per fsync.
+        static const uint64_t SNAP_MAGIC = 0x31504e534c4157ULL;  //!< "WALSNP1".
+        enum Op : uint8_t { OP_INSERT = 1, OP_ERASE = 2 };       //!< Kind of a log record.
+
+        std::string m_path;                  //!< Base path of the files.
+        size_t m_group_size;                 //!< Records written per fdatasync().
+        Table m_table;                       //!< The table itself.
+        int m_log_fd;                        //!< Current log segment.
+        uint64_t m_log_seq;                  //!< Number of the current log segment.
+        std::string m_pending;               //!< Records not written yet.
+        size_t m_n_pending;                  //!< Number of records in m_pending.
+        std::thread m_compactor;             //!< Background compaction.
+        std::mutex m_compact_mutex;          //!< Protects m_compacting and m_compact_error.
+        bool m_compacting;                   //!< True while the compaction runs.
+        std::exception_ptr m_compact_error;  //!< Error of the last compaction.
+
+        // \brief Name of a log segment.
+        std::string log_name(uint64_t seq) const { return m_path + ".log." + std::to_string(seq); }
+
+        // \brief Appends a record to the pending group, and commits the group if it is full.
+        void append(Op op, const std::string& payload);
+
+        // \brief Logs an insertion.
+        void log_insert(const KeyType& key_, const DataType& data_item_) {
+                std::string payload;
+                KeyCodec::write(payload, key_);
+                DataCodec::write(payload, data_item_);
+                append(OP_INSERT, payload);
+        }
+
+        // \brief Logs an erasure.
+        void log_erase(const KeyType& key_) {
+                std::string payload;
+                KeyCodec::write(payload, key_);
+                append(OP_ERASE, payload);
+        }
+
+        // \brief Opens a new log segment.
+        void open_log(uint64_t seq);
+
+        // \brief Loads the snapshot and replays the log.
+        void recover(void);
+
+        // \brief Replays the records of a log segment; truncates a torn tail.
+        void replay(uint64_t seq);
+
+        // \brief Writes a snapshot covering the log segments before seq, then drops them.
+        void write_snapshot(typename Table::Snapshot snap, uint64_t seq);
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::DurableHashTbl(
+    const std::string& path, size_t group_size)
+    : m_path{path},
+      m_group_size{group_size == 0 ? 1 : group_size},
+      m_log_fd{-1},
+      m_log_seq{0},
+      m_n_pending{0},
+      m_compacting{false} {
+        recover();
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::~DurableHashTbl() {
+        try {
+                sync();
+        } catch (...) {
+                // Destructors must not throw; the records are lost like in a crash.
+        }
+        if (m_compactor.joinable()) m_compactor.join();
+        if (m_log_fd >= 0) ::close(m_log_fd);
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::append(
+    Op op, const std::string& payload) {
+        // Record: length (u32), crc (u32) of op + payload, op (u8), payload.
+        std::string body(1, char(op));
+        body += payload;
+        Codec<uint32_t>::write(m_pending, uint32_t(body.size()));
+        Codec<uint32_t>::write(m_pending, detail::crc32(body.data(), body.size()));
+        m_pending += body;
+
+        if (++m_n_pending >= m_group_size) sync();
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::sync(void) {
+        if (m_pending.empty()) return;
+
+        off_t end = ::lseek(m_log_fd, 0, SEEK_END);
+        if (end < 0) detail::throw_errno("lseek " + log_name(m_log_seq));
+        try {
+                detail::write_all(m_log_fd, m_pending.data(), m_pending.size());
+                if (::fdatasync(m_log_fd) != 0) {
+                        detail::throw_errno("fdatasync " + log_name(m_log_seq));
+                }
+        } catch (...) {
+                // The group stays pending, for the next sync(). Part of it may be in the log, and
+                // the replay stops at a torn record: cut it off, or if that fails too, leave the
+                // segment behind (the replay goes on with the next one).
+                if (::ftruncate(m_log_fd, end) != 0) {
+                        try {
+                                open_log(m_log_seq + 1);
+                        } catch (...) {
+                        }
+                }
+                throw;
+        }
+
+        m_pending.clear();
+        m_n_pending = 0;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::open_log(
+    uint64_t seq) {
+        int fd = ::open(log_name(seq).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) detail::throw_errno("open " + log_name(seq));
+        detail::sync_parent(m_path);
+
+        if (m_log_fd >= 0) ::close(m_log_fd);
+        m_log_fd = fd;
+        m_log_seq = seq;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::recover(void) {
+        std::string contents;
+        uint64_t first_seq = 0;
+
+        // Snapshot: magic, first log segment not covered, count, then the entries.
+        if (detail::read_file(m_path + ".snap", contents)) {
+                const char* first = contents.data();
+                const char* last = first + contents.size();
+                uint64_t magic, count;
+                if (!Codec<uint64_t>::read(first, last, magic) || magic != SNAP_MAGIC ||
+                    !Codec<uint64_t>::read(first, last, first_seq) ||
+                    !Codec<uint64_t>::read(first, last, count)) {
+                        throw std::runtime_error("error: corrupted snapshot " + m_path + ".snap\n");
+                }
+
+                for (uint64_t i = 0; i < count; i++) {
+                        KeyType key;
+                        DataType data;
+                        if (!KeyCodec::read(first, last, key) ||
+                            !DataCodec::read(first, last, data)) {
+                                throw std::runtime_error("error: corrupted snapshot " + m_path +
+                                                         ".snap\n");
+                        }
+                        m_table.insert(key, data);
+                }
+        }
+
+        // Segments already folded into the snapshot may survive a crash during compaction.
+        for (uint64_t seq = first_seq; seq > 0 && ::unlink(log_name(seq - 1).c_str()) == 0; seq--) {
+        }
+
+        uint64_t seq = first_seq;
+        while (::access(log_name(seq).c_str(), F_OK) == 0) replay(seq++);
+
+        open_log(seq);
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::replay(
+    uint64_t seq) {
+        std::string contents;
+        detail::read_file(log_name(seq), contents);
+
+        const char* first = contents.data();
+        const char* last = first + contents.size();
+        while (first < last) {
+                const char* record = first;
+                uint32_t length, crc;
+                if (!Codec<uint32_t>::read(first, last, length) ||
+                    !Codec<uint32_t>::read(first, last, crc) || size_t(last - first) < length ||
+                    length == 0 || detail::crc32(first, length) != crc) {
+                        // Torn write of the last group: drop it, like it never happened.
+                        if (::truncate(log_name(seq).c_str(), record - contents.data()) != 0) {
+                                detail::throw_errno("truncate " + log_name(seq));
+                        }
+                        break;
+                }
+
+                const char* end = first + length;
+                Op op = Op(uint8_t(*first++));
+                KeyType key;
+                DataType data;
+                if (op == OP_INSERT && KeyCodec::read(first, end, key) &&
+                    DataCodec::read(first, end, data)) {
+                        m_table.insert(key, data);
+                } else if (op == OP_ERASE && KeyCodec::read(first, end, key)) {
+                        m_table.erase(key);
+                } else {
+                        throw std::runtime_error("error: corrupted log " + log_name(seq) + "\n");
+                }
+                first = end;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+bool DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::compact(void) {
+        {
+                std::lock_guard<std::mutex> lock(m_compact_mutex);
+                if (m_compacting) return false;
+                m_compacting = true;
+        }
+        if (m_compactor.joinable()) m_compactor.join();
+
+        try {
+                // Everything up to here goes to the snapshot; new records go to the next segment.
+                sync();
+                open_log(m_log_seq + 1);
+
+                auto snap = m_table.snapshot();
+                uint64_t seq = m_log_seq;
+                m_compactor = std::thread([this, snap, seq]() {
+                        std::exception_ptr error;
+                        try {
+                                write_snapshot(snap, seq);
+                        } catch (...) {
+                                error = std::current_exception();
+                        }
+
+                        std::lock_guard<std::mutex> lock(m_compact_mutex);
+                        m_compact_error = error;
+                        m_compacting = false;
+                });
+        } catch (...) {
+                // No thread is left to clear the flag: a later compact() must be able to start.
+                std::lock_guard<std::mutex> lock(m_compact_mutex);
+                m_compacting = false;
+                throw;
+        }
+
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::wait_compaction(
+    void) {
+        if (m_compactor.joinable()) m_compactor.join();
+
+        std::lock_guard<std::mutex> lock(m_compact_mutex);
+        if (m_compact_error) {
+                auto error = m_compact_error;
+                m_compact_error = nullptr;
+                std::rethrow_exception(error);
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class KeyCodec,
+          class DataCodec>
+void DurableHashTbl<KeyType, DataType, KeyHash, KeyEqual, KeyCodec, DataCodec>::write_snapshot(
+    typename Table::Snapshot snap, uint64_t seq) {
+        std::string tmp_name = m_path + ".snap.tmp";
+        int fd = ::open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) detail::throw_errno("open " + tmp_name);
+
+        try {
+                std::string buffer;
+                Codec<uint64_t>::write(buffer, uint64_t(SNAP_MAGIC));
+                Codec<uint64_t>::write(buffer, seq);
+                Codec<uint64_t>::write(buffer, snap.size());
+                snap.for_each([&](const KeyType& k, const DataType& d) {
+                        KeyCodec::write(buffer, k);
+                        DataCodec::write(buffer, d);
+                        if (buffer.size() >= (1 << 20)) {
+                                detail::write_all(fd, buffer.data(), buffer.size());
+                                buffer.clear();
+                        }
+                });
+                detail::write_all(fd, buffer.data(), buffer.size());
+                if (::fsync(fd) != 0) detail::throw_errno("fsync " + tmp_name);
+        } catch (...) {
+                ::close(fd);
+                throw;
+        }
+        ::close(fd);
+
+        // The rename makes the new snapshot visible atomically.
+        if (::rename(tmp_name.c_str(), (m_path + ".snap").c_str()) != 0) {
+                detail::throw_errno("rename " + tmp_name);
+        }
+        detail::sync_parent(m_path);
+
+        for (uint64_t s = seq; s > 0 && ::unlink(log_name(s - 1).c_str()) == 0; s--) {
+        }
+}
+
+}  // namespace ac
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef FLAT_HASHTBL_H
+#define FLAT_HASHTBL_H
+
+#include <cstdint>      // uint8_t.
+#include <cstring>      // std::memcpy, std::memcmp, std::memset.
+#include <functional>   // std::hash, std::equal_to.
+#include <iostream>     // std::ostream.
+#include <memory>       // std::unique_ptr.
+#include <stdexcept>    // std::out_of_range
+#include <type_traits>  // std::is_trivially_copyable, std::conditional, ...
+#include <utility>      // std::move, std::swap.
+#include "hashtbl.h"    // ac::HashTbl, ac::HashEntry, ac::detail::mix64.
+
+namespace ac {
+
+namespace detail {
+
+// \brief True if KeyEqual compares the bytes of the keys: std::equal_to on a type whose equal
+// values always have the same bytes (no padding, no floating point).
+template <typename KeyType, typename KeyEqual>
+struct is_bitwise_equal
+    : std::integral_constant<bool, std::is_same<KeyEqual, std::equal_to<KeyType>>::value &&
+                                       std::has_unique_object_representations<KeyType>::value> {};
+
+}  // namespace detail
+
+//! \brief Hash table for trivially copyable keys and data, stored in flat arrays.
+//!
+//! Entries live in one array of slots, with open addressing and linear probing, and one byte of
+//! control per slot (empty, erased, or 7 bits of the hash). Nothing is allocated per entry, so a
+//! copy of the table is two memcpy calls and a resize moves each entry with a plain byte copy,
+//! without calling any constructor. When the key equality is bitwise, keys are compared with
+//! memcmp, which compiles to integer compares.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class FlatHashTbl {
+       public:
+        using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in hash table.
+
+        static_assert(std::is_trivially_copyable<Entry>::value,
+                      "FlatHashTbl needs trivially copyable keys and data");
+
+        //! \brief Constructs the hash table with room for some elements.
+        //! \param n_elements Number of elements that fit before the first resize.
+        FlatHashTbl(size_t n_elements = 0) : m_count{0}, m_used{0} {
+                allocate(capacity_for(n_elements));
+        }
+
+        //! \brief Constructs the hash table with values from a std::initializer_list.
+        //! \param ilist List of elements.
+        FlatHashTbl(std::initializer_list<Entry> ilist) : FlatHashTbl(ilist.size()) {
+                for (auto& value : ilist) this->insert(value.m_key, value.m_data);
+        }
+
+        //! \brief Constructs a copy of a hash table given by argument, with two memcpy calls.
+        //! \param other Hash table to copy.
+        FlatHashTbl(const FlatHashTbl& other) : m_count{other.m_count}, m_used{other.m_used} {
+                allocate(other.m_capacity);
+                std::memcpy(m_ctrl.get(), other.m_ctrl.get(), m_capacity);
+                std::memcpy(m_slots.get(), other.m_slots.get(), m_capacity * sizeof(Slot));
+        }
+
+        //! \brief Assigns values from a hash table.
+        //! \param other Hash table to copy.
+        //! \return Object itself.
+        FlatHashTbl& operator=(const FlatHashTbl& other) {
+                if (this != &other) {
+                        FlatHashTbl copy(other);
+                        swap(copy);
+                }
+                return *this;
+        }
+
+        //! \brief Exchanges the contents with another table, in O(1).
+        //! \param other Table to exchange with.
+        void swap(FlatHashTbl& other) {
+                std::swap(m_capacity, other.m_capacity);
+                std::swap(m_count, other.m_count);
+                std::swap(m_used, other.m_used);
+                std::swap(m_ctrl, other.m_ctrl);
+                std::swap(m_slots, other.m_slots);
+        }
+
+        //! \brief Access or insert element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return Data associated to the key.
+        DataType& operator[](const KeyType& key_);
+
+        //! \brief Inserts data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if the key was not in the table, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_);
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                size_t slot = find(key_, hash_of(key_));
+                if (slot == NO_SLOT) return false;
+
+                data_item_ = entry(slot).m_data;
+                return true;
+        }
+
+        //! \brief Locates the data associated to a key, without copying it.
+        //! \param key_ Key associated to data.
+        //! \return Pointer to the data, or nullptr if the key is not in the table.
+        const DataType* find(const KeyType& key_) const {
+                size_t slot = find(key_, hash_of(key_));
+                return slot == NO_SLOT ? nullptr : &entry(slot).m_data;
+        }
+
+        //! \brief Access element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \throw std::out_of_range
+        //! \return Data associated to the key.
+        DataType& at(const KeyType& key_) {
+                size_t slot = find(key_, hash_of(key_));
+                if (slot == NO_SLOT) throw std::out_of_range("error: index is out of range!\n");
+
+                return entry(slot).m_data;
+        }
+
+        //! \brief Returns the number of elements hashed to the same bucket as a key, as
+        //! HashTbl::count() does: here, the elements whose probe starts at the same slot.
+        //! \param key_ Key associated to data.
+        //! \return Number of elements.
+        size_t count(const KeyType& key_) const;
+
+        //! \brief Clears the contents, keeping the capacity.
+        inline void clear(void) {
+                std::memset(m_ctrl.get(), EMPTY, m_capacity);
+                m_count = m_used = 0;
+        }
+
+        //! \brief Checks whether the hash table is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_count == 0; }
+
+        //! \brief Returns the number of elements
+        //! \return Number of elements.
+        inline size_t size(void) const { return m_count; }
+
+        //! \brief Returns the number of slots.
+        inline size_t capacity(void) const { return m_capacity; }
+
+        //! \brief Returns the number of buckets: with open addressing, the slots.
+        //! \return Number of buckets.
+        inline size_t bucket_count(void) const { return m_capacity; }
+
+        //! \brief Applies a function to every entry of the table, slot by slot.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                for (size_t i = 0; i < m_capacity; i++) {
+                        if (m_ctrl[i] & FULL) fn(entry(i).m_key, entry(i).m_data);
+                }
+        }
+
+        //! \brief Extractor operator, in the format of HashTbl with a slot as a bucket.
+        friend std::ostream& operator<<(std::ostream& os, const FlatHashTbl& table) {
+                for (size_t i = 0; i < table.m_capacity; i++) {
+                        os << "[" << i << "]\n";
+                        if (table.m_ctrl[i] & FULL) os << ">>>" << table.entry(i).m_data << "\n\n";
+                        os << std::endl;
+                }
+
+                return os;
+        }
+
+       private:
+        using Slot = typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type;
+
+        static const size_t MIN_CAPACITY = 16;     //!< Smallest table (a power of two).
+        static const size_t NO_SLOT = size_t(-1);  //!< Result of an unsuccessful search.
+        static const uint8_t EMPTY = 0x00;         //!< Control of a slot never used.
+        static const uint8_t ERASED = 0x01;        //!< Control of an erased slot.
+        static const uint8_t FULL = 0x80;          //!< Bit set in the control of a used slot.
+
+        size_t m_capacity;                  //!< Number of slots (a power of two).
+        size_t m_count;                     //!< Number of elements in the table.
+        size_t m_used;                      //!< Slots not empty: elements and erased slots.
+        std::unique_ptr<uint8_t[]> m_ctrl;  //!< Control byte of each slot.
+        std::unique_ptr<Slot[]> m_slots;    //!< Entries (valid where the control is FULL).
+
+        // \brief Largest number of used slots (3/4 of the table).
+        inline size_t max_used(void) const { return m_capacity / 4 * 3; }
+
+        // \brief Smallest capacity holding n elements within the 3/4 load.
+        static size_t capacity_for(size_t n) {
+                size_t capacity = MIN_CAPACITY;
+                while (capacity / 4 * 3 < n + 1) capacity *= 2;
+                return capacity;
+        }
+
+        // \brief Hash of a key, mixed so that its low bits can index the table.
+        static size_t hash_of(const KeyType& key_) {
+                KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+                return detail::mix64(hashFunc(key_));
+        }
+
+        // \brief Control byte of a used slot: the FULL bit and 7 bits of the hash.
+        static uint8_t control_of(size_t hash) { return FULL | uint8_t(hash >> 57); }
+
+        // \brief Compares two keys, as integers when the equality is bitwise.
+        static bool equal(const KeyType& a, const KeyType& b) {
+                if (detail::is_bitwise_equal<KeyType, KeyEqual>::value) {
+                        return std::memcmp(&a, &b, sizeof(KeyType)) == 0;
+                }
+                KeyEqual equalFunc;  // Instantiate the "functor" for the equal to test.
+                return equalFunc(a, b);
+        }
+
+        // \brief Entry at a slot.
+        inline Entry& entry(size_t slot) { return *reinterpret_cast<Entry*>(&m_slots[slot]); }
+        inline const Entry& entry(size_t slot) const {
+                return *reinterpret_cast<const Entry*>(&m_slots[slot]);
+        }
+
+        // \brief Allocates an empty table.
+        void allocate(size_t capacity) {
+                m_capacity = capacity;
+                m_ctrl.reset(new uint8_t[capacity]);
+                m_slots.reset(new Slot[capacity]);
+                std::memset(m_ctrl.get(), EMPTY, capacity);
+        }
+
+        // \brief Returns the slot holding a key, or NO_SLOT.
+        size_t find(const KeyType& key_, size_t hash) const;
+
+        // \brief Stores an entry known not to be in the table.
+        // \return Slot of the entry.
+        size_t place(const KeyType& key_, const DataType& data_item_, size_t hash);
+
+        // \brief Moves the entries to a table with a given number of slots.
+        void resize(size_t capacity);
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::find(const KeyType& key_,
+                                                                size_t hash) const {
+        const size_t mask = m_capacity - 1;
+        const uint8_t control = control_of(hash);
+
+        // The table is never full, so an empty slot ends the probe.
+        for (size_t slot = hash & mask; m_ctrl[slot] != EMPTY; slot = (slot + 1) & mask) {
+                if (m_ctrl[slot] == control && equal(entry(slot).m_key, key_)) return slot;
+        }
+
+        return NO_SLOT;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::place(const KeyType& key_,
+                                                                 const DataType& data_item_,
+                                                                 size_t hash) {
+        if (m_used + 1 > max_used()) {
+                // Erased slots are dropped by the resize: grow only if the elements need it.
+                resize(capacity_for(m_count + 1) > m_capacity ? m_capacity * 2 : m_capacity);
+        }
+
+        const size_t mask = m_capacity - 1;
+        size_t slot = hash & mask;
+        while (m_ctrl[slot] & FULL) slot = (slot + 1) & mask;
+
+        if (m_ctrl[slot] == EMPTY) m_used++;
+        m_ctrl[slot] = control_of(hash);
+        Entry new_entry(key_, data_item_);
+        std::memcpy(&m_slots[slot], &new_entry, sizeof(Entry));
+        m_count++;
+
+        return slot;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+size_t FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::count(const KeyType& key_) const {
+        const size_t mask = m_capacity - 1;
+        const size_t home = hash_of(key_) & mask;
+        size_t n_count = 0;
+
+        // They all lie in the run of used slots that starts there.
+        for (size_t slot = home; m_ctrl[slot] != EMPTY; slot = (slot + 1) & mask) {
+                if ((m_ctrl[slot] & FULL) && (hash_of(entry(slot).m_key) & mask) == home) n_count++;
+        }
+
+        return n_count;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+DataType& FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyType& key_) {
+        size_t hash = hash_of(key_);
+        size_t slot = find(key_, hash);
+        if (slot == NO_SLOT) slot = place(key_, DataType(), hash);
+
+        return entry(slot).m_data;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
+                                                               const DataType& data_item_) {
+        size_t hash = hash_of(key_);
+        size_t slot = find(key_, hash);
+        if (slot != NO_SLOT) {
+                entry(slot).m_data = data_item_;
+                return false;
+        }
+
+        place(key_, data_item_, hash);
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+        size_t slot = find(key_, hash_of(key_));
+        if (slot == NO_SLOT) return false;
+
+        // A slot followed by an empty one ends no probe: it can be emptied instead of erased.
+        if (m_ctrl[(slot + 1) & (m_capacity - 1)] == EMPTY) {
+                m_ctrl[slot] = EMPTY;
+                m_used--;
+        } else {
+                m_ctrl[slot] = ERASED;
+        }
+        m_count--;
+
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>::resize(size_t capacity) {
+        std::unique_ptr<uint8_t[]> old_ctrl(std::move(m_ctrl));
+        std::unique_ptr<Slot[]> old_slots(std::move(m_slots));
+        size_t old_capacity = m_capacity;
+
+        allocate(capacity);
+        const size_t mask = m_capacity - 1;
+        KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+
+        // Entries are moved as bytes; the control byte keeps only 7 bits, so the hash is redone.
+        for (size_t i = 0; i < old_capacity; i++) {
+                if (!(old_ctrl[i] & FULL)) continue;
+
+                const Entry& e = *reinterpret_cast<const Entry*>(&old_slots[i]);
+                size_t hash = detail::mix64(hashFunc(e.m_key));
+                size_t slot = hash & mask;
+                while (m_ctrl[slot] != EMPTY) slot = (slot + 1) & mask;
+
+                m_ctrl[slot] = old_ctrl[i];
+                std::memcpy(&m_slots[slot], &old_slots[i], sizeof(Slot));
+        }
+        m_used = m_count;
+}
+
+//! \brief Picks FlatHashTbl when keys and data are trivially copyable and the key equality is
+//! bitwise, and HashTbl otherwise.
+//!
+//! Code written against the alias may use what both tables have: the constructors, copy, insert(),
+//! operator[], erase(), retrieve(), find(), at(), count(), clear(), empty(), size(),
+//! bucket_count(), for_each() and operator<<. The bucket iterators, compact() and stats() only
+//! exist in HashTbl, whose entries live in collision lists.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+using AutoHashTbl = typename std::conditional<
+    std::is_trivially_copyable<HashEntry<KeyType, DataType>>::value &&
+        detail::is_bitwise_equal<KeyType, KeyEqual>::value,
+    FlatHashTbl<KeyType, DataType, KeyHash, KeyEqual>,
+    HashTbl<KeyType, DataType, KeyHash, KeyEqual>>::type;
+
+}  // namespace ac
+
+#endif
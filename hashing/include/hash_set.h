@@ -0,0 +1,212 @@
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include <cstddef>           // std::ptrdiff_t.
+#include <functional>        // std::hash, std::equal_to.
+#include <initializer_list>  // std::initializer_list.
+#include <iterator>          // std::forward_iterator_tag.
+#include "hashtbl.h"         // ac::HashTbl, ac::Unit.
+
+namespace ac {
+
+//! \brief Set of keys, built on HashTbl.
+//!
+//! The table stores HashEntry<KeyType, Unit>, which holds the key only: an element costs the key
+//! plus the link of its collision list, with no room for data or its padding.
+template <typename KeyType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class HashSet {
+       public:
+        using Table = HashTbl<KeyType, Unit, KeyHash, KeyEqual>;  //!< Underlying table.
+
+        //! \brief Forward iterator over the keys of the set, bucket by bucket.
+        class const_iterator {
+               public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = KeyType;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const KeyType*;
+                using reference = const KeyType&;
+
+                //! \brief Constructs a singular iterator, equal only to other singular ones.
+                const_iterator() : m_table{nullptr}, m_bucket{0}, m_it{} {}
+
+                //! \brief Returns the key pointed to.
+                reference operator*() const { return m_it->m_key; }
+
+                //! \brief Returns a pointer to the key pointed to.
+                pointer operator->() const { return &m_it->m_key; }
+
+                //! \brief Moves to the next key (++it).
+                const_iterator& operator++() {
+                        ++m_it;
+                        skip_empty();
+                        return *this;
+                }
+
+                //! \brief Moves to the next key (it++).
+                const_iterator operator++(int) {
+                        const_iterator old(*this);
+                        ++*this;
+                        return old;
+                }
+
+                //! \brief Checks whether two iterators point to the same key.
+                bool operator==(const const_iterator& rhs) const {
+                        return m_table == rhs.m_table && m_bucket == rhs.m_bucket &&
+                               (m_table == nullptr || m_bucket == m_table->bucket_count() ||
+                                m_it == rhs.m_it);
+                }
+
+                //! \brief Checks whether two iterators point to different keys.
+                bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+               private:
+                friend class HashSet;
+
+                const_iterator(const Table* table, size_t bucket)
+                    : m_table{table}, m_bucket{bucket} {
+                        if (m_bucket < m_table->bucket_count()) {
+                                m_it = m_table->cbegin(m_bucket);
+                                skip_empty();
+                        }
+                }
+
+                // \brief Moves past the end of empty buckets.
+                void skip_empty(void) {
+                        while (m_it == m_table->cend(m_bucket)) {
+                                if (++m_bucket == m_table->bucket_count()) return;
+                                m_it = m_table->cbegin(m_bucket);
+                        }
+                }
+
+                const Table* m_table;                       //!< Table iterated.
+                size_t m_bucket;                            //!< Current bucket.
+                typename Table::const_local_iterator m_it;  //!< Current key in the bucket.
+        };
+
+        using iterator = const_iterator;  //!< Keys cannot be changed in place.
+
+        //! \brief Constructs an empty set.
+        HashSet() {}
+
+        //! \brief Constructs the set with the keys of the range [first, last).
+        //! \param first Iterator to the first key.
+        //! \param last Iterator past the last key.
+        template <typename InputIt>
+        HashSet(InputIt first, InputIt last) {
+                for (; first != last; ++first) insert(*first);
+        }
+
+        //! \brief Constructs the set with the keys of a std::initializer_list.
+        //! \param ilist List of keys.
+        HashSet(std::initializer_list<KeyType> ilist) : HashSet(ilist.begin(), ilist.end()) {}
+
+        //! \brief Inserts a key.
+        //! \param key_ Key to insert.
+        //! \return True if the key was not in the set, false otherwise.
+        bool insert(const KeyType& key_) { return m_table.insert(key_, Unit()); }
+
+        //! \brief Erases a key.
+        //! \param key_ Key to erase.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_) { return m_table.erase(key_); }
+
+        //! \brief Checks whether a key is in the set.
+        //! \param key_ Key to look for.
+        //! \return True if found, false otherwise.
+        bool contains(const KeyType& key_) const {
+                Unit unit;
+                return m_table.retrieve(key_, unit);
+        }
+
+        //! \brief Clears the contents.
+        inline void clear(void) { m_table = Table(); }
+
+        //! \brief Checks whether the set is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_table.empty(); }
+
+        //! \brief Returns the number of keys
+        //! \return Number of keys.
+        inline size_t size(void) const { return m_table.size(); }
+
+        //! \brief Returns an iterator to the first key.
+        const_iterator begin(void) const { return const_iterator(&m_table, 0); }
+
+        //! \brief Returns an iterator past the last key.
+        const_iterator end(void) const { return const_iterator(&m_table, m_table.bucket_count()); }
+
+        //! \brief Adds the keys of another set (union).
+        //! \param other Set to add.
+        //! \return Object itself.
+        HashSet& operator|=(const HashSet& other) {
+                for (const auto& key : other) insert(key);
+                return *this;
+        }
+
+        //! \brief Keeps only the keys also in another set (intersection).
+        //! \param other Set to intersect with.
+        //! \return Object itself.
+        HashSet& operator&=(const HashSet& other) { return *this = *this & other; }
+
+        //! \brief Removes the keys of another set (difference).
+        //! \param other Set to remove.
+        //! \return Object itself.
+        HashSet& operator-=(const HashSet& other) {
+                if (other.size() < size()) {
+                        for (const auto& key : other) erase(key);
+                } else {
+                        *this = *this - other;
+                }
+                return *this;
+        }
+
+        //! \brief Union of two sets.
+        friend HashSet operator|(const HashSet& lhs, const HashSet& rhs) {
+                // Copy the larger set, and insert the keys of the smaller.
+                if (lhs.size() < rhs.size()) return HashSet(rhs) |= lhs;
+                return HashSet(lhs) |= rhs;
+        }
+
+        //! \brief Intersection of two sets.
+        friend HashSet operator&(const HashSet& lhs, const HashSet& rhs) {
+                // Scan the smaller set, and look its keys up in the larger.
+                const HashSet& small = lhs.size() < rhs.size() ? lhs : rhs;
+                const HashSet& large = lhs.size() < rhs.size() ? rhs : lhs;
+
+                HashSet result;
+                for (const auto& key : small) {
+                        if (large.contains(key)) result.insert(key);
+                }
+                return result;
+        }
+
+        //! \brief Difference of two sets: the keys of lhs that are not in rhs.
+        friend HashSet operator-(const HashSet& lhs, const HashSet& rhs) {
+                HashSet result;
+                for (const auto& key : lhs) {
+                        if (!rhs.contains(key)) result.insert(key);
+                }
+                return result;
+        }
+
+        //! \brief Checks whether two sets hold the same keys.
+        friend bool operator==(const HashSet& lhs, const HashSet& rhs) {
+                if (lhs.size() != rhs.size()) return false;
+                for (const auto& key : lhs) {
+                        if (!rhs.contains(key)) return false;
+                }
+                return true;
+        }
+
+        //! \brief Checks whether two sets hold different keys.
+        friend bool operator!=(const HashSet& lhs, const HashSet& rhs) { return !(lhs == rhs); }
+
+       private:
+        Table m_table;  //!< Keys, with empty data.
+};
+
+}  // namespace ac
+
+#endif
@@ -1,16 +1,173 @@
 #ifndef HASHING_H
 #define HASHING_H
 
-#include <algorithm>     // std::find.
+#include <algorithm>     // std::find, std::sort, std::unique.
 #include <cmath>         // std::sqrt.
+#include <cstdint>       // uint64_t, uintptr_t.
 #include <forward_list>  // std::forward_list.
-#include <functional>    // std::hash, std::equal_to.
+#include <functional>    // std::hash, std::equal_to, std::less.
 #include <iostream>      // std::cout.
+#include <memory>        // std::allocator, std::unique_ptr.
 #include <stdexcept>     // std::out_of_range
+#include <type_traits>   // std::true_type, std::false_type.
+#include <utility>       // std::move.
 #include <vector>        // std::vector.
 
 namespace ac {
 
+namespace detail {
+
+// \brief Checks if a number is prime.
+// \param n Number to check.
+// \return True if a prime number, false otherwise.
+inline bool is_prime(size_t n) {
+        size_t i;
+
+        if (n <= 1) return false;
+
+        for (i = 2; i <= std::sqrt(n); i++) {
+                if (n % i == 0) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+// \brief Checks the next number prime >= n.
+// \param n Number to check.
+// \return Next prime.
+inline size_t next_prime(size_t n) {
+        while (!is_prime(n)) {
+                n++;
+        }
+
+        return n;
+}
+
+// \brief Finalizer of splitmix64, used to spread a 64 bits hash over all its bits.
+// \param x Hash to mix.
+// \return Mixed hash.
+inline uint64_t mix64(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+
+        return x;
+}
+
+//! \brief Contiguous block of equally sized nodes, filled in allocation order.
+//!
+//! Freed nodes go to a free list and are handed out again before the block grows. The block is
+//! sized once, by the first allocation; when it is full, the allocator falls back to the heap.
+class NodeArena {
+       public:
+        //! \brief Constructs an arena for a number of nodes (the block is allocated on first use).
+        explicit NodeArena(size_t capacity) : m_capacity{capacity} {}
+
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        ~NodeArena() { ::operator delete(m_block); }
+
+        //! \brief Allocates a node.
+        //! \return The node, or nullptr if the arena is full or made for nodes of another size.
+        void* allocate(size_t size) {
+                if (m_block == nullptr) {
+                        if (m_capacity == 0) return nullptr;
+                        m_slot = size;
+                        m_block = static_cast<char*>(::operator new(m_slot * m_capacity));
+                }
+                if (size != m_slot) return nullptr;
+
+                void* node = nullptr;
+                if (m_free != nullptr) {
+                        node = m_free;
+                        m_free = *static_cast<void**>(node);
+                } else if (m_used < m_capacity) {
+                        node = m_block + m_slot * m_used++;
+                }
+                if (node != nullptr) m_live++;
+                return node;
+        }
+
+        //! \brief Frees a node, if it belongs to the arena.
+        //! \return True if freed, false if the node is not from the arena.
+        bool deallocate(void* node) {
+                if (!owns(node)) return false;
+
+                *static_cast<void**>(node) = m_free;
+                m_free = node;
+                m_live--;
+                return true;
+        }
+
+        //! \brief Checks whether a node lies in the block.
+        bool owns(const void* node) const {
+                std::less<const void*> less;
+                return m_block != nullptr && !less(node, m_block) &&
+                       less(node, m_block + m_slot * m_capacity);
+        }
+
+        //! \brief Returns the number of nodes allocated and not freed.
+        inline size_t live(void) const { return m_live; }
+
+       private:
+        size_t m_capacity;        //!< Nodes in the block.
+        size_t m_slot = 0;        //!< Size of a node.
+        size_t m_used = 0;        //!< Nodes handed out from the block, freed or not.
+        size_t m_live = 0;        //!< Nodes allocated and not freed.
+        char* m_block = nullptr;  //!< The block.
+        void* m_free = nullptr;   //!< Freed nodes, linked through their first bytes.
+};
+
+//! \brief Allocator of list nodes, from an arena when it has one and room in it, else the heap.
+//!
+//! A list keeps its allocator when assigned a copy, and a copied list starts on the heap: only
+//! the table that made an arena puts nodes in it.
+template <typename T>
+class NodeAllocator {
+       public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        NodeAllocator(NodeArena* arena = nullptr) noexcept : m_arena{arena} {}
+
+        template <typename U>
+        NodeAllocator(const NodeAllocator<U>& other) noexcept : m_arena{other.m_arena} {}
+
+        T* allocate(size_t n) {
+                if (m_arena != nullptr && n == 1) {
+                        void* node = m_arena->allocate(sizeof(T));
+                        if (node != nullptr) return static_cast<T*>(node);
+                }
+                return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, size_t n) {
+                if (m_arena != nullptr && n == 1 && m_arena->deallocate(p)) return;
+                std::allocator<T>().deallocate(p, n);
+        }
+
+        NodeAllocator select_on_container_copy_construction(void) const { return NodeAllocator(); }
+
+        friend bool operator==(const NodeAllocator& lhs, const NodeAllocator& rhs) {
+                return lhs.m_arena == rhs.m_arena;
+        }
+
+        friend bool operator!=(const NodeAllocator& lhs, const NodeAllocator& rhs) {
+                return !(lhs == rhs);
+        }
+
+        NodeArena* m_arena;  //!< Arena of the nodes, or nullptr for the heap.
+};
+
+}  // namespace detail
+
 template <class KeyType, class DataType>
 class HashEntry {
        public:
@@ -20,16 +177,50 @@ class HashEntry {
         DataType m_data;  //!< Data associated to key.
 };
 
+//! \brief Empty data type, for tables that store keys only.
+struct Unit {};
+
+//! \brief Entry without data: it holds the key only.
+//!
+//! The data is an empty member that shares its address with the key ([[no_unique_address]]), so
+//! the code written for HashEntry works unchanged while the entry takes the size of the key alone.
+template <class KeyType>
+class HashEntry<KeyType, Unit> {
+       public:
+        HashEntry(KeyType k_, Unit) : m_key(k_) {}
+
+        KeyType m_key;                      //!< Key.
+        [[no_unique_address]] Unit m_data;  //!< Empty data, taking no room.
+};
+
 template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
           typename KeyEqual = std::equal_to<KeyType>>
 class HashTbl {
        public:
         using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in hash table.
+        using List = std::forward_list<Entry, detail::NodeAllocator<Entry>>;  //!< Collision list.
+        using const_local_iterator = typename List::const_iterator;  //!< Iterator over a bucket.
+
+        //! \brief Memory layout of the entries, as reported by stats().
+        struct Stats {
+                size_t m_entries;        //!< Number of entries.
+                size_t m_buckets;        //!< Number of buckets.
+                size_t m_arena_entries;  //!< Entries in the arena of the last compact().
+                size_t m_pages;          //!< Distinct 4 KiB pages holding entries.
+                size_t m_page_jumps;     //!< Steps of a full scan that change page.
+
+                //! \brief Share of the steps of a full scan that land on another page: close to 0
+                //! when the entries are laid out in scan order, close to 1 when scattered.
+                double fragmentation(void) const {
+                        return m_entries < 2 ? 0 : double(m_page_jumps) / (m_entries - 1);
+                }
+        };
 
         //! \brief Constructs the hash table with a specific size.
-        //! \param tbl_size_ Size of the hash table.
-        HashTbl(size_t tbl_size_ = DEFAULT_SIZE) : m_size{tbl_size_}, m_count{0} {
-                m_main_table.resize(tbl_size_);
+        //! \param tbl_size_ Size of the hash table (rounded up to the next prime).
+        HashTbl(size_t tbl_size_ = DEFAULT_SIZE)
+            : m_size{detail::next_prime(tbl_size_)}, m_count{0} {
+                m_main_table.resize(m_size);
         }
 
         //! \brief Destructs the hash table.
@@ -72,7 +263,8 @@ class HashTbl {
                 return *this;
         }
 
-        //! \brief Access or insert element associated to a key.
+        //! \brief Access or insert element associated to a key. An insertion grows the table as
+        //! insert() does.
         //! \param key_ Key associated to data.
         //! \return Data associated to the key.
         DataType& operator[](const KeyType& key_);
@@ -95,6 +287,11 @@ class HashTbl {
         //! \return True if retrieved, false otherwise.
         bool retrieve(const KeyType& key_, DataType& data_item_) const;
 
+        //! \brief Locates the data associated to a key, without copying it.
+        //! \param key_ Key associated to data.
+        //! \return Pointer to the data, or nullptr if the key is not in the table.
+        const DataType* find(const KeyType& key_) const;
+
         //! \brief Clears the contents.
         inline void clear(void) {
                 m_main_table.clear();
@@ -120,6 +317,42 @@ class HashTbl {
         //! \return Number of elements.
         size_t count(const KeyType& key_) const;
 
+        //! \brief Returns the number of buckets.
+        //! \return Number of buckets.
+        inline size_t bucket_count(void) const { return m_main_table.size(); }
+
+        //! \brief Returns an iterator to the first entry of a bucket.
+        //! \param n Bucket, in [0, bucket_count()).
+        inline const_local_iterator cbegin(size_t n) const { return m_main_table[n].cbegin(); }
+
+        //! \brief Returns an iterator past the last entry of a bucket.
+        //! \param n Bucket, in [0, bucket_count()).
+        inline const_local_iterator cend(size_t n) const { return m_main_table[n].cend(); }
+
+        //! \brief Relocates the entries into a fresh contiguous arena, in the order of a scan.
+        //!
+        //! The work can be spread over many calls, a few buckets each, between which the table is
+        //! used as usual; the entries left behind are freed as their buckets are relocated, and
+        //! the arena of the previous pass at the end.
+        //! \param n_buckets Number of buckets to relocate in this call.
+        //! \return True if the pass is complete.
+        bool compact(size_t n_buckets = size_t(-1));
+
+        //! \brief Reports how the entries are laid out in memory.
+        //! \return Counts of entries, buckets and pages, and fragmentation.
+        Stats stats(void) const;
+
+        //! \brief Applies a function to every entry of the table, bucket by bucket.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                for (size_t i = 0; i < m_main_table.size(); i++) {
+                        for (auto it = m_main_table[i].begin(); it != m_main_table[i].end(); it++) {
+                                fn(it->m_key, it->m_data);
+                        }
+                }
+        }
+
         //! \brief Extractor operator.
         friend std::ostream& operator<<(std::ostream& os, const HashTbl& table) {
                 for (size_t i = 0; i < table.m_main_table.size(); i++) {
@@ -136,21 +369,14 @@ class HashTbl {
         }
 
        private:
-        static const short DEFAULT_SIZE = 11;  //!< Hash table’s default size.
-        const float DEFAULT_LOAD_FACTOR = 1;   //!< Hash table’s default load factor.
-        size_t m_size;                         //!< Hash table size.
-        size_t m_count;                        //!< Number of elements in the table.
-        std::vector<std::forward_list<Entry>> m_main_table;  //!< Hash table.
-
-        // \brief Checks if a number is prime.
-        // \param n Number to check.
-        // \return True if a prime number, false otherwise.
-        bool is_prime(size_t n);
-
-        // \brief Checks the next number prime >= n.
-        // \param n Number to check.
-        // \return Next prime.
-        size_t next_prime(size_t n);
+        static const short DEFAULT_SIZE = 11;             //!< Hash table’s default size.
+        const float DEFAULT_LOAD_FACTOR = 1;              //!< Hash table’s default load factor.
+        size_t m_size;                                    //!< Hash table size.
+        size_t m_count;                                   //!< Number of elements in the table.
+        std::unique_ptr<detail::NodeArena> m_arena;       //!< Arena of the last compact().
+        std::unique_ptr<detail::NodeArena> m_next_arena;  //!< Arena of the pass going on.
+        size_t m_next_bucket = 0;                         //!< Next bucket of the pass.
+        std::vector<List> m_main_table;                   //!< Hash table.
 
         // \brief Returns the load factor.
         // \return Load factor.
@@ -194,6 +420,12 @@ DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyTyp
                         return (*it).m_data;
                 }
         }
+
+        // Grow as insert() does, but before the new entry: a rehash would move it.
+        if ((m_count + 1) / m_size >= DEFAULT_LOAD_FACTOR) {
+                rehash();
+                addr = hashFunc(key_) % m_size;
+        }
         m_count++;  // Update the number of elements in the list.
 
         // Create new entry if not located.
@@ -302,32 +534,22 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::retrieve(const KeyType& key_
 }
 
 template <class KeyType, class DataType, class KeyHash, class KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::is_prime(size_t n) {
-        size_t i;
-
-        if (n <= 1) return false;
-
-        for (i = 2; i <= std::sqrt(n); i++) {
-                if (n % i == 0) {
-                        return false;
-                }
-        }
-
-        return true;
-}
+const DataType* HashTbl<KeyType, DataType, KeyHash, KeyEqual>::find(const KeyType& key_) const {
+        KeyHash hashFunc;                    // Instantiate the "functor" for primary hash.
+        KeyEqual equalFunc;                  // Instantiate the "functor" for the equal to test.
+        auto addr(hashFunc(key_) % m_size);  // Apply double hashing method.
 
-template <class KeyType, class DataType, class KeyHash, class KeyEqual>
-size_t HashTbl<KeyType, DataType, KeyHash, KeyEqual>::next_prime(size_t n) {
-        while (!is_prime(n)) {
-                n++;
+        for (auto it = m_main_table[addr].begin(); it != m_main_table[addr].end(); it++) {
+                //  Comparing keys inside the collision list.
+                if (true == equalFunc((*it).m_key, key_)) return &(*it).m_data;
         }
 
-        return n;
+        return nullptr;
 }
 
 template <class KeyType, class DataType, class KeyHash, class KeyEqual>
 void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::rehash() {
-        HashTbl new_table(next_prime(this->m_size * 2));
+        HashTbl new_table(detail::next_prime(this->m_size * 2));
         KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
 
         for (size_t i = 0; i < m_size; i++) {
@@ -341,6 +563,55 @@ void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::rehash() {
         *this = new_table;
 }
 
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::compact(size_t n_buckets) {
+        if (m_next_arena == nullptr) {
+                m_next_arena.reset(new detail::NodeArena(m_count));
+                m_next_bucket = 0;
+        }
+
+        detail::NodeAllocator<Entry> arena(m_next_arena.get());
+        for (; m_next_bucket < m_main_table.size() && n_buckets > 0; m_next_bucket++, n_buckets--) {
+                // Copy the list into the arena, in order, then free the old nodes.
+                List& old_list = m_main_table[m_next_bucket];
+                List new_list(arena);
+                auto last = new_list.before_begin();
+                for (auto& entry : old_list) {
+                        last = new_list.emplace_after(last, std::move(entry.m_key),
+                                                      std::move(entry.m_data));
+                }
+                old_list = std::move(new_list);  // The list takes the allocator of the arena.
+        }
+        if (m_next_bucket < m_main_table.size()) return false;
+
+        // No list allocates from the previous arena any more: free it.
+        m_arena = std::move(m_next_arena);
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual>::Stats
+HashTbl<KeyType, DataType, KeyHash, KeyEqual>::stats() const {
+        const uintptr_t PAGE = 4096;
+
+        Stats stats{m_count, m_main_table.size(), 0, 0, 0};
+        if (m_arena != nullptr) stats.m_arena_entries += m_arena->live();
+        if (m_next_arena != nullptr) stats.m_arena_entries += m_next_arena->live();
+
+        std::vector<uintptr_t> pages;
+        for (const auto& list : m_main_table) {
+                for (const auto& entry : list) {
+                        uintptr_t page = reinterpret_cast<uintptr_t>(&entry) / PAGE;
+                        if (!pages.empty() && page != pages.back()) stats.m_page_jumps++;
+                        pages.push_back(page);
+                }
+        }
+
+        std::sort(pages.begin(), pages.end());
+        stats.m_pages = std::unique(pages.begin(), pages.end()) - pages.begin();
+        return stats;
+}
+
 }  // namespace ac
 
 #endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef HOT_KEYS_H
+#define HOT_KEYS_H
+
+#include <algorithm>   // std::min, std::sort.
+#include <cstdint>     // uint32_t, uint64_t.
+#include <functional>  // std::hash, std::equal_to.
+#include <stdexcept>   // std::invalid_argument.
+#include <vector>      // std::vector.
+#include "hashtbl.h"   // ac::detail::mix64.
+
+namespace ac {
+
+//! \brief Count-Min sketch: approximate frequencies of keys in a fixed amount of memory.
+//!
+//! A key adds to one counter in each of `depth` rows of `width` counters, and its estimate is the
+//! smallest of them. Collisions only add, so the estimate never falls below the true frequency,
+//! and with probability 1 - 2^-depth it exceeds it by less than 2 / width of the total.
+template <typename KeyType, typename KeyHash = std::hash<KeyType>>
+class CountMinSketch {
+       public:
+        //! \brief Constructs an empty sketch.
+        //! \param width Counters per row (rounded up to a power of 2).
+        //! \param depth Number of rows.
+        //! \throw std::invalid_argument if width or depth is zero.
+        CountMinSketch(size_t width = 1024, size_t depth = 4) : m_depth{depth}, m_total{0} {
+                if (width == 0 || depth == 0) {
+                        throw std::invalid_argument("CountMinSketch: empty sketch");
+                }
+                for (m_width = 1; m_width < width; m_width *= 2) {
+                }
+                m_counters.resize(m_width * m_depth);
+        }
+
+        //! \brief Counts occurrences of a key.
+        //! \param key_ Key seen.
+        //! \param n Number of occurrences.
+        void add(const KeyType& key_, uint32_t n = 1) {
+                uint64_t h = detail::mix64(KeyHash()(key_));
+                for (size_t row = 0; row < m_depth; row++) m_counters[index(h, row)] += n;
+                m_total += n;
+        }
+
+        //! \brief Estimates the occurrences of a key, from above.
+        //! \param key_ Key to estimate.
+        //! \return Estimated number of occurrences.
+        uint32_t estimate(const KeyType& key_) const {
+                uint64_t h = detail::mix64(KeyHash()(key_));
+                uint32_t n = m_counters[index(h, 0)];
+                for (size_t row = 1; row < m_depth; row++) {
+                        n = std::min(n, m_counters[index(h, row)]);
+                }
+                return n;
+        }
+
+        //! \brief Clears the counters.
+        void clear(void) {
+                std::fill(m_counters.begin(), m_counters.end(), 0);
+                m_total = 0;
+        }
+
+        //! \brief Returns the occurrences counted, over all keys.
+        inline uint64_t total(void) const { return m_total; }
+
+       private:
+        size_t m_width;                    //!< Counters per row, a power of 2.
+        size_t m_depth;                    //!< Number of rows.
+        uint64_t m_total;                  //!< Occurrences counted.
+        std::vector<uint32_t> m_counters;  //!< Rows, one after the other.
+
+        // \brief Counter of a hash in a row; the rows derive their hashes from two halves of it.
+        size_t index(uint64_t h, size_t row) const {
+                uint64_t g = (h & 0xffffffff) + row * ((h >> 32) | 1);
+                return row * m_width + (g & (m_width - 1));
+        }
+};
+
+//! \brief Space-Saving: the k most frequent keys of a stream, in O(k) memory.
+//!
+//! The k counters monitor k keys. A key not monitored takes the counter of the least frequent,
+//! and carries its count on as an error bound. Every key with a frequency above total / k is
+//! monitored, and each count exceeds the true frequency by at most its error.
+template <typename KeyType, typename KeyEqual = std::equal_to<KeyType>>
+class SpaceSaving {
+       public:
+        //! \brief Counter of a monitored key.
+        struct Counter {
+                KeyType m_key;     //!< Key monitored.
+                uint64_t m_count;  //!< Occurrences, from above.
+                uint64_t m_error;  //!< Largest overestimation of m_count.
+        };
+
+        //! \brief Constructs an empty summary.
+        //! \param k Number of keys monitored.
+        //! \throw std::invalid_argument if k is zero.
+        explicit SpaceSaving(size_t k = 16) : m_capacity{k} {
+                if (k == 0) throw std::invalid_argument("SpaceSaving: no counters");
+                m_counters.reserve(k);
+        }
+
+        //! \brief Counts an occurrence of a key.
+        //! \param key_ Key seen.
+        void add(const KeyType& key_) {
+                // k is small: a scan of the counters is cheaper than any index on them.
+                KeyEqual equal;
+                size_t min = 0;
+                for (size_t i = 0; i < m_counters.size(); i++) {
+                        if (equal(m_counters[i].m_key, key_)) {
+                                m_counters[i].m_count++;
+                                return;
+                        }
+                        if (m_counters[i].m_count < m_counters[min].m_count) min = i;
+                }
+
+                if (m_counters.size() < m_capacity) {
+                        m_counters.push_back(Counter{key_, 1, 0});
+                } else {
+                        Counter& victim = m_counters[min];
+                        victim = Counter{key_, victim.m_count + 1, victim.m_count};
+                }
+        }
+
+        //! \brief Returns the monitored keys, the most frequent first.
+        //! \return Counters sorted by decreasing count.
+        std::vector<Counter> top(void) const {
+                std::vector<Counter> counters(m_counters);
+                std::sort(counters.begin(), counters.end(), [](const Counter& a, const Counter& b) {
+                        return a.m_count > b.m_count;
+                });
+                return counters;
+        }
+
+        //! \brief Clears the counters.
+        inline void clear(void) { m_counters.clear(); }
+
+        //! \brief Returns the number of keys monitored.
+        inline size_t capacity(void) const { return m_capacity; }
+
+       private:
+        size_t m_capacity;                //!< Number of counters.
+        std::vector<Counter> m_counters;  //!< Monitored keys, in no order.
+};
+
+}  // namespace ac
+
+#endif
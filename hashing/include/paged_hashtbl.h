@@ -0,0 +1,451 @@
+#ifndef PAGED_HASHTBL_H
+#define PAGED_HASHTBL_H
+
+#include <fcntl.h>   // open, posix_fadvise.
+#include <unistd.h>  // pread, pwrite, close.
+
+#include <algorithm>    // std::copy_n.
+#include <cerrno>       // errno.
+#include <cstdint>      // uint32_t, uint64_t.
+#include <cstring>      // std::memcpy, std::strerror.
+#include <fstream>      // std::ifstream, std::ofstream.
+#include <functional>   // std::hash, std::equal_to.
+#include <memory>       // std::unique_ptr.
+#include <stdexcept>    // std::runtime_error, std::length_error.
+#include <string>       // std::string.
+#include <type_traits>  // std::is_trivially_copyable.
+#include <vector>       // std::vector.
+#include "hashtbl.h"    // ac::HashTbl, ac::HashEntry, ac::detail::mix64.
+
+namespace ac {
+
+//! \brief Disk-resident hash table (extendible hashing) for data sets larger than memory.
+//!
+//! Buckets are 4 KiB pages of a file, cached by a fixed-size buffer pool with CLOCK replacement.
+//! The directory, which maps the low bits of the hash to a page, is kept in memory, so a lookup
+//! reads at most one page when it misses the pool. When a bucket is full it is split in two, and
+//! the directory doubles only when the bucket was already as deep as the directory: the table
+//! grows one page at a time. Erased entries leave room in their page; pages are never merged.
+//!
+//! Keys and data are stored as their bytes, so they must be trivially copyable. The directory is
+//! written to base.dir by flush() and by the destructor.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class PagedHashTbl {
+       public:
+        using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in hash table.
+
+        static const size_t PAGE_SIZE = 4096;  //!< Bytes per bucket page.
+
+        static_assert(std::is_trivially_copyable<Entry>::value,
+                      "PagedHashTbl needs trivially copyable keys and data");
+        static_assert(alignof(Entry) <= 8, "PagedHashTbl needs entries aligned to 8 bytes at most");
+
+        //! \brief Opens (or creates) a table.
+        //! \param path Base path of the files (base.dat and base.dir).
+        //! \param pool_pages Number of pages in the buffer pool.
+        //! \throw std::runtime_error
+        explicit PagedHashTbl(const std::string& path, size_t pool_pages = DEFAULT_POOL_PAGES);
+
+        //! \brief Writes the dirty pages and the directory, and closes the file.
+        virtual ~PagedHashTbl();
+
+        PagedHashTbl(const PagedHashTbl&) = delete;
+        PagedHashTbl& operator=(const PagedHashTbl&) = delete;
+
+        //! \brief Inserts data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if not collision ocurred, false otherwise.
+        //! \throw std::length_error if too many keys share the same hash.
+        bool insert(const KeyType& key_, const DataType& data_item_);
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const;
+
+        //! \brief Checks whether the hash table is empty
+        inline bool empty(void) const { return m_count == 0; }
+
+        //! \brief Returns the number of elements
+        inline size_t size(void) const { return m_count; }
+
+        //! \brief Returns the number of bucket pages in the file.
+        inline size_t page_count(void) const { return m_n_pages; }
+
+        //! \brief Returns the number of pages read from the file since it was opened.
+        inline size_t page_reads(void) const { return m_reads; }
+
+        //! \brief Returns the number of pages written to the file since it was opened.
+        inline size_t page_writes(void) const { return m_writes; }
+
+        //! \brief Writes the dirty pages and the directory to the file.
+        void flush(void);
+
+        //! \brief Flushes, empties the buffer pool and asks the kernel to drop the cached pages of
+        //! the file, so that the next lookups go to the disk.
+        void drop_caches(void);
+
+       private:
+        static const size_t DEFAULT_POOL_PAGES = 256;  //!< Default buffer pool size (1 MiB).
+        static const uint32_t MAX_DEPTH = 24;          //!< Deepest split (a 64 MiB directory).
+        static const uint64_t DIR_MAGIC = 0x3152494448474150ULL;  //!< "PAGHDIR1".
+        static const uint32_t NO_PAGE = uint32_t(-1);             //!< Empty frame.
+
+        //! \brief Header at the start of every bucket page.
+        struct PageHeader {
+                uint32_t m_local_depth;  //!< Number of hash bits shared by the keys in the page.
+                uint32_t m_count;        //!< Number of entries in the page.
+        };
+
+        //! Entries that fit in a page.
+        static const size_t SLOTS = (PAGE_SIZE - sizeof(PageHeader)) / sizeof(Entry);
+        static_assert(SLOTS >= 2, "entries are too large for a page");
+
+        //! \brief A page cached in the buffer pool.
+        struct Frame {
+                uint32_t m_page;                 //!< Page held by the frame, or NO_PAGE.
+                bool m_dirty;                    //!< True if the page must be written back.
+                bool m_referenced;               //!< CLOCK reference bit.
+                std::unique_ptr<char[]> m_data;  //!< Contents of the page.
+        };
+
+        std::string m_path;                              //!< Base path of the files.
+        int m_fd;                                        //!< Data file.
+        uint32_t m_global_depth;                         //!< Hash bits used by the directory.
+        std::vector<uint32_t> m_directory;               //!< Page of each hash suffix.
+        size_t m_count;                                  //!< Number of elements in the table.
+        size_t m_n_pages;                                //!< Number of pages in the data file.
+        mutable std::vector<Frame> m_frames;             //!< The buffer pool.
+        mutable HashTbl<uint32_t, size_t> m_page_table;  //!< Frame of each cached page.
+        mutable size_t m_clock_hand;                     //!< Next frame considered for eviction.
+        mutable size_t m_reads;                          //!< Pages read from the file.
+        mutable size_t m_writes;                         //!< Pages written to the file.
+
+        // \brief Hash of a key; its low bits index the directory.
+        static uint64_t hash_of(const KeyType& key_) {
+                KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+                return detail::mix64(hashFunc(key_));
+        }
+
+        // \brief Page of a hash.
+        uint32_t page_of(uint64_t hash_) const {
+                return m_directory[hash_ & ((uint64_t(1) << m_global_depth) - 1)];
+        }
+
+        // \brief Returns the buffer of a page, reading it if it is not in the pool.
+        char* fetch(uint32_t page, bool dirty) const;
+
+        // \brief Writes a frame back if it is dirty.
+        void write_back(Frame& frame) const;
+
+        // \brief Header and slots of a page buffer.
+        static PageHeader* header(char* data) { return reinterpret_cast<PageHeader*>(data); }
+        static Entry* slots(char* data) {
+                return reinterpret_cast<Entry*>(data + sizeof(PageHeader));
+        }
+
+        // \brief Looks for a key in a page.
+        // \return Slot of the key, or -1.
+        static long find_slot(char* data, const KeyType& key_) {
+                KeyEqual equalFunc;  // Instantiate the "functor" for the equal to test.
+                PageHeader* h = header(data);
+                Entry* s = slots(data);
+                for (uint32_t i = 0; i < h->m_count; i++) {
+                        if (true == equalFunc(s[i].m_key, key_)) return long(i);
+                }
+
+                return -1;
+        }
+
+        // \brief Appends a new zeroed page to the file, and returns it.
+        uint32_t new_page(uint32_t local_depth);
+
+        // \brief Splits the page that holds a hash.
+        void split(uint64_t hash_);
+
+        // \brief Writes the directory file.
+        void save_directory(void) const;
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::PagedHashTbl(const std::string& path,
+                                                                 size_t pool_pages)
+    : m_path{path},
+      m_fd{-1},
+      m_global_depth{0},
+      m_count{0},
+      m_n_pages{0},
+      m_frames(pool_pages < 2 ? 2 : pool_pages),
+      m_page_table(2 * m_frames.size()),
+      m_clock_hand{0},
+      m_reads{0},
+      m_writes{0} {
+        for (auto& frame : m_frames) {
+                frame.m_page = NO_PAGE;
+                frame.m_dirty = frame.m_referenced = false;
+                frame.m_data.reset(new char[PAGE_SIZE]);
+        }
+
+        m_fd = ::open((m_path + ".dat").c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd < 0) {
+                throw std::runtime_error("error: open " + m_path + ".dat: " +
+                                         std::strerror(errno) + "\n");
+        }
+
+        // The destructor does not run if the constructor throws: the file is closed here.
+        try {
+                // Directory file: magic, global depth, count, number of pages, directory.
+                std::ifstream dir(m_path + ".dir", std::ios::binary);
+                if (dir) {
+                        uint64_t magic = 0, count = 0, n_pages = 0;
+                        dir.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+                        dir.read(reinterpret_cast<char*>(&m_global_depth), sizeof(m_global_depth));
+                        dir.read(reinterpret_cast<char*>(&count), sizeof(count));
+                        dir.read(reinterpret_cast<char*>(&n_pages), sizeof(n_pages));
+                        if (!dir || magic != DIR_MAGIC || m_global_depth > MAX_DEPTH) {
+                                throw std::runtime_error("error: corrupted " + m_path + ".dir\n");
+                        }
+                        m_count = count;
+                        m_n_pages = n_pages;
+                        m_directory.resize(size_t(1) << m_global_depth);
+                        dir.read(reinterpret_cast<char*>(m_directory.data()),
+                                 m_directory.size() * sizeof(uint32_t));
+                        if (!dir) {
+                                throw std::runtime_error("error: corrupted " + m_path + ".dir\n");
+                        }
+                } else {
+                        m_directory.assign(1, new_page(0));
+                }
+        } catch (...) {
+                ::close(m_fd);
+                throw;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::~PagedHashTbl() {
+        try {
+                flush();
+        } catch (...) {
+                // Destructors must not throw.
+        }
+        ::close(m_fd);
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+char* PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::fetch(uint32_t page, bool dirty) const {
+        size_t f;
+        if (m_page_table.retrieve(page, f)) {
+                m_frames[f].m_referenced = true;
+                m_frames[f].m_dirty = m_frames[f].m_dirty || dirty;
+                return m_frames[f].m_data.get();
+        }
+
+        // CLOCK: skip (and clear) referenced frames until one can be evicted.
+        while (m_frames[m_clock_hand].m_referenced) {
+                m_frames[m_clock_hand].m_referenced = false;
+                m_clock_hand = (m_clock_hand + 1) % m_frames.size();
+        }
+        f = m_clock_hand;
+        m_clock_hand = (m_clock_hand + 1) % m_frames.size();
+
+        Frame& frame = m_frames[f];
+        if (frame.m_page != NO_PAGE) {
+                write_back(frame);
+                m_page_table.erase(frame.m_page);
+        }
+
+        ssize_t n = ::pread(m_fd, frame.m_data.get(), PAGE_SIZE, off_t(page) * PAGE_SIZE);
+        if (n != ssize_t(PAGE_SIZE)) {
+                frame.m_page = NO_PAGE;
+                throw std::runtime_error("error: read page of " + m_path + ".dat\n");
+        }
+        m_reads++;
+
+        frame.m_page = page;
+        frame.m_dirty = dirty;
+        frame.m_referenced = true;
+        m_page_table.insert(page, f);
+
+        return frame.m_data.get();
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::write_back(Frame& frame) const {
+        if (!frame.m_dirty) return;
+
+        ssize_t n = ::pwrite(m_fd, frame.m_data.get(), PAGE_SIZE, off_t(frame.m_page) * PAGE_SIZE);
+        if (n != ssize_t(PAGE_SIZE)) {
+                throw std::runtime_error("error: write page of " + m_path + ".dat\n");
+        }
+        m_writes++;
+        frame.m_dirty = false;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+uint32_t PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::new_page(uint32_t local_depth) {
+        alignas(16) char data[PAGE_SIZE] = {0};
+        header(data)->m_local_depth = local_depth;
+        header(data)->m_count = 0;
+
+        uint32_t page = uint32_t(m_n_pages);
+        if (::pwrite(m_fd, data, PAGE_SIZE, off_t(page) * PAGE_SIZE) != ssize_t(PAGE_SIZE)) {
+                throw std::runtime_error("error: write page of " + m_path + ".dat\n");
+        }
+        m_writes++;
+        m_n_pages++;
+
+        return page;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::split(uint64_t hash_) {
+        uint32_t old_page = page_of(hash_);
+        uint32_t depth = header(fetch(old_page, false))->m_local_depth;
+        if (depth >= MAX_DEPTH) {
+                throw std::length_error("error: too many keys share the same hash!\n");
+        }
+
+        // The directory doubles only when the page already uses all of its bits.
+        if (depth == m_global_depth) {
+                // The second half repeats the first (a self-insert would read freed memory).
+                size_t n = m_directory.size();
+                m_directory.resize(2 * n);
+                std::copy_n(m_directory.begin(), n, m_directory.begin() + n);
+                m_global_depth++;
+        }
+
+        // Entries whose bit 'depth' is set move to the new page. Both pages are built in local
+        // buffers, so that only one page of the pool is in use at a time.
+        alignas(16) char old_data[PAGE_SIZE];
+        alignas(16) char new_data[PAGE_SIZE] = {0};
+        std::memcpy(old_data, fetch(old_page, false), PAGE_SIZE);
+
+        PageHeader* old_h = header(old_data);
+        PageHeader* new_h = header(new_data);
+        Entry* old_s = slots(old_data);
+        Entry* new_s = slots(new_data);
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < old_h->m_count; i++) {
+                if ((hash_of(old_s[i].m_key) >> depth) & 1) {
+                        std::memcpy(&new_s[new_h->m_count++], &old_s[i], sizeof(Entry));
+                } else {
+                        std::memcpy(&old_s[kept++], &old_s[i], sizeof(Entry));
+                }
+        }
+        old_h->m_count = kept;
+        old_h->m_local_depth = new_h->m_local_depth = depth + 1;
+
+        uint32_t buddy = new_page(depth + 1);
+        std::memcpy(fetch(old_page, true), old_data, PAGE_SIZE);
+        std::memcpy(fetch(buddy, true), new_data, PAGE_SIZE);
+
+        // Redirect the directory slots of the old page that have bit 'depth' set.
+        uint64_t low = hash_ & ((uint64_t(1) << depth) - 1);
+        for (uint64_t i = low; i < m_directory.size(); i += uint64_t(1) << depth) {
+                if ((i >> depth) & 1) m_directory[i] = buddy;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
+                                                                const DataType& data_item_) {
+        uint64_t hash_ = hash_of(key_);
+
+        while (true) {
+                char* data = fetch(page_of(hash_), true);
+                long slot = find_slot(data, key_);
+                if (slot >= 0) {
+                        slots(data)[slot].m_data = data_item_;
+                        return false;
+                }
+
+                PageHeader* h = header(data);
+                if (h->m_count < SLOTS) {
+                        Entry new_entry(key_, data_item_);
+                        std::memcpy(&slots(data)[h->m_count++], &new_entry, sizeof(Entry));
+                        m_count++;
+                        return true;
+                }
+
+                split(hash_);
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+        char* data = fetch(page_of(hash_of(key_)), false);
+        long slot = find_slot(data, key_);
+        if (slot < 0) return false;
+
+        // Move the last entry of the page to the hole.
+        data = fetch(page_of(hash_of(key_)), true);
+        PageHeader* h = header(data);
+        std::memcpy(&slots(data)[slot], &slots(data)[h->m_count - 1], sizeof(Entry));
+        h->m_count--;
+        m_count--;
+
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+bool PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::retrieve(const KeyType& key_,
+                                                                  DataType& data_item_) const {
+        char* data = fetch(page_of(hash_of(key_)), false);
+        long slot = find_slot(data, key_);
+        if (slot < 0) return false;
+
+        data_item_ = slots(data)[slot].m_data;
+        return true;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::flush(void) {
+        for (auto& frame : m_frames) {
+                if (frame.m_page != NO_PAGE) write_back(frame);
+        }
+        if (::fdatasync(m_fd) != 0) {
+                throw std::runtime_error("error: fdatasync " + m_path + ".dat: " +
+                                         std::strerror(errno) + "\n");
+        }
+
+        save_directory();
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::save_directory(void) const {
+        std::ofstream dir(m_path + ".dir", std::ios::binary | std::ios::trunc);
+        uint64_t magic = DIR_MAGIC, count = m_count, n_pages = m_n_pages;
+        dir.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        dir.write(reinterpret_cast<const char*>(&m_global_depth), sizeof(m_global_depth));
+        dir.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        dir.write(reinterpret_cast<const char*>(&n_pages), sizeof(n_pages));
+        dir.write(reinterpret_cast<const char*>(m_directory.data()),
+                  m_directory.size() * sizeof(uint32_t));
+        if (!dir) throw std::runtime_error("error: write " + m_path + ".dir\n");
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual>
+void PagedHashTbl<KeyType, DataType, KeyHash, KeyEqual>::drop_caches(void) {
+        flush();
+
+        for (auto& frame : m_frames) {
+                frame.m_page = NO_PAGE;
+                frame.m_referenced = false;
+        }
+        m_page_table = HashTbl<uint32_t, size_t>(2 * m_frames.size());
+
+        ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+}  // namespace ac
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <algorithm>    // std::sort, std::is_sorted, std::lower_bound, std::upper_bound.
+#include <atomic>       // std::atomic.
+#include <cstdint>      // uint64_t.
+#include <functional>   // std::hash, std::equal_to.
+#include <iostream>     // std::istream, std::ostream.
+#include <memory>       // std::unique_ptr.
+#include <stdexcept>    // std::out_of_range, std::runtime_error, std::logic_error.
+#include <thread>       // std::thread.
+#include <type_traits>  // std::is_trivially_copyable.
+#include <utility>      // std::pair, std::swap.
+#include <vector>       // std::vector.
+#include "hashtbl.h"    // ac::HashTbl, ac::HashEntry, ac::detail::mix64.
+
+namespace ac {
+
+namespace detail {
+
+//! \brief Number of bits set in a word.
+inline unsigned popcount64(uint64_t x) { return __builtin_popcountll(x); }
+
+//! \brief Runs fn(first, last) over [0, n) split in contiguous chunks, one per thread.
+template <typename Function>
+void parallel_for(size_t n, unsigned n_threads, Function fn) {
+        if (n_threads <= 1 || n < n_threads) {
+                fn(size_t(0), n);
+                return;
+        }
+
+        std::vector<std::thread> workers;
+        size_t chunk = (n + n_threads - 1) / n_threads;
+        for (unsigned t = 0; t < n_threads; t++) {
+                size_t first = t * chunk;
+                size_t last = std::min(n, first + chunk);
+                if (first >= last) break;
+                workers.emplace_back([=]() { fn(first, last); });
+        }
+        for (auto& w : workers) w.join();
+}
+
+}  // namespace detail
+
+//! \brief Minimal perfect hash function (BBHash style) over a fixed set of keys.
+//!
+//! Keys are mapped to [0, size()) without collisions by a cascade of bit arrays: a key lands on
+//! the first level where its bit is not shared with another key, and its index is the rank of that
+//! bit. With the default gamma it costs about 3 bits per key. Keys whose full 64 bits hash collide
+//! cannot be told apart by any hash, so they are kept in a small sorted fallback array and
+//! reported as a range of candidate slots.
+template <typename KeyType, typename KeyHash = std::hash<KeyType>>
+class PerfectHash {
+       public:
+        static constexpr size_t npos = size_t(-1);  //!< Returned when a key is not in the set.
+
+        //! \brief Constructs an empty function.
+        PerfectHash() : m_n_keys{0}, m_level_keys{0} {}
+
+        //! \brief Builds the function over the keys in [first, last). Keys must be unique.
+        //! \param first Iterator to the first key.
+        //! \param last Iterator past the last key.
+        //! \param gamma Space/time trade-off, bits per key on each level (>= 1).
+        //! \param n_threads Number of build threads (0 = hardware concurrency).
+        template <typename InputIt>
+        void build(InputIt first, InputIt last, double gamma = DEFAULT_GAMMA,
+                   unsigned n_threads = 0) {
+                std::vector<uint64_t> hashes;
+                for (; first != last; first++) hashes.push_back(hash_of(*first));
+                build_from_hashes(std::move(hashes), gamma, n_threads);
+        }
+
+        //! \brief Builds the function from the hashes of the keys, as returned by hash_of().
+        //! \param hashes Hashes of the keys.
+        //! \param gamma Space/time trade-off, bits per key on each level (>= 1).
+        //! \param n_threads Number of build threads (0 = hardware concurrency).
+        void build_from_hashes(std::vector<uint64_t> hashes, double gamma = DEFAULT_GAMMA,
+                               unsigned n_threads = 0);
+
+        //! \brief Hash used to place a key.
+        //! \param key_ Key to hash.
+        //! \return 64 bits hash of the key.
+        static uint64_t hash_of(const KeyType& key_) {
+                KeyHash hashFunc;  // Instantiate the "functor" for primary hash.
+                return detail::mix64(hashFunc(key_));
+        }
+
+        //! \brief Looks up the slots of a key.
+        //! \param key_ Key to look up.
+        //! \return Range [first, last) of candidate slots, a single one unless the key shares its
+        //! full hash with other keys. Keys out of the set may get any slot, or an empty range.
+        std::pair<size_t, size_t> lookup(const KeyType& key_) const {
+                return lookup_hash(hash_of(key_));
+        }
+
+        //! \brief Same as lookup(), from a hash returned by hash_of().
+        std::pair<size_t, size_t> lookup_hash(uint64_t hash_) const;
+
+        //! \brief Returns the slot of a key.
+        //! \param key_ Key to look up.
+        //! \return First candidate slot of the key or npos.
+        size_t operator()(const KeyType& key_) const {
+                auto range = lookup(key_);
+                return range.first == range.second ? npos : range.first;
+        }
+
+        //! \brief Returns the number of keys.
+        inline size_t size(void) const { return m_n_keys; }
+
+        //! \brief Returns the memory used by the function, in bits.
+        size_t bits(void) const;
+
+        //! \brief Writes the function in a binary format.
+        //! \param os Output stream (opened in binary mode).
+        void save(std::ostream& os) const;
+
+        //! \brief Reads a function written by save().
+        //! \param is Input stream (opened in binary mode).
+        //! \throw std::runtime_error
+        void load(std::istream& is);
+
+       private:
+        static constexpr double DEFAULT_GAMMA = 1.0;  //!< Default bits per key on each level.
+        static const unsigned MAX_LEVELS = 32;        //!< Levels before giving up to the fallback.
+        static const size_t RANK_WORDS = 8;           //!< Words between two rank samples.
+        static const size_t PARALLEL_MIN = 1 << 16;   //!< Keys needed to use more than one thread.
+        static const uint64_t MAGIC = 0x3148504d48534841ULL;  //!< "AHSHMPH1".
+
+        //! \brief One bit array of the cascade.
+        struct Level {
+                uint64_t m_seed;                //!< Seed mixed with the key hash.
+                std::vector<uint64_t> m_bits;   //!< Bit set for the keys placed in this level.
+                std::vector<uint64_t> m_ranks;  //!< Global rank before every RANK_WORDS words.
+        };
+
+        size_t m_n_keys;                   //!< Number of keys.
+        size_t m_level_keys;               //!< Number of keys placed by the levels.
+        std::vector<Level> m_levels;       //!< The cascade of bit arrays.
+        std::vector<uint64_t> m_fallback;  //!< Sorted hashes of the keys left out of the levels.
+
+        // \brief Position of a hash inside a level.
+        inline static size_t position(uint64_t hash_, const Level& level) {
+                return detail::mix64(hash_ ^ level.m_seed) % (level.m_bits.size() * 64);
+        }
+
+        // \brief Computes the rank samples of every level.
+        void compute_ranks(void);
+};
+
+template <typename KeyType, typename KeyHash>
+constexpr size_t PerfectHash<KeyType, KeyHash>::npos;
+
+template <typename KeyType, typename KeyHash>
+constexpr double PerfectHash<KeyType, KeyHash>::DEFAULT_GAMMA;
+
+template <typename KeyType, typename KeyHash>
+void PerfectHash<KeyType, KeyHash>::build_from_hashes(std::vector<uint64_t> hashes, double gamma,
+                                                       unsigned n_threads) {
+        if (gamma < 1) gamma = 1;
+        if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        m_n_keys = hashes.size();
+        m_levels.clear();
+        m_fallback.clear();
+
+        // Keys with the same full hash can never be separated: move them to the fallback.
+        std::sort(hashes.begin(), hashes.end());
+        std::vector<uint64_t> remaining;
+        remaining.reserve(hashes.size());
+        for (size_t i = 0; i < hashes.size();) {
+                size_t j = i + 1;
+                while (j < hashes.size() && hashes[j] == hashes[i]) j++;
+                if (j - i == 1) {
+                        remaining.push_back(hashes[i]);
+                } else {
+                        m_fallback.insert(m_fallback.end(), hashes.begin() + i, hashes.begin() + j);
+                }
+                i = j;
+        }
+        hashes.clear();
+        hashes.shrink_to_fit();
+
+        for (unsigned lvl = 0; lvl < MAX_LEVELS && !remaining.empty(); lvl++) {
+                Level level;
+                level.m_seed = detail::mix64(0x9e3779b97f4a7c15ULL * (lvl + 1));
+                size_t n_words = (size_t(gamma * remaining.size()) + 63) / 64;
+                level.m_bits.resize(std::max<size_t>(n_words, 1));
+                n_words = level.m_bits.size();
+
+                std::unique_ptr<std::atomic<uint64_t>[]> seen(new std::atomic<uint64_t>[n_words]());
+                std::unique_ptr<std::atomic<uint64_t>[]> collide(
+                    new std::atomic<uint64_t>[n_words]());
+                unsigned threads = remaining.size() < PARALLEL_MIN ? 1 : n_threads;
+
+                // First pass: mark every position, and the positions hit more than once.
+                detail::parallel_for(remaining.size(), threads, [&](size_t first, size_t last) {
+                        for (size_t i = first; i < last; i++) {
+                                size_t pos = position(remaining[i], level);
+                                uint64_t mask = uint64_t(1) << (pos % 64);
+                                uint64_t old =
+                                    seen[pos / 64].fetch_or(mask, std::memory_order_relaxed);
+                                if (old & mask) {
+                                        collide[pos / 64].fetch_or(mask, std::memory_order_relaxed);
+                                }
+                        }
+                });
+
+                // Only the positions hit by exactly one key are kept.
+                for (size_t w = 0; w < n_words; w++) {
+                        level.m_bits[w] = seen[w].load(std::memory_order_relaxed) &
+                                          ~collide[w].load(std::memory_order_relaxed);
+                }
+
+                // Second pass: the keys that collided go to the next level.
+                std::vector<std::vector<uint64_t>> next(threads);
+                std::atomic<unsigned> slot{0};
+                detail::parallel_for(remaining.size(), threads, [&](size_t first, size_t last) {
+                        auto& out = next[slot++];
+                        for (size_t i = first; i < last; i++) {
+                                size_t pos = position(remaining[i], level);
+                                if (!(level.m_bits[pos / 64] & (uint64_t(1) << (pos % 64)))) {
+                                        out.push_back(remaining[i]);
+                                }
+                        }
+                });
+
+                remaining.clear();
+                for (auto& part : next) remaining.insert(remaining.end(), part.begin(), part.end());
+                m_levels.push_back(std::move(level));
+        }
+
+        // Whatever the cascade could not place (very unlikely) also goes to the fallback.
+        m_fallback.insert(m_fallback.end(), remaining.begin(), remaining.end());
+        std::sort(m_fallback.begin(), m_fallback.end());
+        m_level_keys = m_n_keys - m_fallback.size();
+
+        compute_ranks();
+}
+
+template <typename KeyType, typename KeyHash>
+void PerfectHash<KeyType, KeyHash>::compute_ranks(void) {
+        uint64_t rank = 0;
+        for (auto& level : m_levels) {
+                level.m_ranks.clear();
+                for (size_t w = 0; w < level.m_bits.size(); w++) {
+                        if (w % RANK_WORDS == 0) level.m_ranks.push_back(rank);
+                        rank += detail::popcount64(level.m_bits[w]);
+                }
+        }
+}
+
+template <typename KeyType, typename KeyHash>
+std::pair<size_t, size_t> PerfectHash<KeyType, KeyHash>::lookup_hash(uint64_t hash_) const {
+        for (const auto& level : m_levels) {
+                size_t pos = position(hash_, level);
+                size_t word = pos / 64;
+                uint64_t mask = uint64_t(1) << (pos % 64);
+
+                if (level.m_bits[word] & mask) {
+                        // Rank = sample + bits set in the words and bits before pos.
+                        size_t rank = level.m_ranks[word / RANK_WORDS];
+                        for (size_t w = word - word % RANK_WORDS; w < word; w++) {
+                                rank += detail::popcount64(level.m_bits[w]);
+                        }
+                        rank += detail::popcount64(level.m_bits[word] & (mask - 1));
+
+                        return std::make_pair(rank, rank + 1);
+                }
+        }
+
+        auto first = std::lower_bound(m_fallback.begin(), m_fallback.end(), hash_);
+        auto last = std::upper_bound(first, m_fallback.end(), hash_);
+        size_t base = m_level_keys + (first - m_fallback.begin());
+
+        return std::make_pair(base, base + (last - first));
+}
+
+template <typename KeyType, typename KeyHash>
+size_t PerfectHash<KeyType, KeyHash>::bits(void) const {
+        size_t n_bits = 64 * m_fallback.size();
+        for (const auto& level : m_levels) {
+                n_bits += 64 * (level.m_bits.size() + level.m_ranks.size() + 1);
+        }
+
+        return n_bits;
+}
+
+template <typename KeyType, typename KeyHash>
+void PerfectHash<KeyType, KeyHash>::save(std::ostream& os) const {
+        auto write = [&os](uint64_t value) {
+                os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+
+        write(MAGIC);
+        write(m_n_keys);
+        write(m_levels.size());
+        for (const auto& level : m_levels) {
+                write(level.m_seed);
+                write(level.m_bits.size());
+                os.write(reinterpret_cast<const char*>(level.m_bits.data()),
+                         level.m_bits.size() * sizeof(uint64_t));
+        }
+        write(m_fallback.size());
+        os.write(reinterpret_cast<const char*>(m_fallback.data()),
+                 m_fallback.size() * sizeof(uint64_t));
+}
+
+template <typename KeyType, typename KeyHash>
+void PerfectHash<KeyType, KeyHash>::load(std::istream& is) {
+        auto read = [&is]() {
+                uint64_t value = 0;
+                is.read(reinterpret_cast<char*>(&value), sizeof(value));
+                if (!is) throw std::runtime_error("error: truncated perfect hash!\n");
+                return value;
+        };
+
+        // The sizes are not trusted: the words are read a chunk at a time, so that a corrupted size
+        // runs into the end of the stream instead of allocating all of it at once.
+        auto read_words = [&is](std::vector<uint64_t>& words, uint64_t n) {
+                const uint64_t CHUNK = 1 << 16;
+                words.clear();
+                for (uint64_t done = 0; done < n;) {
+                        uint64_t count = std::min(n - done, CHUNK);
+                        words.resize(done + count);
+                        is.read(reinterpret_cast<char*>(words.data() + done),
+                                count * sizeof(uint64_t));
+                        if (!is) throw std::runtime_error("error: truncated perfect hash!\n");
+                        done += count;
+                }
+        };
+        auto corrupted = []() { return std::runtime_error("error: corrupted perfect hash!\n"); };
+
+        if (read() != MAGIC) throw std::runtime_error("error: not a perfect hash!\n");
+
+        m_n_keys = read();
+        uint64_t n_levels = read();
+        if (n_levels > MAX_LEVELS) throw corrupted();
+        m_levels.resize(n_levels);
+        for (auto& level : m_levels) {
+                level.m_seed = read();
+                read_words(level.m_bits, read());
+                if (level.m_bits.empty()) throw corrupted();  // position() divides by its size.
+        }
+        read_words(m_fallback, read());
+        if (!std::is_sorted(m_fallback.begin(), m_fallback.end())) throw corrupted();
+
+        // Every key has one bit in the levels or one hash in the fallback.
+        compute_ranks();
+        uint64_t placed = 0;
+        for (const auto& level : m_levels) {
+                for (uint64_t word : level.m_bits) placed += detail::popcount64(word);
+        }
+        if (placed + m_fallback.size() != m_n_keys) throw corrupted();
+
+        m_level_keys = placed;
+}
+
+//! \brief Read-only hash table indexed by a minimal perfect hash.
+//!
+//! Entries live in a dense array, in the slot given by the perfect hash, so a lookup is a single
+//! probe followed by one key comparison. It is built once from a finished HashTbl or a range of
+//! entries, and cannot be changed afterwards.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class StaticHashTbl {
+       public:
+        using Entry = HashEntry<KeyType, DataType>;  //!< Alias to the data stored in the table.
+        using Index = PerfectHash<KeyType, KeyHash>;  //!< Alias to the perfect hash function.
+
+        //! \brief Constructs an empty table.
+        StaticHashTbl() {}
+
+        //! \brief Constructs the table with the contents of a hash table.
+        //! \param table Hash table to copy.
+        //! \param n_threads Number of build threads (0 = hardware concurrency).
+        explicit StaticHashTbl(const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& table,
+                               unsigned n_threads = 0);
+
+        //! \brief Constructs the table with the entries in [first, last). Keys must be unique.
+        //! \param first Iterator to the first entry.
+        //! \param last Iterator past the last entry.
+        //! \param n_threads Number of build threads (0 = hardware concurrency).
+        template <typename ForwardIt>
+        StaticHashTbl(ForwardIt first, ForwardIt last, unsigned n_threads = 0);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                const Entry* entry = find(key_);
+                if (entry == nullptr) return false;
+
+                data_item_ = entry->m_data;
+                return true;
+        }
+
+        //! \brief Access element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \throw std::out_of_range
+        //! \return Data associated to the key.
+        const DataType& at(const KeyType& key_) const {
+                const Entry* entry = find(key_);
+                if (entry == nullptr) throw std::out_of_range("error: index is out of range!\n");
+
+                return entry->m_data;
+        }
+
+        //! \brief Checks whether the table is empty
+        inline bool empty(void) const { return m_entries.empty(); }
+
+        //! \brief Returns the number of elements.
+        inline size_t size(void) const { return m_entries.size(); }
+
+        //! \brief Returns the perfect hash function of the table.
+        inline const Index& index(void) const { return m_index; }
+
+        //! \brief Writes the table in a binary format. Entries must be trivially copyable.
+        //! \param os Output stream (opened in binary mode).
+        void save(std::ostream& os) const {
+                static_assert(std::is_trivially_copyable<Entry>::value,
+                              "save() needs trivially copyable keys and data");
+                m_index.save(os);
+                os.write(reinterpret_cast<const char*>(m_entries.data()),
+                         m_entries.size() * sizeof(Entry));
+        }
+
+        //! \brief Reads a table written by save().
+        //! \param is Input stream (opened in binary mode).
+        //! \throw std::runtime_error
+        void load(std::istream& is) {
+                static_assert(std::is_trivially_copyable<Entry>::value,
+                              "load() needs trivially copyable keys and data");
+                m_index.load(is);  // Its size matches the bits it read, so it can be trusted.
+                m_entries.assign(m_index.size(), Entry(KeyType(), DataType()));
+                is.read(reinterpret_cast<char*>(m_entries.data()),
+                        m_entries.size() * sizeof(Entry));
+                if (!is) throw std::runtime_error("error: truncated hash table!\n");
+        }
+
+       private:
+        Index m_index;                 //!< Maps every key to its slot.
+        std::vector<Entry> m_entries;  //!< Entries, in the slot given by m_index.
+
+        // \brief Locates the entry of a key.
+        // \return Pointer to the entry or nullptr.
+        const Entry* find(const KeyType& key_) const {
+                KeyEqual equalFunc;  // Instantiate the "functor" for the equal to test.
+                auto range = m_index.lookup(key_);
+
+                for (size_t i = range.first; i < range.second && i < m_entries.size(); i++) {
+                        if (true == equalFunc(m_entries[i].m_key, key_)) return &m_entries[i];
+                }
+
+                return nullptr;
+        }
+
+        // \brief Builds the index over m_entries and moves them to their slots.
+        // \param hashes Hashes of the keys of m_entries.
+        void build(std::vector<uint64_t> hashes, unsigned n_threads);
+};
+
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
+StaticHashTbl<KeyType, DataType, KeyHash, KeyEqual>::StaticHashTbl(
+    const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& table, unsigned n_threads) {
+        std::vector<uint64_t> hashes;
+        hashes.reserve(table.size());
+        m_entries.reserve(table.size());
+        table.for_each([&](const KeyType& k, const DataType& d) {
+                m_entries.emplace_back(k, d);
+                hashes.push_back(Index::hash_of(k));
+        });
+
+        build(std::move(hashes), n_threads);
+}
+
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
+template <typename ForwardIt>
+StaticHashTbl<KeyType, DataType, KeyHash, KeyEqual>::StaticHashTbl(ForwardIt first, ForwardIt last,
+                                                                   unsigned n_threads) {
+        std::vector<uint64_t> hashes;
+        for (; first != last; first++) {
+                m_entries.push_back(*first);
+                hashes.push_back(Index::hash_of((*first).m_key));
+        }
+
+        build(std::move(hashes), n_threads);
+}
+
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
+void StaticHashTbl<KeyType, DataType, KeyHash, KeyEqual>::build(std::vector<uint64_t> hashes,
+                                                                unsigned n_threads) {
+        m_index.build_from_hashes(hashes, 1.0, n_threads);
+
+        // Find the slot of every entry, reusing the memory of the hashes.
+        std::vector<bool> taken(hashes.size());
+        for (auto& h : hashes) {
+                auto range = m_index.lookup_hash(h);
+                size_t s = range.first;
+                while (s < range.second && taken[s]) s++;  // Only for keys sharing their full hash.
+                if (s == range.second) throw std::logic_error("error: no slot left for a key!\n");
+                taken[s] = true;
+                h = s;
+        }
+
+        // Then move the entries to their slots, one cycle of the permutation at a time.
+        for (size_t i = 0; i < hashes.size(); i++) {
+                while (hashes[i] != i) {
+                        size_t s = hashes[i];
+                        std::swap(m_entries[i], m_entries[s]);
+                        std::swap(hashes[i], hashes[s]);
+                }
+        }
+}
+
+}  // namespace ac
+
+#endif
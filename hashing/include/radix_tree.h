@@ -0,0 +1,263 @@
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <algorithm>  // std::lower_bound, std::mismatch.
+#include <memory>     // std::unique_ptr.
+#include <optional>   // std::optional.
+#include <string>     // std::string.
+#include <utility>    // std::move.
+#include <vector>     // std::vector.
+
+namespace ac {
+
+//! \brief Map from strings to values, stored in a radix tree (a compressed trie).
+//!
+//! Each edge holds a whole run of characters, so every inner node without a value has two
+//! children at least and the tree has fewer than 2n nodes for n keys. The children of a node are
+//! kept sorted by their first character: the keys are visited in the order of std::string, and a
+//! prefix query costs the length of the prefix plus the size of the subtree it walks, which is
+//! proportional to the number of keys it returns. Only the nodes where a key ends construct a
+//! value: inner nodes hold an empty std::optional.
+template <typename ValueType>
+class RadixTree {
+       public:
+        //! \brief Constructs an empty tree.
+        RadixTree() : m_root{new Node}, m_count{0}, m_nodes{1} {}
+
+        //! \brief Access or insert the value associated to a key.
+        //! \param key_ Key associated to the value.
+        //! \return Value associated to the key (default constructed if it was not there).
+        ValueType& operator[](const std::string& key_);
+
+        //! \brief Inserts a value associated to a key.
+        //! \param key_ Key associated to the value.
+        //! \param value Value to insert.
+        //! \return True if the key was not in the tree, false otherwise.
+        bool insert(const std::string& key_, const ValueType& value) {
+                size_t count = m_count;
+                (*this)[key_] = value;
+                return m_count != count;
+        }
+
+        //! \brief Erases the value associated to a key.
+        //! \param key_ Key to erase.
+        //! \return True if erased, false otherwise.
+        bool erase(const std::string& key_) {
+                if (!erase(*m_root, key_, 0)) return false;
+
+                m_count--;
+                return true;
+        }
+
+        //! \brief Locates the value associated to a key.
+        //! \param key_ Key associated to the value.
+        //! \return Pointer to the value, or nullptr if the key is not in the tree.
+        const ValueType* find(const std::string& key_) const {
+                size_t start;
+                const Node* node = descend(key_, start);
+                if (node == nullptr || !node->m_value) return nullptr;
+                if (start + node->m_label.size() != key_.size()) return nullptr;
+
+                return &*node->m_value;
+        }
+
+        //! \brief Applies a function to the first keys (in sorted order) having a prefix.
+        //! \param prefix Prefix of the keys.
+        //! \param k Largest number of keys visited.
+        //! \param fn Function called as fn(key, value).
+        //! \return Number of keys visited.
+        template <typename Function>
+        size_t for_each_prefix(const std::string& prefix, size_t k, Function fn) const {
+                size_t start;
+                const Node* node = descend(prefix, start);
+                if (node == nullptr || k == 0) return 0;
+
+                // The prefix may end inside the edge to node: the keys go on with the whole edge.
+                std::string key = prefix.substr(0, start) + node->m_label;
+                size_t visited = 0;
+                walk(*node, key, k, visited, fn);
+                return visited;
+        }
+
+        //! \brief Applies a function to every key, in sorted order.
+        //! \param fn Function called as fn(key, value).
+        template <typename Function>
+        void for_each(Function fn) const {
+                std::string key;
+                size_t visited = 0;
+                walk(*m_root, key, size_t(-1), visited, fn);
+        }
+
+        //! \brief Clears the contents.
+        inline void clear(void) {
+                m_root.reset(new Node);
+                m_count = 0;
+                m_nodes = 1;
+        }
+
+        //! \brief Checks whether the tree is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_count == 0; }
+
+        //! \brief Returns the number of keys
+        //! \return Number of keys.
+        inline size_t size(void) const { return m_count; }
+
+        //! \brief Returns the number of nodes, the root included.
+        inline size_t node_count(void) const { return m_nodes; }
+
+       private:
+        //! \brief Node of the tree; the label is the run of characters of the edge leading to it.
+        struct Node {
+                std::string m_label;                            //!< Characters of the edge.
+                std::vector<std::unique_ptr<Node>> m_children;  //!< Sorted by first character.
+                std::optional<ValueType> m_value;               //!< Value of the key ending here.
+
+                // \brief Returns the position of the child starting with c, or where it goes.
+                size_t child_index(char c) const {
+                        auto it = std::lower_bound(
+                            m_children.begin(), m_children.end(), c,
+                            [](const std::unique_ptr<Node>& n, char c_) {
+                                    return (unsigned char)n->m_label[0] < (unsigned char)c_;
+                            });
+                        return it - m_children.begin();
+                }
+
+                // \brief Returns the child starting with c, or nullptr.
+                Node* child(char c) const {
+                        size_t i = child_index(c);
+                        if (i < m_children.size() && m_children[i]->m_label[0] == c) {
+                                return m_children[i].get();
+                        }
+                        return nullptr;
+                }
+        };
+
+        std::unique_ptr<Node> m_root;  //!< Root, with an empty label.
+        size_t m_count;                //!< Number of keys.
+        size_t m_nodes;                //!< Number of nodes.
+
+        // \brief Follows a string from the root as far as it goes.
+        // \param start Position in s where the label of the result begins (out).
+        // \return Node whose edge covers the end of the string, or nullptr on a mismatch.
+        const Node* descend(const std::string& s, size_t& start) const {
+                const Node* node = m_root.get();
+                size_t depth = 0;
+                start = 0;
+                while (depth < s.size()) {
+                        node = node->child(s[depth]);
+                        if (node == nullptr) return nullptr;
+
+                        const std::string& label = node->m_label;
+                        size_t n = std::min(label.size(), s.size() - depth);
+                        if (label.compare(0, n, s, depth, n) != 0) return nullptr;
+                        start = depth;
+                        depth += n;
+                }
+                return node;
+        }
+
+        // \brief Visits the keys of a subtree in order, stopping after k of them.
+        template <typename Function>
+        static void walk(const Node& node, std::string& key, size_t k, size_t& visited,
+                         Function& fn) {
+                if (node.m_value) {
+                        fn(key, *node.m_value);
+                        visited++;
+                }
+
+                for (const auto& child : node.m_children) {
+                        if (visited == k) return;
+
+                        key += child->m_label;
+                        walk(*child, key, k, visited, fn);
+                        key.resize(key.size() - child->m_label.size());
+                }
+        }
+
+        // \brief Erases a key below a node, merging the nodes left with a single child.
+        // \return True if the key was found.
+        bool erase(Node& node, const std::string& key_, size_t depth);
+};
+
+template <typename ValueType>
+ValueType& RadixTree<ValueType>::operator[](const std::string& key_) {
+        Node* node = m_root.get();
+        size_t depth = 0;
+
+        while (depth < key_.size()) {
+                size_t i = node->child_index(key_[depth]);
+                auto& children = node->m_children;
+                if (i == children.size() || children[i]->m_label[0] != key_[depth]) {
+                        // No edge starts with this character: a new leaf takes the rest of the key.
+                        std::unique_ptr<Node> leaf(new Node);
+                        leaf->m_label = key_.substr(depth);
+                        children.insert(children.begin() + i, std::move(leaf));
+                        node = children[i].get();
+                        m_nodes++;
+                        break;
+                }
+
+                const std::string& label = children[i]->m_label;
+                auto diff = std::mismatch(label.begin(), label.end(), key_.begin() + depth,
+                                          key_.end());
+                size_t n = diff.first - label.begin();
+
+                if (n < label.size()) {
+                        // The key leaves the edge midway: split it at the first difference.
+                        std::unique_ptr<Node> middle(new Node);
+                        middle->m_label = label.substr(0, n);
+                        std::unique_ptr<Node> rest = std::move(children[i]);
+                        rest->m_label.erase(0, n);
+                        middle->m_children.push_back(std::move(rest));
+                        children[i] = std::move(middle);
+                        m_nodes++;
+                }
+
+                node = children[i].get();
+                depth += n;
+        }
+
+        if (!node->m_value) {
+                node->m_value.emplace();
+                m_count++;
+        }
+
+        return *node->m_value;
+}
+
+template <typename ValueType>
+bool RadixTree<ValueType>::erase(Node& node, const std::string& key_, size_t depth) {
+        if (depth == key_.size()) {
+                if (!node.m_value) return false;
+
+                node.m_value.reset();
+                return true;
+        }
+
+        size_t i = node.child_index(key_[depth]);
+        if (i == node.m_children.size()) return false;
+
+        Node& child = *node.m_children[i];
+        const std::string& label = child.m_label;
+        if (label.compare(0, label.size(), key_, depth, label.size()) != 0) return false;
+        if (!erase(child, key_, depth + label.size())) return false;
+
+        if (!child.m_value && child.m_children.empty()) {
+                // The child holds nothing any more.
+                node.m_children.erase(node.m_children.begin() + i);
+                m_nodes--;
+        } else if (!child.m_value && child.m_children.size() == 1) {
+                // The child only links its parent to its own child: merge the two edges.
+                std::unique_ptr<Node> grandchild = std::move(child.m_children[0]);
+                grandchild->m_label.insert(0, child.m_label);
+                node.m_children[i] = std::move(grandchild);
+                m_nodes--;
+        }
+
+        return true;
+}
+
+}  // namespace ac
+
+#endif
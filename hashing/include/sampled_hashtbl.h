@@ -0,0 +1,182 @@
+#ifndef SAMPLED_HASHTBL_H
+#define SAMPLED_HASHTBL_H
+
+#include <algorithm>   // std::min.
+#include <cstdint>     // uint64_t.
+#include <functional>  // std::hash, std::equal_to.
+#include <vector>      // std::vector.
+#include "hashtbl.h"   // ac::HashTbl.
+#include "hot_keys.h"  // ac::CountMinSketch, ac::SpaceSaving.
+
+namespace ac {
+
+//! \brief Hash table that samples its accesses to find the hot keys.
+//!
+//! One lookup (retrieve, find, at or operator[]) in every `period` is recorded in a Count-Min
+//! sketch, which estimates the frequency of any key, and in a Space-Saving summary, which keeps
+//! the k most frequent. The other lookups only decrement a counter, so the sampling costs next to
+//! nothing on the hot path. Frequencies are reported in accesses, scaled back by the period.
+//!
+//! The HashTbl is a member, not a base: a lookup through a HashTbl reference would not be
+//! sampled. Lookups update the sampling state, even the const ones: the table must not be read
+//! from several threads at once.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class SampledHashTbl {
+       public:
+        using Table = HashTbl<KeyType, DataType, KeyHash, KeyEqual>;  //!< Table sampled.
+
+        //! \brief Hot key, with its estimated number of accesses.
+        struct HotKey {
+                KeyType m_key;         //!< Key accessed.
+                uint64_t m_frequency;  //!< Estimated accesses, from above.
+                uint64_t m_error;      //!< Largest overestimation of m_frequency.
+        };
+
+        //! \brief Constructs an empty table.
+        //! \param period One lookup in period is sampled; 0 disables the sampling.
+        //! \param k Number of hot keys tracked.
+        explicit SampledHashTbl(size_t period = DEFAULT_PERIOD, size_t k = DEFAULT_K)
+            : m_period{period}, m_countdown{countdown(period)}, m_top(k) {}
+
+        //! \brief Access or insert element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return Data associated to the key.
+        DataType& operator[](const KeyType& key_) {
+                sample(key_);
+                return m_table[key_];
+        }
+
+        //! \brief Inserts data associated to a key (not a lookup: it is not sampled).
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if the key was not in the table, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_) {
+                return m_table.insert(key_, data_item_);
+        }
+
+        //! \brief Erases data associated to a key (not a lookup: it is not sampled).
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_) { return m_table.erase(key_); }
+
+        //! \brief Access element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \throw std::out_of_range
+        //! \return Data associated to the key.
+        DataType& at(const KeyType& key_) {
+                sample(key_);
+                return m_table.at(key_);
+        }
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                sample(key_);
+                return m_table.retrieve(key_, data_item_);
+        }
+
+        //! \brief Locates the data associated to a key, without copying it.
+        //! \param key_ Key associated to data.
+        //! \return Pointer to the data, or nullptr if the key is not in the table.
+        const DataType* find(const KeyType& key_) const {
+                sample(key_);
+                return m_table.find(key_);
+        }
+
+        //! \brief Clears the contents; the accesses sampled so far are kept.
+        inline void clear(void) { m_table = Table(); }
+
+        //! \brief Checks whether the hash table is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_table.empty(); }
+
+        //! \brief Returns the number of elements
+        //! \return Number of elements.
+        inline size_t size(void) const { return m_table.size(); }
+
+        //! \brief Applies a function to every entry of the table (not sampled).
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                m_table.for_each(fn);
+        }
+
+        //! \brief Returns the table itself, for reads that must not be sampled.
+        inline const Table& unsampled(void) const { return m_table; }
+
+        //! \brief Changes the sampling period, and starts the sampling over.
+        //! \param period One lookup in period is sampled; 0 disables the sampling.
+        void set_period(size_t period) {
+                m_period = period;
+                m_countdown = countdown(period);
+                reset_sampling();
+        }
+
+        //! \brief Returns the sampling period (0 if disabled).
+        inline size_t period(void) const { return m_period; }
+
+        //! \brief Forgets the accesses sampled so far.
+        void reset_sampling(void) {
+                m_sketch.clear();
+                m_top.clear();
+        }
+
+        //! \brief Returns the hottest keys, the most accessed first.
+        //! \return Up to k keys, with their estimated accesses.
+        std::vector<HotKey> heavy_hitters(void) const {
+                std::vector<HotKey> hot;
+                for (const auto& counter : m_top.top()) {
+                        // Both structures overestimate: the smaller count is the better one.
+                        uint64_t count = std::min<uint64_t>(counter.m_count,
+                                                            m_sketch.estimate(counter.m_key));
+                        hot.push_back(HotKey{counter.m_key, count * m_period,
+                                             counter.m_error * m_period});
+                }
+                return hot;
+        }
+
+        //! \brief Estimates the accesses to a key, from above.
+        //! \param key_ Key to estimate.
+        //! \return Estimated accesses.
+        uint64_t estimate(const KeyType& key_) const {
+                return uint64_t(m_sketch.estimate(key_)) * m_period;
+        }
+
+        //! \brief Returns the number of lookups sampled.
+        inline uint64_t samples(void) const { return m_sketch.total(); }
+
+       private:
+        static const size_t DEFAULT_PERIOD = 64;  //!< Default sampling period.
+        static const size_t DEFAULT_K = 16;       //!< Default number of hot keys.
+
+        Table m_table;                                      //!< Entries.
+        size_t m_period;                                    //!< Sampling period.
+        mutable size_t m_countdown;                         //!< Lookups before the next sample.
+        mutable CountMinSketch<KeyType, KeyHash> m_sketch;  //!< Frequencies of the keys.
+        mutable SpaceSaving<KeyType, KeyEqual> m_top;       //!< Hottest keys.
+
+        // \brief Lookups before the first sample; with the sampling disabled, as good as never.
+        static size_t countdown(size_t period) { return period == 0 ? size_t(-1) : period; }
+
+        // \brief Counts a lookup, and records it if it is the one sampled.
+        // A bare decrement, with no test for the disabled case: this is all a lookup pays.
+        inline void sample(const KeyType& key_) const {
+                if (--m_countdown == 0) record(key_);
+        }
+
+        // \brief Records a sampled lookup.
+        void record(const KeyType& key_) const {
+                m_countdown = countdown(m_period);
+                if (m_period == 0) return;
+
+                m_sketch.add(key_);
+                m_top.add(key_);
+        }
+};
+
+}  // namespace ac
+
+#endif
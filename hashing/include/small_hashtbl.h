@@ -0,0 +1,279 @@
+#ifndef SMALL_HASHTBL_H
+#define SMALL_HASHTBL_H
+
+#include <functional>   // std::hash, std::equal_to.
+#include <memory>       // std::unique_ptr.
+#include <new>          // placement new.
+#include <stdexcept>    // std::out_of_range
+#include <type_traits>  // std::aligned_storage, std::is_nothrow_move_constructible.
+#include <utility>      // std::move.
+#include "hashtbl.h"    // ac::HashTbl.
+
+namespace ac {
+
+//! \brief Hash table that keeps up to N elements inside the object itself.
+//!
+//! While the table holds at most N elements, keys and data live in two arrays inside the object
+//! and a lookup is a linear scan of the keys: no hashing and no heap allocation at all. Inserting
+//! the (N + 1)-th element moves everything to a HashTbl on the heap, which is kept until clear().
+//! The keys are stored apart from the data, so the scan touches as few cache lines as possible.
+template <typename KeyType, typename DataType, size_t N = 8, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class SmallHashTbl {
+       public:
+        using Table = HashTbl<KeyType, DataType, KeyHash, KeyEqual>;  //!< Storage past N elements.
+
+        static_assert(N > 0, "SmallHashTbl needs room for one element at least");
+
+        //! \brief Constructs an empty hash table.
+        SmallHashTbl() : m_count{0} {}
+
+        //! \brief Constructs the hash table with values from a std::initializer_list.
+        //! \param ilist List of elements.
+        SmallHashTbl(std::initializer_list<typename Table::Entry> ilist) : m_count{0} {
+                for (auto& value : ilist) this->insert(value.m_key, value.m_data);
+        }
+
+        //! \brief Constructs a copy of a hash table given by argument.
+        //! \param other Hash table to copy.
+        SmallHashTbl(const SmallHashTbl& other) : m_count{0} { *this = other; }
+
+        //! \brief Constructs a hash table with the contents of another, which is left empty. The
+        //! heap table is taken over, and the inline elements are moved.
+        //! \param other Hash table to move.
+        SmallHashTbl(SmallHashTbl&& other) noexcept(NOTHROW_MOVE) : m_count{0} { steal(other); }
+
+        //! \brief Destructs the hash table.
+        ~SmallHashTbl() { destroy_inline(); }
+
+        //! \brief Assigns values from a hash table.
+        //! \param other Hash table to copy.
+        //! \return Object itself.
+        SmallHashTbl& operator=(const SmallHashTbl& other);
+
+        //! \brief Moves the contents of a hash table, which is left empty.
+        //! \param other Hash table to move.
+        //! \return Object itself.
+        SmallHashTbl& operator=(SmallHashTbl&& other) noexcept(NOTHROW_MOVE) {
+                if (this != &other) {
+                        clear();
+                        steal(other);
+                }
+                return *this;
+        }
+
+        //! \brief Access or insert element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return Data associated to the key.
+        DataType& operator[](const KeyType& key_);
+
+        //! \brief Inserts data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if the key was not in the table, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_);
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise.
+        bool erase(const KeyType& key_);
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise.
+        bool retrieve(const KeyType& key_, DataType& data_item_) const {
+                if (m_heap) return m_heap->retrieve(key_, data_item_);
+
+                size_t i = find(key_);
+                if (i == m_count) return false;
+
+                data_item_ = data(i);
+                return true;
+        }
+
+        //! \brief Access element associated to a key.
+        //! \param key_ Key associated to data.
+        //! \throw std::out_of_range
+        //! \return Data associated to the key.
+        DataType& at(const KeyType& key_) {
+                if (m_heap) return m_heap->at(key_);
+
+                size_t i = find(key_);
+                if (i == m_count) throw std::out_of_range("error: index is out of range!\n");
+
+                return data(i);
+        }
+
+        //! \brief Clears the contents, going back to the inline storage.
+        inline void clear(void) {
+                destroy_inline();
+                m_heap.reset();
+        }
+
+        //! \brief Checks whether the hash table is empty
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return size() == 0; }
+
+        //! \brief Returns the number of elements
+        //! \return Number of elements.
+        inline size_t size(void) const { return m_heap ? m_heap->size() : m_count; }
+
+        //! \brief Checks whether the elements are still stored inside the object.
+        inline bool is_inline(void) const { return !m_heap; }
+
+        //! \brief Applies a function to every entry of the table.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                if (m_heap) return m_heap->for_each(fn);
+
+                for (size_t i = 0; i < m_count; i++) fn(key(i), data(i));
+        }
+
+       private:
+        //! \brief True if moving the inline elements cannot throw.
+        static constexpr bool NOTHROW_MOVE = std::is_nothrow_move_constructible<KeyType>::value &&
+                                             std::is_nothrow_move_constructible<DataType>::value;
+
+        using KeySlot = typename std::aligned_storage<sizeof(KeyType), alignof(KeyType)>::type;
+        using DataSlot = typename std::aligned_storage<sizeof(DataType), alignof(DataType)>::type;
+
+        size_t m_count;                 //!< Number of elements stored inline.
+        KeySlot m_keys[N];              //!< Inline keys (the first m_count are constructed).
+        DataSlot m_data[N];             //!< Inline data, in the same order as the keys.
+        std::unique_ptr<Table> m_heap;  //!< Storage past N elements, or null.
+
+        // \brief Inline key at position i.
+        inline KeyType& key(size_t i) { return *reinterpret_cast<KeyType*>(&m_keys[i]); }
+        inline const KeyType& key(size_t i) const {
+                return *reinterpret_cast<const KeyType*>(&m_keys[i]);
+        }
+
+        // \brief Inline data at position i.
+        inline DataType& data(size_t i) { return *reinterpret_cast<DataType*>(&m_data[i]); }
+        inline const DataType& data(size_t i) const {
+                return *reinterpret_cast<const DataType*>(&m_data[i]);
+        }
+
+        // \brief Returns the inline position of a key, or m_count if it is not there.
+        size_t find(const KeyType& key_) const {
+                KeyEqual equalFunc;  // Instantiate the "functor" for the equal to test.
+                size_t i = 0;
+                while (i < m_count && !equalFunc(key(i), key_)) i++;
+
+                return i;
+        }
+
+        // \brief Appends an inline element known not to be in the table.
+        // \return Position of the element.
+        size_t append(const KeyType& key_, const DataType& data_item_) {
+                new (&m_keys[m_count]) KeyType(key_);
+                new (&m_data[m_count]) DataType(data_item_);
+
+                return m_count++;
+        }
+
+        // \brief Destroys the inline elements.
+        void destroy_inline(void) {
+                for (size_t i = 0; i < m_count; i++) {
+                        key(i).~KeyType();
+                        data(i).~DataType();
+                }
+                m_count = 0;
+        }
+
+        // \brief Takes the elements of another table, empty and inline itself, leaving it empty.
+        void steal(SmallHashTbl& other) noexcept(NOTHROW_MOVE) {
+                m_heap = std::move(other.m_heap);
+                for (size_t i = 0; i < other.m_count; i++) {
+                        new (&m_keys[i]) KeyType(std::move(other.key(i)));
+                        new (&m_data[i]) DataType(std::move(other.data(i)));
+                        m_count++;
+                }
+                other.destroy_inline();
+        }
+
+        // \brief Moves the inline elements to a hash table on the heap.
+        void spill(void);
+};
+
+template <class KeyType, class DataType, size_t N, class KeyHash, class KeyEqual>
+SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>&
+SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>::operator=(const SmallHashTbl& other) {
+        if (this == &other) return *this;
+
+        clear();
+        if (other.m_heap) {
+                m_heap.reset(new Table(*other.m_heap));
+        } else {
+                for (size_t i = 0; i < other.m_count; i++) append(other.key(i), other.data(i));
+        }
+
+        return *this;
+}
+
+template <class KeyType, class DataType, size_t N, class KeyHash, class KeyEqual>
+DataType& SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>::operator[](const KeyType& key_) {
+        if (!m_heap) {
+                size_t i = find(key_);
+                if (i < m_count) return data(i);
+                if (m_count < N) return data(append(key_, DataType()));
+
+                spill();
+        }
+
+        return (*m_heap)[key_];
+}
+
+template <class KeyType, class DataType, size_t N, class KeyHash, class KeyEqual>
+bool SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>::insert(const KeyType& key_,
+                                                                   const DataType& data_item_) {
+        if (!m_heap) {
+                size_t i = find(key_);
+                if (i < m_count) {
+                        data(i) = data_item_;
+                        return false;
+                }
+                if (m_count < N) {
+                        append(key_, data_item_);
+                        return true;
+                }
+
+                spill();
+        }
+
+        return m_heap->insert(key_, data_item_);
+}
+
+template <class KeyType, class DataType, size_t N, class KeyHash, class KeyEqual>
+bool SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+        if (m_heap) return m_heap->erase(key_);
+
+        size_t i = find(key_);
+        if (i == m_count) return false;
+
+        // The last element fills the hole.
+        m_count--;
+        if (i != m_count) {
+                key(i) = std::move(key(m_count));
+                data(i) = std::move(data(m_count));
+        }
+        key(m_count).~KeyType();
+        data(m_count).~DataType();
+
+        return true;
+}
+
+template <class KeyType, class DataType, size_t N, class KeyHash, class KeyEqual>
+void SmallHashTbl<KeyType, DataType, N, KeyHash, KeyEqual>::spill() {
+        std::unique_ptr<Table> table(new Table(2 * N));
+        for (size_t i = 0; i < m_count; i++) table->insert(key(i), data(i));
+
+        destroy_inline();
+        m_heap = std::move(table);
+}
+
+}  // namespace ac
+
+#endif
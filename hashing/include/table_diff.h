@@ -0,0 +1,179 @@
+#ifndef TABLE_DIFF_H
+#define TABLE_DIFF_H
+
+#include <algorithm>   // std::min, std::max.
+#include <atomic>      // std::atomic.
+#include <exception>   // std::exception_ptr.
+#include <functional>  // std::equal_to.
+#include <mutex>       // std::mutex, std::lock_guard.
+#include <thread>      // std::thread.
+#include <utility>     // std::pair.
+#include <vector>      // std::vector.
+#include "hashtbl.h"   // ac::HashTbl.
+
+namespace ac {
+
+//! \brief Kind of change of a key between two tables.
+enum class Change {
+        ADDED,    //!< Only in the table after.
+        REMOVED,  //!< Only in the table before.
+        CHANGED   //!< In both, with different data.
+};
+
+//! \brief Keys added, removed and changed between two tables, in no particular order.
+template <typename KeyType>
+struct TableDiff {
+        std::vector<KeyType> m_added;    //!< Keys only in the table after.
+        std::vector<KeyType> m_removed;  //!< Keys only in the table before.
+        std::vector<KeyType> m_changed;  //!< Keys in both, with different data.
+};
+
+namespace detail {
+
+//! \brief Changes found by one worker, handed to the sink in batches.
+template <typename KeyType, typename Sink>
+class ChangeBuffer {
+       public:
+        ChangeBuffer(Sink& sink, std::mutex& mutex) : m_sink(sink), m_mutex(mutex) {}
+
+        void push(Change change, const KeyType& key) {
+                m_changes.emplace_back(change, key);
+                if (m_changes.size() == BATCH) flush();
+        }
+
+        void flush(void) {
+                if (m_changes.empty()) return;
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (const auto& c : m_changes) m_sink(c.first, c.second);
+                m_changes.clear();
+        }
+
+       private:
+        static const size_t BATCH = 1024;  //!< Changes per call to the sink.
+
+        Sink& m_sink;                                       //!< Receiver of the changes.
+        std::mutex& m_mutex;                                //!< Serializes the sink.
+        std::vector<std::pair<Change, KeyType>> m_changes;  //!< Changes not handed yet.
+};
+
+}  // namespace detail
+
+//! \brief Equality of data that the diffs use by default: operator==, unless specialized for a
+//! type whose operator== leaves out some of its data.
+template <typename DataType>
+struct DataEqual : std::equal_to<DataType> {};
+
+//! \brief Finds the keys added, removed and changed from one table to another, in parallel.
+//!
+//! The buckets are split into chunks, and the workers take the chunks one after the other. A
+//! bucket holds one range of hashes (those equal to it modulo the bucket count). When both tables
+//! have the same bucket count, bucket i of one is compared with bucket i of the other, with no
+//! hashing at all. Otherwise the keys of each bucket are looked up in the other table.
+//!
+//! Both tables are only read: they must not change during the call.
+//! \param before Table before the changes.
+//! \param after Table after the changes.
+//! \param fn Function called as fn(Change, key) for each change, by one thread at a time.
+//! \param n_threads Number of workers (0 for one per hardware thread).
+//! \param data_equal Equality of data, which tells changed entries apart.
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual,
+          typename Function, typename Equal = DataEqual<DataType>>
+void for_each_change(const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& before,
+                     const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& after, Function fn,
+                     size_t n_threads = 0, Equal data_equal = Equal()) {
+        const size_t CHUNK = 4096;  // Buckets per chunk.
+
+        using Table = HashTbl<KeyType, DataType, KeyHash, KeyEqual>;
+        if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+        bool aligned = before.bucket_count() == after.bucket_count();
+        size_t n_buckets = std::max(before.bucket_count(), after.bucket_count());
+        size_t n_chunks = (n_buckets + CHUNK - 1) / CHUNK;
+
+        KeyEqual key_equal;
+        std::atomic<size_t> next_chunk{0};
+        std::mutex sink_mutex, error_mutex;
+        std::exception_ptr error;
+
+        // \brief Locates a key in bucket i of a table.
+        auto in_bucket = [&](const Table& table, size_t i, const KeyType& key) -> const DataType* {
+                for (auto it = table.cbegin(i); it != table.cend(i); ++it) {
+                        if (key_equal(it->m_key, key)) return &it->m_data;
+                }
+                return nullptr;
+        };
+
+        // \brief Compares the keys of buckets [first, last) of a table with the other table.
+        auto compare = [&](const Table& table, const Table& other, size_t first, size_t last,
+                           bool from_before, auto& changes) {
+                last = std::min(last, table.bucket_count());
+                for (size_t i = first; i < last; i++) {
+                        for (auto it = table.cbegin(i); it != table.cend(i); ++it) {
+                                const DataType* data = aligned ? in_bucket(other, i, it->m_key)
+                                                               : other.find(it->m_key);
+                                if (data == nullptr) {
+                                        changes.push(from_before ? Change::REMOVED : Change::ADDED,
+                                                     it->m_key);
+                                } else if (from_before && !data_equal(it->m_data, *data)) {
+                                        changes.push(Change::CHANGED, it->m_key);
+                                }
+                        }
+                }
+        };
+
+        auto worker = [&]() {
+                try {
+                        detail::ChangeBuffer<KeyType, Function> changes(fn, sink_mutex);
+                        for (size_t c; (c = next_chunk++) < n_chunks;) {
+                                compare(before, after, c * CHUNK, (c + 1) * CHUNK, true, changes);
+                                compare(after, before, c * CHUNK, (c + 1) * CHUNK, false, changes);
+                        }
+                        changes.flush();
+                } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error) error = std::current_exception();
+                        next_chunk = n_chunks;  // Stop the other workers early.
+                }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < std::min(n_threads, n_chunks); t++) workers.emplace_back(worker);
+        worker();
+        for (auto& w : workers) w.join();
+
+        if (error) std::rethrow_exception(error);
+}
+
+//! \brief Finds the keys added, removed and changed from one table to another, in parallel.
+//! \param before Table before the changes.
+//! \param after Table after the changes.
+//! \param n_threads Number of workers (0 for one per hardware thread).
+//! \param data_equal Equality of data, which tells changed entries apart.
+//! \return The three sets of keys.
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual,
+          typename Equal = DataEqual<DataType>>
+TableDiff<KeyType> diff(const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& before,
+                        const HashTbl<KeyType, DataType, KeyHash, KeyEqual>& after,
+                        size_t n_threads = 0, Equal data_equal = Equal()) {
+        TableDiff<KeyType> result;
+        auto collect = [&](Change change, const KeyType& key) {
+                switch (change) {
+                        case Change::ADDED:
+                                result.m_added.push_back(key);
+                                break;
+                        case Change::REMOVED:
+                                result.m_removed.push_back(key);
+                                break;
+                        case Change::CHANGED:
+                                result.m_changed.push_back(key);
+                                break;
+                }
+        };
+
+        for_each_change(before, after, collect, n_threads, data_equal);
+        return result;
+}
+
+}  // namespace ac
+
+#endif
@@ -0,0 +1,330 @@
+#ifndef TTL_HASHTBL_H
+#define TTL_HASHTBL_H
+
+#include <algorithm>   // std::min, std::max, std::remove_if.
+#include <array>       // std::array.
+#include <chrono>      // std::chrono::steady_clock, std::chrono::milliseconds.
+#include <cstdint>     // uint64_t.
+#include <functional>  // std::hash, std::equal_to.
+#include <limits>      // std::numeric_limits.
+#include <vector>      // std::vector.
+#include "hashtbl.h"   // ac::HashTbl.
+
+namespace ac {
+
+//! \brief Hash table whose entries may expire after a time to live (TTL).
+//!
+//! An expired entry is absent for every lookup at once. Its memory is reclaimed later by a
+//! hierarchical timing wheel: 4 levels of 64 slots, each level counting in units 64 times larger
+//! than the one below, so the wheel covers 64^4 ticks. An entry with a TTL has a record in the
+//! slot of its expiry; when the wheel reaches a slot of an upper level, the records there are
+//! moved down (at most 3 times each), and when it reaches a slot of the lowest level, the entries
+//! whose records are there are erased. Records left behind by a changed TTL or by an erase are
+//! recognized and dropped when their slot comes, or before: when the records outnumber twice what
+//! the wheel held after the last such sweep, the stale ones are all dropped. So with sliding TTLs,
+//! the wheel holds at most about twice as many records as entries with a TTL, and the sweeps cost
+//! amortized O(1) per record.
+//!
+//! The wheel moves on at each operation, and with tick(), doing a bounded amount of work each
+//! time: expiry costs amortized O(1) per entry and the table is never swept. Ticks where no slot
+//! holds records are skipped, so a long idle stretch costs a few steps per level.
+//!
+//! The clock is a type parameter with a static now(), as std::chrono::steady_clock, so that tests
+//! can control it.
+template <typename KeyType, typename DataType, typename KeyHash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>, typename Clock = std::chrono::steady_clock>
+class TtlHashTbl {
+       public:
+        using Duration = typename Clock::duration;  //!< Type of the TTLs.
+
+        //! \brief Constructs an empty table.
+        //! \param resolution Length of a tick of the wheel; expiry is rounded up to it.
+        //! \param budget Steps and records the wheel may handle per operation.
+        explicit TtlHashTbl(Duration resolution = std::chrono::milliseconds(1),
+                            size_t budget = DEFAULT_BUDGET)
+            : m_resolution{resolution},
+              m_budget{budget},
+              m_start{Clock::now()},
+              m_current{0},
+              m_records{0},
+              m_purge_at{SLOTS},
+              m_pending{0} {}
+
+        //! \brief Inserts data associated to a key, without expiry.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \return True if the key was not in the table, false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_) {
+                return store(key_, data_item_, NEVER);
+        }
+
+        //! \brief Inserts data associated to a key, expiring after a TTL.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Data to insert.
+        //! \param ttl Time to live of the entry.
+        //! \return True if the key was not in the table (or expired), false otherwise.
+        bool insert(const KeyType& key_, const DataType& data_item_, Duration ttl) {
+                return store(key_, data_item_, expiry_of(ttl));
+        }
+
+        //! \brief Changes the TTL of an entry.
+        //! \param key_ Key of the entry.
+        //! \param ttl New time to live, from now.
+        //! \return True if the entry exists, false otherwise.
+        bool expire(const KeyType& key_, Duration ttl) {
+                const Value* value = live(key_);
+                if (value == nullptr) return false;
+
+                put(key_, value->m_data, expiry_of(ttl));
+                return true;
+        }
+
+        //! \brief Removes the TTL of an entry: it does not expire any more.
+        //! \param key_ Key of the entry.
+        //! \return True if the entry exists, false otherwise.
+        bool persist(const KeyType& key_) {
+                const Value* value = live(key_);
+                if (value == nullptr) return false;
+
+                put(key_, value->m_data, NEVER);
+                return true;
+        }
+
+        //! \brief Erases data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \return True if erased, false otherwise (expired entries are absent).
+        bool erase(const KeyType& key_) {
+                bool found = live(key_) != nullptr;
+                m_table.erase(key_);  // Its record, if any, is dropped when its slot comes.
+                return found;
+        }
+
+        //! \brief Retrieves data associated to a key.
+        //! \param key_ Key associated to data.
+        //! \param data_item_ Store the data associated to key.
+        //! \return True if retrieved, false otherwise (expired entries are absent).
+        bool retrieve(const KeyType& key_, DataType& data_item_) {
+                const Value* value = live(key_);
+                if (value == nullptr) return false;
+
+                data_item_ = value->m_data;
+                return true;
+        }
+
+        //! \brief Returns the time left before an entry expires.
+        //! \param key_ Key of the entry.
+        //! \return Time to live, Duration::max() for no expiry, or a negative duration if absent.
+        Duration ttl(const KeyType& key_) {
+                const Value* value = live(key_);
+                if (value == nullptr) return Duration(-1);
+                if (value->m_expiry == NEVER) return Duration::max();
+
+                auto expiry = m_start + typename Duration::rep(value->m_expiry) * m_resolution;
+                return expiry - Clock::now();
+        }
+
+        //! \brief Moves the wheel up to the present, reclaiming expired entries.
+        //! \param budget Steps and records the wheel may handle.
+        //! \return True if the wheel caught up with the clock.
+        bool tick(size_t budget);
+
+        //! \brief Checks whether the table is empty (expired entries not yet reclaimed count).
+        //! \return True if empty, false otherwise.
+        inline bool empty(void) const { return m_table.empty(); }
+
+        //! \brief Returns the number of entries (expired entries not yet reclaimed count).
+        //! \return Number of entries.
+        inline size_t size(void) const { return m_table.size(); }
+
+        //! \brief Applies a function to every entry not expired.
+        //! \param fn Function called as fn(key, data) for each entry.
+        template <typename Function>
+        void for_each(Function fn) const {
+                uint64_t now = now_tick();
+                m_table.for_each([&](const KeyType& key, const Value& value) {
+                        if (value.m_expiry > now) fn(key, value.m_data);
+                });
+        }
+
+       private:
+        static const size_t DEFAULT_BUDGET = 16;  //!< Default work per operation.
+        static const size_t LEVELS = 4;           //!< Levels of the wheel.
+        static const size_t BITS = 6;             //!< log2 of the slots per level.
+        static const size_t SLOTS = 1 << BITS;    //!< Slots per level.
+        static const uint64_t NEVER = std::numeric_limits<uint64_t>::max();  //!< No expiry.
+
+        //! \brief Data and expiry tick of an entry.
+        struct Value {
+                DataType m_data;    //!< Data associated to the key.
+                uint64_t m_expiry;  //!< Tick at which the entry expires, or NEVER.
+        };
+
+        //! \brief Entry of the wheel: a key and the expiry it had when the record was made.
+        struct Record {
+                KeyType m_key;      //!< Key of the entry.
+                uint64_t m_expiry;  //!< Expiry of the entry when recorded.
+        };
+
+        using Level = std::array<std::vector<Record>, SLOTS>;  //!< Slots of a level.
+
+        Duration m_resolution;                               //!< Length of a tick.
+        size_t m_budget;                                     //!< Work per operation.
+        typename Clock::time_point m_start;                  //!< Time of tick 0.
+        uint64_t m_current;                                  //!< Last tick handled by the wheel.
+        size_t m_records;                                    //!< Records in the wheel.
+        size_t m_purge_at;                                   //!< Records that trigger purge().
+        std::array<size_t, LEVELS> m_counts{};               //!< Records in each level.
+        HashTbl<KeyType, Value, KeyHash, KeyEqual> m_table;  //!< Entries.
+        std::array<Level, LEVELS> m_wheel;                   //!< Records, by level and slot.
+        unsigned m_pending;                                  //!< Levels whose slot is draining.
+
+        // \brief Current tick of the clock.
+        uint64_t now_tick(void) const { return (Clock::now() - m_start) / m_resolution; }
+
+        // \brief Tick at which an entry inserted now with a TTL expires (rounded up).
+        uint64_t expiry_of(Duration ttl) const {
+                auto end = Clock::now() - m_start + ttl;
+                uint64_t ticks = (end + m_resolution - Duration(1)) / m_resolution;
+                return ticks == NEVER ? NEVER - 1 : ticks;
+        }
+
+        // \brief Returns the value of a key if it has not expired, after moving the wheel on.
+        const Value* live(const KeyType& key_) {
+                tick(m_budget);
+                const Value* value = m_table.find(key_);
+                if (value == nullptr || value->m_expiry <= now_tick()) return nullptr;
+
+                return value;
+        }
+
+        // \brief Stores an entry, after moving the wheel on.
+        bool store(const KeyType& key_, const DataType& data_item_, uint64_t expiry) {
+                bool found = live(key_) != nullptr;
+                put(key_, data_item_, expiry);
+                return !found;
+        }
+
+        // \brief Stores an entry and records its expiry in the wheel. The wheel does not move, so
+        // data_item_ may refer to the entry being replaced.
+        void put(const KeyType& key_, const DataType& data_item_, uint64_t expiry) {
+                m_table.insert(key_, Value{data_item_, expiry});
+                if (expiry != NEVER) {
+                        place(Record{key_, expiry});
+                        if (++m_records > m_purge_at) purge();
+                }
+        }
+
+        // \brief Tells whether a record still matches the expiry of its entry.
+        bool is_current(const Record& record) const {
+                const Value* value = m_table.find(record.m_key);
+                return value != nullptr && value->m_expiry == record.m_expiry;
+        }
+
+        // \brief Drops the stale records of every slot.
+        void purge(void);
+
+        // \brief Puts a record in the slot where the wheel will find it in time.
+        void place(const Record& record) {
+                // A record due now (or before) goes to the next tick.
+                uint64_t target = std::max(record.m_expiry, m_current + 1);
+                uint64_t delta = target - m_current;
+
+                size_t level = 0;
+                while (level < LEVELS - 1 && delta >= uint64_t(1) << (BITS * (level + 1))) level++;
+                if (delta >= uint64_t(1) << (BITS * LEVELS)) {
+                        // Beyond the wheel: park it as far as it goes, to be placed again.
+                        target = m_current + (uint64_t(1) << (BITS * LEVELS)) - 1;
+                }
+
+                m_wheel[level][(target >> (BITS * level)) & (SLOTS - 1)].push_back(record);
+                m_counts[level]++;
+        }
+
+        // \brief Erases the entry of a due record, unless the record is stale.
+        void fire(const Record& record) {
+                // Only the last record of an entry still matches its expiry.
+                if (is_current(record)) m_table.erase(record.m_key);
+                m_records--;
+        }
+
+        // \brief Current slot of a level.
+        std::vector<Record>& slot(size_t level) {
+                return m_wheel[level][(m_current >> (BITS * level)) & (SLOTS - 1)];
+        }
+
+        // \brief Moves the wheel on to the next tick where something may happen, at most to now,
+        // and marks the slots reached as pending.
+        void step(uint64_t now);
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class Clock>
+bool TtlHashTbl<KeyType, DataType, KeyHash, KeyEqual, Clock>::tick(size_t budget) {
+        uint64_t now = now_tick();
+        if (m_records == 0) m_current = now;  // Nothing to reclaim: no need to walk.
+
+        // The slots reached are drained a few records at a time, so that a crowded slot does not
+        // stall one operation, and before the wheel moves on. Records come down from the upper
+        // levels first; the slots keep their memory for the next turn of the wheel.
+        for (; budget > 0; budget--) {
+                if (m_pending == 0) {
+                        if (m_current >= now) return true;
+                        step(now);
+                        continue;
+                }
+
+                size_t level = LEVELS - 1;
+                while (!(m_pending & (1u << level))) level--;
+                auto& records = slot(level);
+                if (records.empty()) {
+                        m_pending &= ~(1u << level);
+                        continue;
+                }
+
+                Record record = std::move(records.back());
+                records.pop_back();
+                m_counts[level]--;
+                if (level > 0) {
+                        place(record);
+                } else {
+                        fire(record);
+                }
+        }
+
+        return m_current >= now && m_pending == 0;
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class Clock>
+void TtlHashTbl<KeyType, DataType, KeyHash, KeyEqual, Clock>::step(uint64_t now) {
+        // Below the first level holding records, nothing happens before its next slot comes.
+        size_t lowest = 0;
+        while (lowest < LEVELS - 1 && m_counts[lowest] == 0) lowest++;
+        uint64_t unit = uint64_t(1) << (BITS * lowest);
+        m_current = std::min((m_current / unit + 1) * unit, now);
+
+        // When a level wraps around, the next slot of the level above comes down.
+        m_pending = 1;
+        for (size_t level = 1; level < LEVELS; level++) {
+                if ((m_current >> (BITS * (level - 1))) & (SLOTS - 1)) break;
+                m_pending |= 1u << level;
+        }
+}
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, class Clock>
+void TtlHashTbl<KeyType, DataType, KeyHash, KeyEqual, Clock>::purge(void) {
+        for (size_t level = 0; level < LEVELS; level++) {
+                for (auto& records : m_wheel[level]) {
+                        auto stale = [this](const Record& record) { return !is_current(record); };
+                        auto last = std::remove_if(records.begin(), records.end(), stale);
+                        m_counts[level] -= records.end() - last;
+                        m_records -= records.end() - last;
+                        records.erase(last, records.end());
+                }
+        }
+
+        // Sweeping again only once the records have doubled keeps the cost amortized O(1).
+        m_purge_at = 2 * m_records + SLOTS;
+}
+
+}  // namespace ac
+
+#endif
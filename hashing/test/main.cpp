@@ -1,11 +1,38 @@
-#include <algorithm>             // std::min_element
-#include <array>                 // std::array
-#include <functional>            // std::function
-#include <iterator>              // std::begin(), std::end()
-#include <map>                   // std::map
-#include "../include/account.h"  // To get the account class
-#include "../include/hashtbl.h"  // header file for tested functions
-#include "gtest/gtest.h"         // gtest lib
+#include <fcntl.h>                       // open
+#include <sys/resource.h>                // setrlimit
+#include <sys/stat.h>                    // stat
+#include <unistd.h>                      // mkdtemp, truncate
+
+#include <algorithm>                     // std::min_element
+#include <array>                         // std::array
+#include <chrono>                        // std::chrono::milliseconds
+#include <csignal>                       // std::signal
+#include <cstdlib>                       // std::system
+#include <cstring>                       // std::memcpy
+#include <fstream>                       // std::ofstream
+#include <functional>                    // std::function
+#include <iterator>                      // std::begin(), std::end()
+#include <map>                           // std::map
+#include <memory>                        // std::make_unique
+#include <random>                        // std::mt19937
+#include <sstream>                       // std::stringstream
+#include <thread>                        // std::thread
+#include "../include/account.h"          // To get the account class
+#include "../include/account_store.h"    // header file for tested functions
+#include "../include/compact_hashtbl.h"  // header file for tested functions
+#include "../include/cow_hashtbl.h"      // header file for tested functions
+#include "../include/durable_hashtbl.h"  // header file for tested functions
+#include "../include/flat_hashtbl.h"     // header file for tested functions
+#include "../include/hash_set.h"         // header file for tested functions
+#include "../include/hashtbl.h"          // header file for tested functions
+#include "../include/paged_hashtbl.h"    // header file for tested functions
+#include "../include/perfect_hash.h"     // header file for tested functions
+#include "../include/radix_tree.h"       // header file for tested functions
+#include "../include/sampled_hashtbl.h"  // header file for tested functions
+#include "../include/small_hashtbl.h"    // header file for tested functions
+#include "../include/table_diff.h"       // header file for tested functions
+#include "../include/ttl_hashtbl.h"      // header file for tested functions
+#include "gtest/gtest.h"                 // gtest lib
 
 struct KeyHash {
         std::size_t operator()(const Account::AcctKey &k_) const {
@@ -526,6 +553,1460 @@ TEST_F(HTTest, Count) {
         // std::cout << "The table: \n" << htable << std::endl;
 }
 
+// ============================================================================
+// TESTING PERFECT HASH
+// ============================================================================
+
+TEST(PerfectHash, IsMinimalAndPerfect) {
+        std::vector<int> keys;
+        for (int i = 0; i < 200000; i++) keys.push_back(i * 7 + 3);
+
+        ac::PerfectHash<int> mphf;
+        mphf.build(keys.begin(), keys.end(), 1.0, 4);
+        ASSERT_EQ(mphf.size(), keys.size());
+
+        // Every key gets its own slot in [0, n).
+        std::vector<bool> used(keys.size(), false);
+        for (auto k : keys) {
+                auto slot = mphf(k);
+                ASSERT_LT(slot, keys.size());
+                ASSERT_FALSE(used[slot]);
+                used[slot] = true;
+        }
+
+        // Around 3 bits per key.
+        EXPECT_LT(double(mphf.bits()) / keys.size(), 3.5);
+}
+
+TEST(PerfectHash, SaveLoad) {
+        std::vector<std::string> keys{"this", "sentence", "is", "not", "a", "hoax"};
+        ac::PerfectHash<std::string> mphf;
+        mphf.build(keys.begin(), keys.end());
+
+        std::stringstream buffer;
+        mphf.save(buffer);
+        ac::PerfectHash<std::string> loaded;
+        loaded.load(buffer);
+
+        ASSERT_EQ(loaded.size(), mphf.size());
+        for (const auto &k : keys) EXPECT_EQ(mphf(k), loaded(k));
+}
+
+TEST(PerfectHash, LoadChecksSizes) {
+        std::vector<int> keys{1, 2, 3, 5, 8, 13, 21, 34};
+        ac::PerfectHash<int> mphf;
+        mphf.build(keys.begin(), keys.end());
+        std::stringstream buffer;
+        mphf.save(buffer);
+        const std::string saved = buffer.str();
+
+        // Layout: magic, key count, level count, then the seed and word count of the first level.
+        auto load_patched = [&saved](size_t offset, uint64_t value) {
+                std::string bytes = saved;
+                std::memcpy(&bytes[offset], &value, sizeof(value));
+                std::stringstream is(bytes);
+                ac::PerfectHash<int> loaded;
+                loaded.load(is);
+        };
+        EXPECT_THROW(load_patched(8, keys.size() + 1), std::runtime_error);
+        EXPECT_THROW(load_patched(16, uint64_t(1) << 40), std::runtime_error);
+        EXPECT_THROW(load_patched(32, uint64_t(1) << 50), std::runtime_error);
+        EXPECT_THROW(load_patched(32, 0), std::runtime_error);
+        EXPECT_NO_THROW(load_patched(8, keys.size()));
+}
+
+TEST_F(HTTest, StaticFromHashTbl) {
+        insert_accounts();
+        ac::StaticHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> st_accounts(ht_accounts);
+
+        ASSERT_EQ(st_accounts.size(), ht_accounts.size());
+        for (auto &e : m_accounts) {
+                Account data;
+                EXPECT_TRUE(st_accounts.retrieve(e.getKey(), data));
+                EXPECT_EQ(data, e);
+                EXPECT_EQ(st_accounts.at(e.getKey()), e);
+        }
+
+        Account missing{"Nobody", 1, 1668, 54321, 0.f};
+        Account data;
+        EXPECT_FALSE(st_accounts.retrieve(missing.getKey(), data));
+        EXPECT_THROW(st_accounts.at(missing.getKey()), std::out_of_range);
+}
+
+TEST(StaticHashTbl, SharedHashes) {
+        // Every key hashes to the same value, so they all go to the fallback.
+        struct BadHash {
+                size_t operator()(int) const { return 42; }
+        };
+        std::vector<ac::HashEntry<int, int>> entries;
+        for (int i = 0; i < 10; i++) entries.emplace_back(i, i * i);
+
+        ac::StaticHashTbl<int, int, BadHash> table(entries.begin(), entries.end());
+        for (int i = 0; i < 10; i++) EXPECT_EQ(table.at(i), i * i);
+
+        int data;
+        EXPECT_FALSE(table.retrieve(10, data));
+}
+
+TEST(StaticHashTbl, SaveLoad) {
+        ac::HashTbl<int, double> source;
+        for (int i = 0; i < 1000; i++) source.insert(i, i / 2.0);
+        ac::StaticHashTbl<int, double> table(source);
+
+        std::stringstream buffer;
+        table.save(buffer);
+        ac::StaticHashTbl<int, double> loaded;
+        loaded.load(buffer);
+
+        ASSERT_EQ(loaded.size(), source.size());
+        for (int i = 0; i < 1000; i++) EXPECT_EQ(loaded.at(i), i / 2.0);
+}
+
+// ============================================================================
+// TESTING COPY-ON-WRITE SNAPSHOTS
+// ============================================================================
+
+TEST_F(HTTest, SnapshotIsConsistent) {
+        ac::CowHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> accounts(4);
+        for (auto &e : m_accounts) accounts.insert(e.getKey(), e);
+
+        auto snap = accounts.snapshot();
+
+        // Change balances, erase one account and insert enough to trigger a rehash.
+        for (auto &e : m_accounts) accounts[e.getKey()].m_balance += 1000.f;
+        accounts.erase(m_accounts[0].getKey());
+        for (int i = 0; i < 20; i++) {
+                accounts.insert(Account("Extra", 99, 1, i).getKey(), Account());
+        }
+
+        // The snapshot still sees the old table.
+        EXPECT_EQ(snap.size(), m_accounts.size());
+        for (auto &e : m_accounts) {
+                Account data;
+                EXPECT_TRUE(snap.retrieve(e.getKey(), data));
+                EXPECT_EQ(data.m_balance, e.m_balance);
+        }
+
+        // And the table sees the changes.
+        EXPECT_EQ(accounts.size(), m_accounts.size() - 1 + 20);
+        Account data;
+        EXPECT_FALSE(accounts.retrieve(m_accounts[0].getKey(), data));
+        EXPECT_TRUE(accounts.retrieve(m_accounts[1].getKey(), data));
+        EXPECT_EQ(data.m_balance, m_accounts[1].m_balance + 1000.f);
+}
+
+TEST(CowHashTbl, ManySnapshots) {
+        ac::CowHashTbl<int, int> table;
+        std::vector<ac::CowHashTbl<int, int>::Snapshot> snaps;
+
+        for (int version = 0; version < 5; version++) {
+                for (int k = 0; k < 100; k++) table.insert(k, version);
+                snaps.push_back(table.snapshot());
+        }
+        table.clear();
+        EXPECT_TRUE(table.empty());
+
+        for (int version = 0; version < 5; version++) {
+                EXPECT_EQ(snaps[version].size(), 100);
+                for (int k = 0; k < 100; k++) EXPECT_EQ(snaps[version].at(k), version);
+        }
+}
+
+TEST(CowHashTbl, SubscriptGrowsTable) {
+        ac::CowHashTbl<int, int> table(4);
+        auto snap = table.snapshot();
+        for (int k = 0; k < 100; k++) table[k] = k;
+
+        // Filled through operator[] only, the table still keeps about one entry per bucket.
+        EXPECT_GE(table.bucket_count(), table.size());
+        for (int k = 0; k < 100; k++) EXPECT_EQ(table.snapshot().at(k), k);
+        EXPECT_TRUE(snap.empty());
+}
+
+TEST(CowHashTbl, ConcurrentReaders) {
+        ac::CowHashTbl<int, int> table;
+        for (int k = 0; k < 1000; k++) table.insert(k, 0);
+        auto snap = table.snapshot();
+
+        // Readers scan the snapshot while the writer keeps updating the table.
+        std::vector<std::thread> readers;
+        std::vector<long> sums(4, 0);
+        for (size_t t = 0; t < sums.size(); t++) {
+                readers.emplace_back([&snap, &sums, t]() {
+                        for (int round = 0; round < 20; round++) {
+                                snap.for_each(
+                                    [&sums, t](const int &, const int &d) { sums[t] += d; });
+                        }
+                });
+        }
+        for (int round = 1; round <= 20; round++) {
+                for (int k = 0; k < 1000; k++) table[k] = round;
+        }
+        for (auto &r : readers) r.join();
+
+        for (auto sum : sums) EXPECT_EQ(sum, 0);
+        int data;
+        EXPECT_TRUE(table.retrieve(999, data));
+        EXPECT_EQ(data, 20);
+}
+
+TEST(CowHashTbl, SnapshotsReleasedByReaders) {
+        // Each reader drops its snapshot on its own thread; the writer then reuses the buckets
+        // in place, which must wait for the reads made through the snapshot.
+        ac::CowHashTbl<int, int> table;
+        for (int k = 0; k < 1000; k++) table.insert(k, 0);
+
+        for (int round = 1; round <= 20; round++) {
+                std::vector<std::thread> readers;
+                std::vector<long> sums(4, 0);
+                for (size_t t = 0; t < sums.size(); t++) {
+                        readers.emplace_back([snap = table.snapshot(), &sums, t]() mutable {
+                                snap.for_each(
+                                    [&sums, t](const int &, const int &d) { sums[t] += d; });
+                                snap = ac::CowHashTbl<int, int>::Snapshot();
+                        });
+                }
+                for (int k = 0; k < 1000; k++) table[k] = round;
+                for (auto &r : readers) r.join();
+
+                for (auto sum : sums) EXPECT_EQ(sum, 1000L * (round - 1));
+        }
+}
+
+// ============================================================================
+// TESTING WRITE-AHEAD LOG
+// ============================================================================
+
+namespace ac {
+//! Accounts are stored field by field in the log.
+template <>
+struct Codec<Account> {
+        static void write(std::string &out, const Account &a) {
+                Codec<std::string>::write(out, a.m_name);
+                Codec<int>::write(out, a.bank_num);
+                Codec<int>::write(out, a.agency_num);
+                Codec<int>::write(out, a.acc_num);
+                Codec<float>::write(out, a.m_balance);
+        }
+
+        static bool read(const char *&first, const char *last, Account &a) {
+                return Codec<std::string>::read(first, last, a.m_name) &&
+                       Codec<int>::read(first, last, a.bank_num) &&
+                       Codec<int>::read(first, last, a.agency_num) &&
+                       Codec<int>::read(first, last, a.acc_num) &&
+                       Codec<float>::read(first, last, a.m_balance);
+        }
+};
+}  // namespace ac
+
+class WALTest : public HTTest {
+       public:
+        using Table = ac::DurableHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+       protected:
+        void SetUp() override {
+                HTTest::SetUp();
+                char tmpl[] = "/tmp/hashtbl_walXXXXXX";
+                m_dir = mkdtemp(tmpl);
+                m_path = m_dir + "/accounts";
+        }
+
+        void TearDown() override { std::system(("rm -rf " + m_dir).c_str()); }
+
+        std::string m_dir;   //!< Scratch directory.
+        std::string m_path;  //!< Base path of the table.
+};
+
+TEST_F(WALTest, Recovery) {
+        {
+                Table accounts(m_path, 3);
+                for (auto &e : m_accounts) accounts.insert(e.getKey(), e);
+                accounts.erase(m_accounts[0].getKey());
+                Account changed = m_accounts[1];
+                changed.m_balance = 1.f;
+                accounts[changed.getKey()] = changed;
+        }
+
+        Table accounts(m_path);
+        EXPECT_EQ(accounts.size(), m_accounts.size() - 1);
+
+        Account data;
+        EXPECT_FALSE(accounts.retrieve(m_accounts[0].getKey(), data));
+        EXPECT_TRUE(accounts.retrieve(m_accounts[1].getKey(), data));
+        EXPECT_EQ(data.m_balance, 1.f);
+        for (size_t i = 2; i < m_accounts.size(); i++) {
+                EXPECT_TRUE(accounts.retrieve(m_accounts[i].getKey(), data));
+                EXPECT_EQ(data, m_accounts[i]);
+        }
+}
+
+TEST_F(WALTest, GroupCommit) {
+        Table accounts(m_path, 4);
+        for (size_t i = 0; i < 3; i++) accounts.insert(m_accounts[i].getKey(), m_accounts[i]);
+
+        // Simulate a crash: only what reached the disk survives in a copy of the files.
+        auto crash_copy = [this]() {
+                std::system(("cp " + m_path + ".log.0 " + m_path + "_copy.log.0").c_str());
+                return Table(m_path + "_copy").size();
+        };
+        EXPECT_EQ(crash_copy(), 0);
+
+        accounts.insert(m_accounts[3].getKey(), m_accounts[3]);  // Fills the group.
+        EXPECT_EQ(crash_copy(), 4);
+
+        accounts.insert(m_accounts[4].getKey(), m_accounts[4]);
+        accounts.sync();
+        EXPECT_EQ(crash_copy(), 5);
+}
+
+TEST_F(WALTest, TornRecord) {
+        {
+                Table accounts(m_path, 1);
+                for (auto &e : m_accounts) accounts.insert(e.getKey(), e);
+        }
+
+        // Append half a record, like a crash in the middle of a write.
+        {
+                std::ofstream log(m_path + ".log.0", std::ios::binary | std::ios::app);
+                log.write("\x20\x00\x00\x00\x01\x02", 6);
+        }
+
+        {
+                Table accounts(m_path, 1);
+                EXPECT_EQ(accounts.size(), m_accounts.size());
+                accounts.erase(m_accounts[0].getKey());
+        }
+
+        // The torn record was dropped, and the records written after it are replayed.
+        Table accounts(m_path);
+        EXPECT_EQ(accounts.size(), m_accounts.size() - 1);
+}
+
+TEST_F(WALTest, Compaction) {
+        {
+                Table accounts(m_path);
+                for (size_t i = 0; i < 4; i++) {
+                        accounts.insert(m_accounts[i].getKey(), m_accounts[i]);
+                }
+                EXPECT_TRUE(accounts.compact());
+
+                // Writers go on while the snapshot is written.
+                for (size_t i = 4; i < m_accounts.size(); i++) {
+                        accounts.insert(m_accounts[i].getKey(), m_accounts[i]);
+                }
+                accounts.erase(m_accounts[0].getKey());
+                accounts.wait_compaction();
+        }
+
+        // The first segment was folded into the snapshot.
+        EXPECT_NE(access((m_path + ".snap").c_str(), F_OK), -1);
+        EXPECT_EQ(access((m_path + ".log.0").c_str(), F_OK), -1);
+
+        Table accounts(m_path);
+        EXPECT_EQ(accounts.size(), m_accounts.size() - 1);
+        Account data;
+        EXPECT_FALSE(accounts.retrieve(m_accounts[0].getKey(), data));
+        for (size_t i = 1; i < m_accounts.size(); i++) {
+                EXPECT_TRUE(accounts.retrieve(m_accounts[i].getKey(), data));
+                EXPECT_EQ(data, m_accounts[i]);
+        }
+}
+
+TEST_F(WALTest, FailedWriteIsRetried) {
+        // Caps the size of the files this process writes, so that a log write stops halfway.
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit unlimited;
+        getrlimit(RLIMIT_FSIZE, &unlimited);
+        auto cap = [this, &unlimited](const char* segment, off_t extra) {
+                struct stat st;
+                stat((m_path + segment).c_str(), &st);
+                rlimit limit{rlim_t(st.st_size + extra), unlimited.rlim_max};
+                setrlimit(RLIMIT_FSIZE, &limit);
+        };
+
+        {
+                Table accounts(m_path, m_accounts.size());
+                accounts.insert(m_accounts[0].getKey(), m_accounts[0]);
+                accounts.sync();
+
+                cap(".log.0", 20);
+                for (size_t i = 1; i < m_accounts.size(); i++) {
+                        accounts.insert(m_accounts[i].getKey(), m_accounts[i]);
+                }
+                EXPECT_THROW(accounts.sync(), std::runtime_error);
+                setrlimit(RLIMIT_FSIZE, &unlimited);
+                accounts.sync();
+        }
+
+        // Nothing of the failed write is left in the log to stop the replay.
+        Table accounts(m_path, m_accounts.size());
+        EXPECT_EQ(accounts.size(), m_accounts.size());
+        Account data;
+        for (auto &e : m_accounts) {
+                EXPECT_TRUE(accounts.retrieve(e.getKey(), data));
+                EXPECT_EQ(data, e);
+        }
+
+        // A compaction that fails to start does not block the next one.
+        accounts.erase(m_accounts[0].getKey());
+        cap(".log.1", 0);  // Reopening the table started a new segment.
+        EXPECT_THROW(accounts.compact(), std::runtime_error);
+        setrlimit(RLIMIT_FSIZE, &unlimited);
+        EXPECT_TRUE(accounts.compact());
+        accounts.wait_compaction();
+}
+
+// ============================================================================
+// TESTING DISK-RESIDENT HASH TABLE
+// ============================================================================
+
+class PagedTest : public ::testing::Test {
+       protected:
+        void SetUp() override {
+                char tmpl[] = "/tmp/hashtbl_pagedXXXXXX";
+                m_dir = mkdtemp(tmpl);
+                m_path = m_dir + "/table";
+        }
+
+        void TearDown() override { std::system(("rm -rf " + m_dir).c_str()); }
+
+        std::string m_dir;   //!< Scratch directory.
+        std::string m_path;  //!< Base path of the table.
+};
+
+TEST_F(PagedTest, InsertRetrieveErase) {
+        // A tiny buffer pool forces pages in and out of memory.
+        ac::PagedHashTbl<long, long> table(m_path, 4);
+        const long n = 20000;
+
+        for (long i = 0; i < n; i++) EXPECT_TRUE(table.insert(i, i * 10));
+        EXPECT_EQ(table.size(), n);
+        EXPECT_FALSE(table.insert(7, 77));  // Existing key: update.
+        EXPECT_GT(table.page_count(), n / ((4096 - 8) / 16));
+
+        for (long i = 0; i < n; i++) {
+                long data;
+                EXPECT_TRUE(table.retrieve(i, data));
+                EXPECT_EQ(data, i == 7 ? 77 : i * 10);
+        }
+
+        for (long i = 0; i < n; i += 2) EXPECT_TRUE(table.erase(i));
+        EXPECT_FALSE(table.erase(0));
+        EXPECT_EQ(table.size(), n / 2);
+        for (long i = 0; i < n; i++) {
+                long data;
+                EXPECT_EQ(table.retrieve(i, data), i % 2 == 1);
+        }
+}
+
+TEST_F(PagedTest, OnePageReadPerLookup) {
+        ac::PagedHashTbl<long, long> table(m_path, 8);
+        for (long i = 0; i < 50000; i++) table.insert(i, i);
+
+        table.drop_caches();
+        for (long i = 0; i < 50000; i += 97) {
+                auto reads = table.page_reads();
+                long data;
+                EXPECT_TRUE(table.retrieve(i, data));
+                EXPECT_LE(table.page_reads() - reads, 1);
+        }
+}
+
+TEST_F(PagedTest, Reopen) {
+        {
+                ac::PagedHashTbl<int, double> table(m_path);
+                for (int i = 0; i < 5000; i++) table.insert(i, i / 4.0);
+                table.erase(42);
+        }
+
+        ac::PagedHashTbl<int, double> table(m_path);
+        EXPECT_EQ(table.size(), 4999);
+        double data;
+        EXPECT_FALSE(table.retrieve(42, data));
+        for (int i = 0; i < 5000; i++) {
+                if (i == 42) continue;
+                EXPECT_TRUE(table.retrieve(i, data));
+                EXPECT_EQ(data, i / 4.0);
+        }
+}
+
+TEST_F(PagedTest, CorruptedDirectoryClosesFile) {
+        std::ofstream(m_path + ".dir") << "not a directory";
+
+        int probe = ::open("/dev/null", O_RDONLY);  // The lowest free descriptor.
+        ::close(probe);
+        EXPECT_THROW((ac::PagedHashTbl<long, long>(m_path)), std::runtime_error);
+
+        int next = ::open("/dev/null", O_RDONLY);
+        EXPECT_EQ(next, probe);  // The data file was closed.
+        ::close(next);
+}
+
+//! \brief Hash that sends every key to the same page.
+struct SameHash {
+        size_t operator()(long) const { return 42; }
+};
+
+TEST_F(PagedTest, CollidingKeysStopAtMaxDepth) {
+        // A page holds 255 entries: the 256th splits until the directory is at its largest.
+        ac::PagedHashTbl<long, long, SameHash> table(m_path, 4);
+        for (long i = 0; i < 255; i++) EXPECT_TRUE(table.insert(i, i));
+        EXPECT_THROW(table.insert(255, 255), std::length_error);
+
+        long data;
+        EXPECT_TRUE(table.retrieve(254, data));
+        EXPECT_EQ(data, 254);
+}
+
+// ============================================================================
+// TESTING COMPACT HASH TABLE
+// ============================================================================
+
+TEST(CompactHashTbl, InsertionOrder) {
+        ac::CompactHashTbl<std::string, int> table{{"c", 3}, {"a", 1}, {"b", 2}};
+        table["d"] = 4;
+        table.insert("a", 10);  // An update keeps the position.
+        table.erase("c");
+        table.insert("c", 30);  // A reinsertion goes to the end.
+
+        std::vector<std::string> keys;
+        table.for_each([&](const std::string& k, int) { keys.push_back(k); });
+        EXPECT_EQ(keys, (std::vector<std::string>{"a", "b", "d", "c"}));
+        EXPECT_EQ(table.at("a"), 10);
+        EXPECT_EQ(table.at("c"), 30);
+        EXPECT_THROW(table.at("e"), std::out_of_range);
+}
+
+TEST(CompactHashTbl, IndexWidthGrows) {
+        ac::CompactHashTbl<int, int> table;
+        EXPECT_EQ(table.index_width(), 1);
+
+        for (int i = 0; i < 200000; i++) {
+                EXPECT_TRUE(table.insert(i, -i));
+                if (i == 200) {
+                        EXPECT_EQ(table.index_width(), 2);
+                }
+        }
+        EXPECT_EQ(table.index_width(), 4);
+        EXPECT_EQ(table.size(), 200000);
+
+        for (int i = 0; i < 200000; i += 3) EXPECT_TRUE(table.erase(i));
+        for (int i = 0; i < 200000; i++) {
+                int data;
+                EXPECT_EQ(table.retrieve(i, data), i % 3 != 0);
+                if (i % 3 != 0) {
+                        EXPECT_EQ(data, -i);
+                }
+        }
+
+        int previous = -1;
+        table.for_each([&](int k, int) {
+                EXPECT_GT(k, previous);
+                previous = k;
+        });
+
+        table.clear();
+        EXPECT_TRUE(table.empty());
+        EXPECT_EQ(table.index_width(), 1);
+}
+
+TEST(CompactHashTbl, ChurnReusesTombstones) {
+        ac::CompactHashTbl<int, int> table;
+        for (int round = 0; round < 1000; round++) {
+                EXPECT_TRUE(table.insert(round, round));
+                if (round >= 3) {
+                        EXPECT_TRUE(table.erase(round - 3));
+                }
+        }
+        EXPECT_EQ(table.size(), 3);
+        EXPECT_EQ(table.index_width(), 1);
+        EXPECT_EQ(table.at(999), 999);
+}
+
+TEST(CompactHashTbl, ChurnKeepsEmptySlots) {
+        // Each erase pops its trailing entry, but its tombstone stays in the index.
+        ac::CompactHashTbl<int, int> table;
+        for (int i = 0; i < 100000; i++) {
+                EXPECT_TRUE(table.insert(i, i));
+                EXPECT_TRUE(table.erase(i));
+        }
+        int data;
+        EXPECT_FALSE(table.retrieve(-1, data));  // Hangs if no slot is EMPTY.
+        EXPECT_TRUE(table.empty());
+        EXPECT_EQ(table.index_width(), 1);
+}
+
+// ============================================================================
+// TESTING SMALL HASH TABLE
+// ============================================================================
+
+TEST(SmallHashTbl, InlineThenSpill) {
+        ac::SmallHashTbl<std::string, int, 4> table{{"a", 1}, {"b", 2}, {"c", 3}};
+        table["d"] = 4;
+        EXPECT_TRUE(table.is_inline());
+        EXPECT_FALSE(table.insert("a", 10));
+        EXPECT_TRUE(table.is_inline());
+        EXPECT_EQ(table.at("a"), 10);
+
+        EXPECT_TRUE(table.insert("e", 5));
+        EXPECT_FALSE(table.is_inline());
+        EXPECT_EQ(table.size(), 5);
+        for (auto k : {"a", "b", "c", "d", "e"}) EXPECT_NO_THROW(table.at(k));
+        EXPECT_THROW(table.at("f"), std::out_of_range);
+
+        table.clear();
+        EXPECT_TRUE(table.is_inline());
+        EXPECT_TRUE(table.empty());
+}
+
+TEST(SmallHashTbl, EraseAndCopy) {
+        ac::SmallHashTbl<int, std::string> table;
+        for (int i = 0; i < 8; i++) table.insert(i, std::to_string(i));
+        EXPECT_TRUE(table.erase(0));
+        EXPECT_TRUE(table.erase(7));
+        EXPECT_FALSE(table.erase(7));
+        EXPECT_EQ(table.size(), 6);
+
+        ac::SmallHashTbl<int, std::string> copy(table);
+        table[1] = "one";
+        std::string data;
+        EXPECT_TRUE(copy.retrieve(1, data));
+        EXPECT_EQ(data, "1");
+        EXPECT_FALSE(copy.retrieve(0, data));
+
+        int sum = 0;
+        copy.for_each([&](int k, const std::string& d) {
+                EXPECT_EQ(std::to_string(k), d);
+                sum += k;
+        });
+        EXPECT_EQ(sum, 1 + 2 + 3 + 4 + 5 + 6);
+}
+
+TEST(SmallHashTbl, Move) {
+        using Table = ac::SmallHashTbl<std::string, std::string, 4>;
+        EXPECT_TRUE(std::is_nothrow_move_constructible<Table>::value);
+        EXPECT_TRUE(std::is_nothrow_move_assignable<Table>::value);
+
+        // Inline elements are moved one by one.
+        Table small{{"a", "1"}, {"b", "2"}};
+        Table moved(std::move(small));
+        EXPECT_TRUE(small.empty());
+        EXPECT_EQ(moved.size(), 2);
+        EXPECT_EQ(moved.at("b"), "2");
+
+        // The heap table is taken over: its entries stay where they are.
+        Table big;
+        for (int i = 0; i < 10; i++) big.insert(std::to_string(i), std::to_string(i));
+        const std::string *entry = &big.at("7");
+        moved = std::move(big);
+        EXPECT_TRUE(big.empty());
+        EXPECT_TRUE(big.is_inline());
+        EXPECT_FALSE(moved.is_inline());
+        EXPECT_EQ(moved.size(), 10);
+        EXPECT_EQ(&moved.at("7"), entry);
+        EXPECT_THROW(moved.at("a"), std::out_of_range);
+
+        big = std::move(small);  // Both empty.
+        EXPECT_TRUE(big.empty());
+}
+
+// ============================================================================
+// TESTING HASH SET
+// ============================================================================
+
+TEST(HashSet, InsertEraseContains) {
+        ac::HashSet<std::string> set{"a", "b", "c"};
+        EXPECT_TRUE(set.insert("d"));
+        EXPECT_FALSE(set.insert("a"));
+        EXPECT_TRUE(set.erase("b"));
+        EXPECT_FALSE(set.erase("b"));
+        EXPECT_EQ(set.size(), 3);
+        EXPECT_TRUE(set.contains("a"));
+        EXPECT_FALSE(set.contains("b"));
+
+        std::vector<std::string> keys(set.begin(), set.end());
+        std::sort(keys.begin(), keys.end());
+        EXPECT_EQ(keys, (std::vector<std::string>{"a", "c", "d"}));
+
+        set.clear();
+        EXPECT_TRUE(set.empty());
+        EXPECT_EQ(set.begin(), set.end());
+        EXPECT_TRUE(set.insert("e"));
+}
+
+TEST(HashSet, BulkOperations) {
+        ac::HashSet<int> evens, threes;
+        for (int i = 0; i < 1000; i++) {
+                if (i % 2 == 0) evens.insert(i);
+                if (i % 3 == 0) threes.insert(i);
+        }
+
+        auto both = evens & threes;
+        auto either = evens | threes;
+        auto only_evens = evens - threes;
+        EXPECT_EQ(both.size(), 167);
+        EXPECT_EQ(either.size(), 500 + 334 - 167);
+        EXPECT_EQ(only_evens.size(), 500 - 167);
+        for (int i = 0; i < 1000; i++) {
+                EXPECT_EQ(both.contains(i), i % 6 == 0);
+                EXPECT_EQ(either.contains(i), i % 2 == 0 || i % 3 == 0);
+                EXPECT_EQ(only_evens.contains(i), i % 2 == 0 && i % 3 != 0);
+        }
+
+        auto set = evens;
+        set -= threes;
+        EXPECT_EQ(set, only_evens);
+        set |= threes;
+        EXPECT_EQ(set, either);
+        set &= evens;
+        EXPECT_EQ(set, evens);
+        EXPECT_NE(set, threes);
+}
+
+TEST(HashSet, EntryHoldsTheKeyOnly) {
+        EXPECT_EQ(sizeof(ac::HashSet<long>::Table::Entry), sizeof(long));
+
+        ac::HashSet<long> set;
+        for (long i = 0; i < 100; i++) set.insert(i * i);
+        EXPECT_EQ(std::distance(set.begin(), set.end()), 100);
+        for (auto it = set.begin(); it != set.end(); it++) EXPECT_TRUE(set.contains(*it));
+}
+
+TEST(HashSet, IteratorIsForward) {
+        using Iterator = ac::HashSet<std::string>::const_iterator;
+        EXPECT_TRUE(std::is_default_constructible<Iterator>::value);
+        EXPECT_EQ(Iterator(), Iterator());  // Value-initialized iterators compare equal.
+
+        ac::HashSet<std::string> set{"a", "b"};
+        Iterator it;
+        it = set.begin();
+        EXPECT_NE(it, Iterator());
+        EXPECT_EQ(std::next(it, 2), set.end());
+        EXPECT_EQ(std::count_if(set.begin(), set.end(), [](const std::string &k) {
+                          return k == "a" || k == "b";
+                  }),
+                  2);
+}
+
+// ============================================================================
+// TESTING FLAT HASH TABLE
+// ============================================================================
+
+TEST(FlatHashTbl, InsertEraseRetrieve) {
+        ac::FlatHashTbl<int, long> table{{1, 10}, {2, 20}};
+        table[3] = 30;
+        EXPECT_FALSE(table.insert(1, 11));
+        EXPECT_EQ(table.at(1), 11);
+        EXPECT_THROW(table.at(4), std::out_of_range);
+
+        for (int i = 4; i < 100000; i++) EXPECT_TRUE(table.insert(i, i * 10L));
+        for (int i = 0; i < 100000; i += 2) EXPECT_EQ(table.erase(i), i != 0);
+        EXPECT_EQ(table.size(), 50000);
+        for (int i = 0; i < 100000; i++) {
+                long data;
+                EXPECT_EQ(table.retrieve(i, data), i % 2 == 1);
+        }
+
+        // Erased slots are reused: churn does not grow the table.
+        size_t capacity = table.capacity();
+        for (int i = 0; i < 200000; i++) {
+                table.insert(-1 - i, i);
+                table.erase(-1 - i);
+        }
+        EXPECT_EQ(table.capacity(), capacity);
+        EXPECT_EQ(table.size(), 50000);
+}
+
+TEST(FlatHashTbl, CopyIsIndependent) {
+        ac::FlatHashTbl<uint64_t, double> table;
+        for (uint64_t i = 0; i < 1000; i++) table.insert(i, i / 2.0);
+
+        auto copy = table;
+        table.clear();
+        EXPECT_TRUE(table.empty());
+        EXPECT_EQ(copy.size(), 1000);
+
+        double sum = 0;
+        copy.for_each([&](uint64_t, double d) { sum += d; });
+        EXPECT_EQ(sum, 999 * 1000 / 4.0);
+
+        table = copy;
+        copy[0] = -1;
+        EXPECT_EQ(table.at(0), 0);
+}
+
+TEST(FlatHashTbl, AutoHashTblSelection) {
+        struct Padded {
+                char c;
+                int i;
+        };
+
+        EXPECT_TRUE((std::is_same<ac::AutoHashTbl<int, int>, ac::FlatHashTbl<int, int>>::value));
+        EXPECT_TRUE((std::is_same<ac::AutoHashTbl<long, Padded>,
+                                  ac::FlatHashTbl<long, Padded>>::value));
+        // Not bitwise: +0.0 == -0.0, and padding bytes are unspecified.
+        EXPECT_TRUE((std::is_same<ac::AutoHashTbl<double, int>, ac::HashTbl<double, int>>::value));
+        EXPECT_TRUE((std::is_same<ac::AutoHashTbl<Padded, int>, ac::HashTbl<Padded, int>>::value));
+        EXPECT_TRUE((std::is_same<ac::AutoHashTbl<std::string, int>,
+                                  ac::HashTbl<std::string, int>>::value));
+}
+
+// Uses the interface that both choices of AutoHashTbl share.
+template <typename Table, typename Key>
+void use_auto_table(Key (*key_of)(int)) {
+        Table table;
+        for (int i = 0; i < 100; i++) table.insert(key_of(i), i);
+        table[key_of(100)] = 100;
+        EXPECT_TRUE(table.erase(key_of(0)));
+
+        EXPECT_EQ(table.size(), 100);
+        EXPECT_GE(table.bucket_count(), table.size() / 2);
+        EXPECT_GE(table.count(key_of(1)), 1);  // Counts the bucket of the key.
+        EXPECT_EQ(table.find(key_of(0)), nullptr);
+        ASSERT_NE(table.find(key_of(50)), nullptr);
+        EXPECT_EQ(*table.find(key_of(50)), 50);
+        EXPECT_EQ(table.at(key_of(100)), 100);
+
+        std::stringstream out;
+        out << table;
+        EXPECT_NE(out.str().find(">>>50\n"), std::string::npos);
+
+        int sum = 0;
+        table.for_each([&sum](const Key &, int d) { sum += d; });
+        EXPECT_EQ(sum, 100 * 101 / 2);
+}
+
+TEST(FlatHashTbl, AutoHashTblSharedInterface) {
+        use_auto_table<ac::AutoHashTbl<int, int>>(+[](int i) { return i; });
+        use_auto_table<ac::AutoHashTbl<std::string, int>>(+[](int i) { return std::to_string(i); });
+
+        // As in HashTbl, count() is the size of the bucket: all the keys share one here.
+        ac::FlatHashTbl<long, int, SameHash> same;
+        for (long k = 0; k < 10; k++) same.insert(k, 0);
+        same.erase(3);
+        EXPECT_EQ(same.count(0), 9);
+}
+
+// ============================================================================
+// TESTING ACCOUNT STORE
+// ============================================================================
+
+//! \brief Sorted account numbers of a query result.
+std::vector<int> account_numbers(const std::vector<Account> &accounts) {
+        std::vector<int> numbers;
+        for (const auto &a : accounts) numbers.push_back(a.acc_num);
+        std::sort(numbers.begin(), numbers.end());
+        return numbers;
+}
+
+TEST_F(HTTest, AccountStoreIndexes) {
+        for (unsigned indexes : {ac::AccountStore::ALL, ac::AccountStore::NONE}) {
+                ac::AccountStore store(indexes);
+                for (auto &a : m_accounts) EXPECT_TRUE(store.insert(a));
+                EXPECT_EQ(store.size(), m_accounts.size());
+
+                std::vector<int> expected;
+                for (auto &a : m_accounts) {
+                        if (a.bank_num == 1 && a.agency_num == 1668) expected.push_back(a.acc_num);
+                }
+                std::sort(expected.begin(), expected.end());
+                EXPECT_EQ(account_numbers(store.by_agency(1, 1668)), expected);
+
+                // An update keeps the account in its indexes, with the new balance.
+                Account changed = m_accounts[0];
+                changed.m_balance = 1234.f;
+                EXPECT_FALSE(store.insert(changed));
+                auto by_name = store.by_name(changed.m_name);
+                ASSERT_EQ(by_name.size(), 1);
+                EXPECT_EQ(by_name[0].m_balance, 1234.f);
+
+                // Erased accounts leave every index.
+                size_t in_bank = store.by_bank(changed.bank_num).size();
+                EXPECT_TRUE(store.erase(changed.getKey()));
+                EXPECT_FALSE(store.erase(changed.getKey()));
+                EXPECT_TRUE(store.by_name(changed.m_name).empty());
+                EXPECT_EQ(store.by_bank(changed.bank_num).size(), in_bank - 1);
+                EXPECT_TRUE(store.by_bank(-1).empty());
+        }
+}
+
+TEST(AccountStore, ManyAccounts) {
+        ac::AccountStore store(ac::AccountStore::BY_BANK | ac::AccountStore::BY_AGENCY);
+        for (int i = 0; i < 10000; i++) {
+                store.insert(Account("Client " + std::to_string(i % 500), i % 10, i % 100, i));
+        }
+
+        EXPECT_EQ(store.by_bank(3).size(), 1000);
+        EXPECT_EQ(store.by_agency(3, 13).size(), 100);
+        EXPECT_TRUE(store.by_agency(3, 14).empty());  // i % 10 == 3 implies i % 100 % 10 == 3.
+        EXPECT_EQ(store.by_name("Client 7").size(), 20);  // No index: a scan.
+
+        for (int i = 0; i < 10000; i += 2) {
+                EXPECT_TRUE(store.erase(
+                    Account("Client " + std::to_string(i % 500), i % 10, i % 100, i).getKey()));
+        }
+        EXPECT_TRUE(store.by_bank(4).empty());
+        EXPECT_EQ(store.by_agency(3, 13).size(), 100);
+}
+
+TEST(AccountStore, ManyAgencies) {
+        // The indexes create their groups through operator[], which must grow the table.
+        ac::HashTbl<int, int> groups;
+        size_t initial = groups.bucket_count();
+        for (int i = 0; i < 5000; i++) groups[i]++;
+        EXPECT_EQ(groups.size(), 5000);
+        EXPECT_GE(groups.bucket_count(), groups.size());
+        EXPECT_GT(groups.bucket_count(), initial);
+
+        ac::AccountStore store;
+        for (int i = 0; i < 5000; i++) {
+                Account account("Client " + std::to_string(i), i % 7, i, i);
+                account.m_balance = float(i);
+                store.insert(account);
+        }
+        EXPECT_EQ(store.by_agency(3, 3).size(), 1);
+        EXPECT_EQ(store.by_name("Client 4999").size(), 1);
+        EXPECT_EQ(store.agency_aggregate(1, 4999).sum, 4999.);
+        for (int i = 0; i < 5000; i += 2) {
+                store.erase(Account("Client " + std::to_string(i), i % 7, i, i).getKey());
+        }
+        EXPECT_TRUE(store.by_agency(3, 10).empty());
+        EXPECT_EQ(store.bank_aggregate(3).count, 357);
+}
+
+//! \brief Checks the aggregates kept by a store against a full recompute.
+void expect_consistent(const ac::AccountStore &store, int bank, int agency) {
+        auto kept = store.agency_aggregate(bank, agency);
+        auto full = store.recompute(
+            [&](const Account &a) { return a.bank_num == bank && a.agency_num == agency; });
+        EXPECT_EQ(kept.count, full.count);
+        EXPECT_NEAR(kept.sum, full.sum, 1e-3);
+        EXPECT_EQ(kept.min, full.min);
+        EXPECT_EQ(kept.max, full.max);
+
+        kept = store.bank_aggregate(bank);
+        full = store.recompute([&](const Account &a) { return a.bank_num == bank; });
+        EXPECT_EQ(kept.count, full.count);
+        EXPECT_NEAR(kept.sum, full.sum, 1e-3);
+        EXPECT_EQ(kept.min, full.min);
+        EXPECT_EQ(kept.max, full.max);
+}
+
+TEST_F(HTTest, AccountStoreAggregates) {
+        ac::AccountStore store;
+        for (auto &a : m_accounts) store.insert(a);
+
+        auto bank = store.bank_aggregate(1);
+        EXPECT_EQ(bank.count, 2);
+        EXPECT_EQ(bank.sum, 1500. + 530.);
+        EXPECT_EQ(bank.min, 530.f);
+        EXPECT_EQ(bank.max, 1500.f);
+        EXPECT_EQ(bank.average(), (1500. + 530.) / 2);
+        expect_consistent(store, 1, 1668);
+
+        EXPECT_TRUE(store.set_balance(m_accounts[0].getKey(), 1e6f));
+        EXPECT_EQ(store.bank_aggregate(1).max, 1e6f);
+        EXPECT_FALSE(store.set_balance(Account("Nobody", 1, 1, 1).getKey(), 0));
+        expect_consistent(store, 1, 1668);
+
+        // NaN has no place in the ordered balances; infinities would turn the sums into NaN.
+        Account bad = m_accounts[0];
+        bad.m_balance = std::nanf("");
+        EXPECT_THROW(store.insert(bad), std::invalid_argument);
+        EXPECT_THROW(store.set_balance(bad.getKey(), INFINITY), std::invalid_argument);
+        EXPECT_EQ(store.bank_aggregate(1).max, 1e6f);
+        expect_consistent(store, 1, 1668);
+
+        for (auto &a : m_accounts) store.erase(a.getKey());
+        EXPECT_EQ(store.bank_aggregate(1).count, 0);
+        EXPECT_EQ(store.bank_aggregate(1).average(), 0);
+}
+
+TEST(AccountStore, AggregatesUnderChurn) {
+        ac::AccountStore store(ac::AccountStore::AGGREGATES);
+        std::mt19937 rng(7);
+        for (int step = 0; step < 20000; step++) {
+                int i = rng() % 2000;
+                Account account("Client " + std::to_string(i), i % 3, i % 7, i);
+                account.m_balance = float(rng() % 1000);
+                switch (rng() % 3) {
+                        case 0:
+                                store.insert(account);
+                                break;
+                        case 1:
+                                store.erase(account.getKey());
+                                break;
+                        default:
+                                store.set_balance(account.getKey(), account.m_balance);
+                                break;
+                }
+        }
+
+        for (int bank = 0; bank < 3; bank++) {
+                for (int agency = 0; agency < 7; agency++) expect_consistent(store, bank, agency);
+        }
+}
+
+// ============================================================================
+// TESTING RADIX TREE
+// ============================================================================
+
+TEST(RadixTree, InsertFindErase) {
+        ac::RadixTree<int> tree;
+        std::vector<std::string> words{"romane", "romanus", "romulus", "rubens",   "ruber",
+                                       "rubicon", "rubicundus", "", "r", "roman"};
+        for (size_t i = 0; i < words.size(); i++) EXPECT_TRUE(tree.insert(words[i], i));
+        EXPECT_FALSE(tree.insert("ruber", 42));
+        EXPECT_EQ(tree.size(), words.size());
+        EXPECT_LT(tree.node_count(), 2 * words.size());
+
+        EXPECT_EQ(*tree.find("ruber"), 42);
+        EXPECT_EQ(*tree.find(""), 7);
+        EXPECT_EQ(tree.find("rom"), nullptr);
+        EXPECT_EQ(tree.find("romanes"), nullptr);
+
+        std::vector<std::string> sorted;
+        tree.for_each([&](const std::string &k, int) { sorted.push_back(k); });
+        std::sort(words.begin(), words.end());
+        EXPECT_EQ(sorted, words);
+
+        size_t nodes = tree.node_count();
+        EXPECT_TRUE(tree.erase("romanus"));
+        EXPECT_FALSE(tree.erase("romanus"));
+        EXPECT_FALSE(tree.erase("rom"));
+        EXPECT_TRUE(tree.erase("roman"));  // "roman" and "romane" merge back.
+        EXPECT_LT(tree.node_count(), nodes);
+        EXPECT_EQ(*tree.find("romane"), 0);
+        EXPECT_EQ(tree.size(), words.size() - 2);
+}
+
+TEST(RadixTree, PrefixQueries) {
+        ac::RadixTree<int> tree;
+        for (int i = 0; i < 1000; i++) tree.insert(std::to_string(i), i);
+
+        std::vector<std::string> keys;
+        auto collect = [&](const std::string &k, int v) {
+                EXPECT_EQ(std::to_string(v), k);
+                keys.push_back(k);
+        };
+        EXPECT_EQ(tree.for_each_prefix("12", 100, collect), 11);
+        EXPECT_EQ(keys.front(), "12");
+        EXPECT_EQ(keys.back(), "129");
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+        keys.clear();
+        EXPECT_EQ(tree.for_each_prefix("9", 3, collect), 3);
+        EXPECT_EQ(keys, (std::vector<std::string>{"9", "90", "900"}));
+        EXPECT_EQ(tree.for_each_prefix("x", 3, collect), 0);
+        EXPECT_EQ(tree.for_each_prefix("", 5000, collect), 1000);
+}
+
+// Value counting its live instances, for the radix tree tests.
+struct Counted {
+        Counted() { live++; }
+        Counted(const Counted &) { live++; }
+        ~Counted() { live--; }
+        Counted &operator=(const Counted &) = default;
+
+        static int live;
+};
+
+int Counted::live = 0;
+
+TEST(RadixTree, ValuesOnlyWhereKeysEnd) {
+        {
+                ac::RadixTree<Counted> tree;
+                for (const char *word : {"romane", "romanus", "romulus", "rubens", "ruber"}) {
+                        tree[word];
+                }
+
+                // The root and the split nodes ("r", "om", "an", "ub", ...) hold no value.
+                EXPECT_GT(tree.node_count(), tree.size());
+                EXPECT_EQ(Counted::live, 5);
+                tree.erase("romane");
+                EXPECT_EQ(Counted::live, 4);
+        }
+        EXPECT_EQ(Counted::live, 0);
+}
+
+TEST_F(HTTest, AccountStoreByPrefix) {
+        for (unsigned indexes : {ac::AccountStore::BY_PREFIX, ac::AccountStore::NONE}) {
+                ac::AccountStore store(indexes);
+                for (auto &a : m_accounts) store.insert(a);
+                store.insert(Account("Jose Lima", 1, 1, 2));
+                store.insert(Account("Jose Luiz", 1, 1, 3));
+
+                auto accounts = store.by_prefix("Jose L", 10);
+                ASSERT_EQ(accounts.size(), 3);
+                EXPECT_EQ(accounts[0].m_name, "Jose Lima");
+                EXPECT_EQ(accounts[1].m_name, "Jose Lima");
+                EXPECT_EQ(accounts[2].m_name, "Jose Luiz");
+                EXPECT_EQ(store.by_prefix("Jose L", 2).size(), 2);
+                EXPECT_EQ(store.by_prefix("C", 10).size(), 2);
+
+                store.erase(Account("Jose Luiz", 1, 1, 3).getKey());
+                EXPECT_EQ(store.by_prefix("Jose Lu", 10).size(), 0);
+        }
+}
+
+// ============================================================================
+// TESTING TTL HASH TABLE
+// ============================================================================
+
+// Clock moved by hand, for the TTL tests.
+struct FakeClock {
+        using duration = std::chrono::milliseconds;
+        using rep = duration::rep;
+        using period = duration::period;
+        using time_point = std::chrono::time_point<FakeClock>;
+        static constexpr bool is_steady = true;
+
+        static time_point now() { return time_point(elapsed); }
+
+        static duration elapsed;
+};
+
+FakeClock::duration FakeClock::elapsed{0};
+
+using TtlTable = ac::TtlHashTbl<int, int, std::hash<int>, std::equal_to<int>, FakeClock>;
+using std::chrono::milliseconds;
+
+TEST(TtlHashTbl, ExpiredEntriesAreAbsent) {
+        FakeClock::elapsed = milliseconds(0);
+        TtlTable table;
+        table.insert(1, 10, milliseconds(100));
+        table.insert(2, 20);
+        int data;
+
+        FakeClock::elapsed = milliseconds(99);
+        EXPECT_TRUE(table.retrieve(1, data));
+        EXPECT_EQ(table.ttl(1), milliseconds(1));
+        EXPECT_EQ(table.ttl(2), milliseconds::max());
+
+        FakeClock::elapsed = milliseconds(100);
+        EXPECT_FALSE(table.retrieve(1, data));
+        EXPECT_LT(table.ttl(1).count(), 0);
+        EXPECT_FALSE(table.erase(1));
+        EXPECT_TRUE(table.insert(1, 11));  // An expired key is inserted anew.
+        EXPECT_TRUE(table.retrieve(1, data));
+        EXPECT_EQ(data, 11);
+        EXPECT_TRUE(table.retrieve(2, data));
+}
+
+TEST(TtlHashTbl, ExpireAndPersist) {
+        FakeClock::elapsed = milliseconds(0);
+        TtlTable table;
+        table.insert(1, 10, milliseconds(50));
+        table.insert(2, 20, milliseconds(50));
+        EXPECT_TRUE(table.expire(1, milliseconds(5000)));
+        EXPECT_TRUE(table.persist(2));
+        EXPECT_FALSE(table.expire(3, milliseconds(10)));
+
+        // The records left at 50 ms must not erase the refreshed entries.
+        FakeClock::elapsed = milliseconds(1000);
+        EXPECT_TRUE(table.tick(size_t(-1)));
+        EXPECT_EQ(table.size(), 2);
+        EXPECT_EQ(table.ttl(1), milliseconds(4000));
+
+        FakeClock::elapsed = milliseconds(5000);
+        EXPECT_TRUE(table.tick(size_t(-1)));
+        EXPECT_EQ(table.size(), 1);
+        int data;
+        EXPECT_TRUE(table.retrieve(2, data));
+        EXPECT_EQ(data, 20);
+}
+
+TEST(TtlHashTbl, SlidingTtlDropsStaleRecords) {
+        FakeClock::elapsed = milliseconds(0);
+        TtlTable table;
+        for (int i = 0; i < 100; i++) table.insert(i, i, milliseconds(1000));
+
+        // Every refresh leaves a stale record behind; the sweeps must keep the live ones.
+        for (int round = 0; round < 100; round++) {
+                FakeClock::elapsed += milliseconds(10);
+                for (int i = 0; i < 100; i += 2) EXPECT_TRUE(table.expire(i, milliseconds(1000)));
+        }
+
+        FakeClock::elapsed = milliseconds(1500);
+        EXPECT_TRUE(table.tick(size_t(-1)));
+        EXPECT_EQ(table.size(), 50);
+        EXPECT_EQ(table.ttl(0), milliseconds(500));
+
+        FakeClock::elapsed = milliseconds(2000);
+        EXPECT_TRUE(table.tick(size_t(-1)));
+        EXPECT_TRUE(table.empty());
+}
+
+TEST(TtlHashTbl, WheelReclaimsAcrossLevels) {
+        FakeClock::elapsed = milliseconds(0);
+        TtlTable table(milliseconds(1), 64);
+        // 10 ms, 5 s and 2 h land on levels 0, 2 and 3 of the wheel.
+        const std::array<long, 3> ttls{10, 5000, 2 * 3600 * 1000};
+        for (int i = 0; i < 300; i++) table.insert(i, i, milliseconds(ttls[i % 3] + i));
+
+        size_t left = 300;
+        for (long ttl : ttls) {
+                FakeClock::elapsed = milliseconds(ttl + 300);
+                while (!table.tick(1024)) {
+                }
+                left -= 100;
+                EXPECT_EQ(table.size(), left);
+                int count = 0;
+                table.for_each([&](int, int) { count++; });
+                EXPECT_EQ(count, left);
+        }
+        EXPECT_TRUE(table.empty());
+}
+
+TEST(TtlHashTbl, BoundedWorkPerOperation) {
+        FakeClock::elapsed = milliseconds(0);
+        TtlTable table(milliseconds(1), 8);
+        for (int i = 0; i < 1000; i++) table.insert(i, i, milliseconds(10));
+
+        // Everything expires at once, but an operation only does its budget of work.
+        FakeClock::elapsed = milliseconds(20);
+        int data;
+        EXPECT_FALSE(table.retrieve(0, data));
+        EXPECT_GT(table.size(), 900);
+        EXPECT_FALSE(table.tick(100));
+        EXPECT_TRUE(table.tick(1000));
+        EXPECT_TRUE(table.empty());
+}
+
+// ============================================================================
+// TESTING HOT KEY SAMPLING
+// ============================================================================
+
+TEST(CountMinSketch, NeverUnderestimates) {
+        ac::CountMinSketch<int> sketch(64, 4);
+        for (int i = 0; i < 1000; i++) sketch.add(i % 100, 1 + i % 3);
+        EXPECT_EQ(sketch.total(), 1999);
+        for (int k = 0; k < 100; k++) {
+                int n = 0;
+                for (int i = k; i < 1000; i += 100) n += 1 + i % 3;
+                EXPECT_GE(sketch.estimate(k), n);
+        }
+
+        sketch.clear();
+        EXPECT_EQ(sketch.estimate(1), 0);
+        EXPECT_THROW(ac::CountMinSketch<int>(0, 4), std::invalid_argument);
+}
+
+TEST(SpaceSaving, KeepsFrequentKeys) {
+        ac::SpaceSaving<std::string> top(8);
+        std::mt19937 rng(7);
+        for (int i = 0; i < 10000; i++) {
+                // "a" a third of the time, "b" a sixth, and noise over 1000 keys.
+                int r = rng() % 6;
+                top.add(r < 2 ? "a" : r == 2 ? "b" : std::to_string(rng() % 1000));
+        }
+
+        auto counters = top.top();
+        ASSERT_EQ(counters.size(), 8);
+        EXPECT_EQ(counters[0].m_key, "a");
+        EXPECT_EQ(counters[1].m_key, "b");
+        for (const auto& c : counters) EXPECT_LE(c.m_error, c.m_count);
+        EXPECT_GE(counters[0].m_count, 10000 / 3 - 200);
+        EXPECT_LE(counters[0].m_count - counters[0].m_error, 10000 / 3 + 200);
+}
+
+TEST(SampledHashTbl, FindsHotKeys) {
+        ac::SampledHashTbl<int, int> table(4, 8);
+        for (int i = 0; i < 1000; i++) table.insert(i, i);
+
+        std::mt19937 rng(11);
+        int data;
+        for (int i = 0; i < 100000; i++) {
+                // Keys 7 and 42 take 30% and 20% of the lookups.
+                int r = rng() % 10;
+                EXPECT_TRUE(table.retrieve(r < 3 ? 7 : r < 5 ? 42 : rng() % 1000, data));
+        }
+        EXPECT_EQ(table.samples(), 100000 / 4);
+
+        auto hot = table.heavy_hitters();
+        ASSERT_EQ(hot.size(), 8);
+        EXPECT_EQ(hot[0].m_key, 7);
+        EXPECT_EQ(hot[1].m_key, 42);
+        EXPECT_NEAR(hot[0].m_frequency, 30000, 2000);
+        EXPECT_NEAR(hot[1].m_frequency, 20000, 2000);
+        EXPECT_GE(table.estimate(7), hot[0].m_frequency - 1000);
+
+        table.set_period(0);
+        EXPECT_EQ(table.at(7), 7);
+        EXPECT_EQ(table.samples(), 0);
+        EXPECT_TRUE(table.heavy_hitters().empty());
+}
+
+TEST(SampledHashTbl, LookupsCannotBypassSampling) {
+        // No conversion to HashTbl, whose lookups would skip the sampling.
+        EXPECT_FALSE((std::is_convertible<ac::SampledHashTbl<int, int> &,
+                                          const ac::HashTbl<int, int> &>::value));
+
+        ac::SampledHashTbl<int, int> table(1, 4);
+        EXPECT_TRUE(table.insert(1, 10));
+        table[2] = 20;  // A lookup, that inserts.
+        EXPECT_EQ(table.samples(), 1);
+
+        int data;
+        EXPECT_TRUE(table.retrieve(1, data));
+        EXPECT_EQ(*table.find(2), 20);
+        EXPECT_EQ(table.at(1), 10);
+        EXPECT_EQ(table.samples(), 4);
+        EXPECT_EQ(table.estimate(1), 2);
+
+        EXPECT_TRUE(table.unsampled().retrieve(1, data));  // Explicitly not sampled.
+        EXPECT_TRUE(table.erase(2));
+        EXPECT_EQ(table.size(), 1);
+        EXPECT_EQ(table.samples(), 4);
+
+        table.clear();
+        EXPECT_TRUE(table.empty());
+        EXPECT_TRUE(table.insert(3, 30));
+}
+
+// ============================================================================
+// TESTING TABLE DIFF
+// ============================================================================
+
+TEST_F(HTTest, DiffAccounts) {
+        using Table = ac::HashTbl<Account::AcctKey, Account, AcctKeyHash, AcctKeyEqual>;
+        Table before, after;
+        for (auto &a : m_accounts) {
+                before.insert(a.getKey(), a);
+                after.insert(a.getKey(), a);
+        }
+
+        Account added("Ana Souza", 2, 2, 2, 10), moved = m_accounts[0], removed = m_accounts[1];
+        moved.m_balance += 100;
+        after.insert(added.getKey(), added);
+        after.insert(moved.getKey(), moved);
+        after.erase(removed.getKey());
+
+        for (size_t threads : {1, 4}) {
+                auto delta = ac::diff(before, after, threads, AcctBalanceEqual());
+                EXPECT_EQ(delta.m_added, std::vector<Account::AcctKey>{added.getKey()});
+                EXPECT_EQ(delta.m_removed, std::vector<Account::AcctKey>{removed.getKey()});
+                EXPECT_EQ(delta.m_changed, std::vector<Account::AcctKey>{moved.getKey()});
+        }
+
+        // Account::operator== ignores the balance, but the default comparison of accounts does not.
+        Table paid = before;
+        Account payee = m_accounts[2];
+        payee.m_balance -= 1;
+        paid.insert(payee.getKey(), payee);
+        auto delta = ac::diff(before, paid);
+        EXPECT_TRUE(delta.m_added.empty());
+        EXPECT_TRUE(delta.m_removed.empty());
+        EXPECT_EQ(delta.m_changed, std::vector<Account::AcctKey>{payee.getKey()});
+}
+
+TEST(TableDiff, ParallelMatchesSerial) {
+        // Tables of different sizes are compared by lookups, of the same size bucket by bucket.
+        ac::HashTbl<int, int> before(11), after(100003), same_size(before);
+        for (int i = 0; i < 100000; i++) {
+                if (i % 5 != 0) before.insert(i, i);
+                if (i % 7 != 0) after.insert(i, i % 3 == 0 ? -i : i);
+        }
+        same_size = before;
+        for (int i = 0; i < 100000; i++) {
+                if (i % 7 == 0) same_size.erase(i);
+                if (i % 5 == 0 && i % 7 != 0) same_size.insert(i, i);
+                if (i % 3 == 0 && i % 7 != 0) same_size.insert(i, -i);
+        }
+        ASSERT_EQ(same_size.bucket_count(), before.bucket_count());
+        ASSERT_NE(after.bucket_count(), before.bucket_count());
+
+        std::map<ac::Change, std::vector<int>> expected;
+        for (int i = 1; i < 100000; i++) {
+                if (i % 5 == 0 && i % 7 != 0) expected[ac::Change::ADDED].push_back(i);
+                if (i % 5 != 0 && i % 7 == 0) expected[ac::Change::REMOVED].push_back(i);
+                if (i % 5 != 0 && i % 7 != 0 && i % 3 == 0) {
+                        expected[ac::Change::CHANGED].push_back(i);
+                }
+        }
+
+        for (auto table : {&after, &same_size}) {
+                for (size_t threads : {1, 3, 8}) {
+                        std::map<ac::Change, std::vector<int>> found;
+                        ac::for_each_change(before, *table, [&](ac::Change c, int key) {
+                                found[c].push_back(key);
+                        }, threads);
+                        for (auto &f : found) std::sort(f.second.begin(), f.second.end());
+                        EXPECT_EQ(found, expected);
+                }
+        }
+
+        EXPECT_THROW(ac::for_each_change(before, after, [](ac::Change, int) {
+                throw std::runtime_error("sink");
+        }, 4), std::runtime_error);
+}
+
+// ============================================================================
+// TESTING COMPACTION
+// ============================================================================
+
+TEST(HashTblCompact, RelocatesInScanOrder) {
+        ac::HashTbl<int, std::string> table;
+        std::map<int, std::string> expected;
+        std::mt19937 rng(3);
+        for (int i = 0; i < 200000; i++) {
+                // Churn: the nodes left are spread over the heap.
+                int key = rng() % 50000;
+                if (rng() % 3 == 0) {
+                        table.erase(key);
+                        expected.erase(key);
+                } else {
+                        table.insert(key, std::to_string(i));
+                        expected.insert_or_assign(key, std::to_string(i));
+                }
+        }
+
+        auto before = table.stats();
+        EXPECT_EQ(before.m_arena_entries, 0);
+        EXPECT_TRUE(table.compact());
+        auto after = table.stats();
+        EXPECT_EQ(after.m_entries, expected.size());
+        EXPECT_EQ(after.m_arena_entries, expected.size());
+        EXPECT_LT(after.m_pages, before.m_pages);
+        EXPECT_LT(after.fragmentation(), 0.05);
+        EXPECT_LT(after.fragmentation() * 4, before.fragmentation());
+
+        for (auto &e : expected) EXPECT_EQ(table.at(e.first), e.second);
+        table.for_each([&](int key, const std::string &data) { EXPECT_EQ(expected[key], data); });
+
+        // A copy lives on the heap, and outlives the arena of the original.
+        auto copy = std::make_unique<ac::HashTbl<int, std::string>>(table);
+        EXPECT_EQ(copy->stats().m_arena_entries, 0);
+        table = ac::HashTbl<int, std::string>();
+        EXPECT_EQ(copy->at(expected.begin()->first), expected.begin()->second);
+}
+
+TEST(HashTblCompact, IncrementalWithUpdates) {
+        ac::HashTbl<int, int> table;
+        std::map<int, int> expected;
+        for (int i = 0; i < 5000; i++) {
+                table.insert(i, i);
+                expected[i] = i;
+        }
+
+        // The pass goes on while the table is used, and grows (rehash) under it.
+        int passes = 0, next = 5000;
+        for (int round = 0; passes < 3; round++) {
+                if (table.compact(500)) passes++;
+                for (int i = 0; i < 200; i++, next++) {
+                        table.insert(next, next);
+                        expected[next] = next;
+                        table.erase(next - 3000);
+                        expected.erase(next - 3000);
+                }
+        }
+
+        EXPECT_EQ(table.size(), expected.size());
+        for (auto &e : expected) EXPECT_EQ(table.at(e.first), e.second);
+        EXPECT_TRUE(table.compact());
+        EXPECT_EQ(table.stats().m_arena_entries, expected.size());
+}
+
 int main(int argc, char **argv) {
         ::testing::InitGoogleTest(&argc, argv);
         return RUN_ALL_TESTS();
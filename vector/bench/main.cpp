@@ -0,0 +1,448 @@
+#ifdef __linux__
+#include <sys/resource.h>  // getrusage
+#include <sys/wait.h>      // waitpid
+#include <unistd.h>        // fork
+#endif
+
+#include <algorithm>                       // std::remove_if
+#include <chrono>                          // std::chrono
+#include <cstdio>                          // std::printf
+#include <functional>                      // std::function
+#include <map>                             // std::map
+#include <mutex>                           // std::mutex
+#include <random>                          // std::mt19937
+#include <string>                          // std::string
+#include <thread>                          // std::thread
+#include <utility>                         // std::move
+#include <vector>                          // std::vector
+#include "../include/concurrent_vector.h"  // alt::concurrent_vector
+#include "../include/segmented_vector.h"   // alt::segmented_vector
+#include "../include/small_vector.h"       // alt::small_vector
+#include "../include/static_vector.h"      // alt::static_vector
+#include "../include/vector.h"             // alt::vector
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+using Clock = std::chrono::steady_clock;
+
+//! \brief Seconds elapsed since start.
+double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//! \brief Heap-allocated string (beyond the small string buffer) for element i.
+std::string payload(size_t i) {
+        return "payload #" + std::to_string(i) + " of a string on the heap";
+}
+
+#ifdef __GLIBC__
+// Every allocation of the process goes through malloc (operator new included), which is
+// replaced here by a counting one.
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+
+static size_t allocations = 0;  //!< Calls to malloc and realloc so far.
+
+extern "C" void* malloc(size_t size) {
+        allocations++;
+        return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* block, size_t size) {
+        allocations++;
+        return __libc_realloc(block, size);
+}
+#else
+static size_t allocations = 0;  //!< Not counted: malloc is only replaced on glibc.
+#endif
+
+//! \brief String whose move may throw, so that containers copy it when they grow.
+struct CopiedString {
+        std::string m_value;  //!< The string.
+
+        CopiedString(std::string value) : m_value(std::move(value)) {}
+        CopiedString(const CopiedString&) = default;
+        CopiedString(CopiedString&& other) noexcept(false) : m_value(std::move(other.m_value)) {}
+};
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+//! \brief Growth of vectors of 1M heap strings: elements copied against moved on reallocation.
+void bench_strings(void) {
+        const size_t n = 1000000;
+
+        // \brief Times push_back of n strings, with no reserve(), and a reserve() to twice that.
+        auto run = [&](const char* name, auto&& vec, auto&& push) {
+                auto start = Clock::now();
+                for (size_t i = 0; i < n; i++) push(vec, payload(i));
+                double fill = seconds_since(start);
+
+                start = Clock::now();
+                vec.reserve(2 * n);
+                double grow = seconds_since(start);
+
+                std::printf("%-34s %14.1f %14.1f\n", name, fill * 1e3, grow * 1e3);
+        };
+
+        std::printf("%-34s %14s %14s\n", "", "push_back ms", "reserve(2n) ms");
+        run("alt::vector, copied (throwing move)", alt::vector<CopiedString>(),
+            [](auto& v, std::string s) { v.push_back(CopiedString(std::move(s))); });
+        run("alt::vector, push_back(const&)", alt::vector<std::string>(),
+            [](auto& v, std::string s) { v.push_back(s); });
+        run("alt::vector, push_back(&&)", alt::vector<std::string>(),
+            [](auto& v, std::string s) { v.push_back(std::move(s)); });
+        run("alt::vector, emplace_back", alt::vector<std::string>(),
+            [](auto& v, std::string s) { v.emplace_back(std::move(s)); });
+        run("std::vector, push_back(&&)", std::vector<std::string>(),
+            [](auto& v, std::string s) { v.push_back(std::move(s)); });
+}
+
+//! \brief Erase near the front of large vectors, and erase_if over 100M ints.
+void bench_erase(void) {
+        const size_t n = 1000000, k = 1000;
+
+        // \brief Times the erase of k elements at the front of n, as a range or one by one.
+        auto front = [&](auto vec, bool one_by_one) {
+                for (size_t i = 0; i < n; i++) vec.push_back(int(i));
+
+                auto start = Clock::now();
+                if (one_by_one) {
+                        for (size_t i = 0; i < k; i++) vec.erase(vec.begin() + 10);
+                } else {
+                        vec.erase(vec.begin() + 10, vec.begin() + 10 + k);
+                }
+                return seconds_since(start) * 1e3;
+        };
+
+        std::printf("%-34s %12s %12s\n", "1k erased at the front of 1M ints", "alt ms", "std ms");
+        std::printf("%-34s %12.2f %12.2f\n", "one by one", front(alt::vector<int>(), true),
+                    front(std::vector<int>(), true));
+        std::printf("%-34s %12.2f %12.2f\n", "range", front(alt::vector<int>(), false),
+                    front(std::vector<int>(), false));
+
+        // A random half of the elements is erased: a branch on the predicate mispredicts often.
+        const size_t big = 100000000;
+        std::mt19937 rng(1);
+        alt::vector<int> alt_vec;
+        std::vector<int> std_vec;
+        for (size_t i = 0; i < big; i++) {
+                int x = int(rng());
+                alt_vec.push_back(x);
+                std_vec.push_back(x);
+        }
+        auto odd = [](int x) { return (x & 1) != 0; };
+
+        auto start = Clock::now();
+        alt::erase_if(alt_vec, odd);
+        double alt_time = seconds_since(start);
+
+        start = Clock::now();
+        std_vec.erase(std::remove_if(std_vec.begin(), std_vec.end(), odd), std_vec.end());
+        double std_time = seconds_since(start);
+
+        std::printf("\n%-34s %12s %12s\n", "erase_if, 100M ints", "alt ms", "std ms");
+        std::printf("%-34s %12.1f %12.1f\n", "random half erased", alt_time * 1e3,
+                    std_time * 1e3);
+}
+
+//! \brief Growth and front inserts of int vectors: bytes moved by realloc/mremap/memmove.
+void bench_pod(void) {
+        // \brief Times n push_back with no reserve(), then a reserve() to twice that.
+        auto grow = [](auto&& vec, size_t n, double& fill, double& reserve) {
+                auto start = Clock::now();
+                for (size_t i = 0; i < n; i++) vec.push_back(int(i));
+                fill = seconds_since(start);
+
+                start = Clock::now();
+                vec.reserve(2 * n);
+                reserve = seconds_since(start);
+        };
+
+        std::printf("%-12s %14s %14s %14s %14s\n", "ints", "alt fill ms", "std fill ms",
+                    "alt 2n ms", "std 2n ms");
+        for (size_t n : {size_t(1) << 20, size_t(1) << 24, size_t(1) << 27}) {
+                double alt_fill, alt_reserve, std_fill, std_reserve;
+                grow(alt::vector<int>(), n, alt_fill, alt_reserve);
+                grow(std::vector<int>(), n, std_fill, std_reserve);
+                std::printf("%-12zu %14.1f %14.1f %14.2f %14.2f\n", n, alt_fill * 1e3,
+                            std_fill * 1e3, alt_reserve * 1e3, std_reserve * 1e3);
+        }
+
+        // \brief Time per insert at the front of a vector of 10M ints.
+        auto front = [](auto&& vec) {
+                const size_t n = 10000000, inserts = 200;
+                for (size_t i = 0; i < n; i++) vec.push_back(int(i));
+
+                auto start = Clock::now();
+                for (size_t i = 0; i < inserts; i++) vec.insert(vec.begin(), -int(i));
+                return seconds_since(start) / inserts;
+        };
+
+        std::printf("\n%-12s %14s %14s\n", "", "alt ms", "std ms");
+        std::printf("%-12s %14.2f %14.2f\n", "front insert", front(alt::vector<int>()) * 1e3,
+                    front(std::vector<int>()) * 1e3);
+}
+
+//! \brief Insertion of 10k elements in the middle of 1M: one range insert against k inserts.
+void bench_range(void) {
+        const size_t n = 1000000, k = 10000;
+
+        // \brief Times the insertion of source in the middle of a vector of n elements.
+        auto run = [&](const char* name, auto vec, const auto& source, bool one_by_one) {
+                for (size_t i = 0; i < n; i++) vec.push_back(source[i % k]);
+
+                auto start = Clock::now();
+                if (one_by_one) {
+                        auto pos = vec.begin() + n / 2;
+                        for (const auto& x : source) pos = vec.insert(pos, x) + 1;
+                } else {
+                        vec.insert(vec.begin() + n / 2, source.begin(), source.end());
+                }
+                std::printf("%-36s %12.2f\n", name, seconds_since(start) * 1e3);
+        };
+
+        std::vector<int> ints(k);
+        std::vector<std::string> strings(k);
+        for (size_t i = 0; i < k; i++) {
+                ints[i] = int(i);
+                strings[i] = payload(i);
+        }
+
+        std::printf("%-36s %12s\n", "", "ms");
+        run("int, alt::vector k inserts", alt::vector<int>(), ints, true);
+        run("int, alt::vector range insert", alt::vector<int>(), ints, false);
+        run("int, std::vector range insert", std::vector<int>(), ints, false);
+        run("string, alt::vector range insert", alt::vector<std::string>(), strings, false);
+        run("string, std::vector range insert", std::vector<std::string>(), strings, false);
+}
+
+//! \brief 1M containers of 0 to 7 ints: allocations and time, inline storage against the heap.
+void bench_small(void) {
+        const size_t n = 1000000, rounds = 5;
+        std::mt19937 rng(7);
+        std::vector<size_t> sizes(n);
+        for (auto& size : sizes) size = rng() % 8;
+
+        // \brief Times the construction, fill, sum and destruction of n containers.
+        auto run = [&](const char* name, auto make) {
+                size_t before = allocations;
+                long sum = 0;
+                auto start = Clock::now();
+                for (size_t r = 0; r < rounds; r++) {
+                        for (size_t i = 0; i < n; i++) {
+                                auto vec = make();
+                                for (size_t j = 0; j < sizes[i]; j++) vec.push_back(int(i + j));
+                                for (int x : vec) sum += x;
+                        }
+                }
+                double time = seconds_since(start) / rounds;
+                size_t count = (allocations - before) / rounds;
+                std::printf("%-30s %14.1f %14zu %8ld\n", name, time * 1e3, count, sum % 10);
+        };
+
+        std::printf("%-30s %14s %14s %8s\n", "1M containers, 0-7 ints", "ms", "allocations",
+                    "check");
+        run("alt::vector", [] { return alt::vector<int>(); });
+        run("std::vector", [] { return std::vector<int>(); });
+        run("alt::small_vector<int, 8>", [] { return alt::small_vector<int, 8>(); });
+        run("alt::small_vector<int, 4>", [] { return alt::small_vector<int, 4>(); });
+}
+
+//! \brief 1M bounded requests of 0 to 16 ints: allocations and time of fixed-capacity storage.
+void bench_static(void) {
+        const size_t n = 1000000, rounds = 5;
+        std::mt19937 rng(11);
+        std::vector<size_t> sizes(n);
+        for (auto& size : sizes) size = rng() % 17;
+
+        // \brief Times the construction, fill, insert at the front, sum and destruction of n
+        // containers.
+        auto run = [&](const char* name, auto make) {
+                size_t before = allocations;
+                long sum = 0;
+                auto start = Clock::now();
+                for (size_t r = 0; r < rounds; r++) {
+                        for (size_t i = 0; i < n; i++) {
+                                auto vec = make();
+                                for (size_t j = 1; j < sizes[i]; j++) vec.push_back(int(i + j));
+                                if (sizes[i] > 0) vec.insert(vec.begin(), int(i));
+                                for (int x : vec) sum += x;
+                        }
+                }
+                double time = seconds_since(start) / rounds;
+                size_t count = (allocations - before) / rounds;
+                std::printf("%-30s %14.1f %14zu %8ld\n", name, time * 1e3, count, sum % 10);
+        };
+
+        std::printf("%-30s %14s %14s %8s\n", "1M requests, 0-16 ints", "ms", "allocations",
+                    "check");
+        run("alt::static_vector<int, 16>", [] { return alt::static_vector<int, 16>(); });
+        run("alt::small_vector<int, 16>", [] { return alt::small_vector<int, 16>(); });
+        run("alt::vector, reserve(16)", [] { return alt::vector<int>(16); });
+        run("std::vector, reserve(16)", [] {
+                std::vector<int> vec;
+                vec.reserve(16);
+                return vec;
+        });
+}
+
+//! \brief Append of 24M events and 6M strings: growth pauses, peak memory and reads of a
+//! segmented_vector against contiguous vectors.
+void bench_segmented(void) {
+        //! Trivially copyable event record.
+        struct Event {
+                long time;  //!< Timestamp.
+                long id;    //!< Event id.
+        };
+
+        // \brief Appends n elements, timing the appends to a full container apart, then reads
+        // them in order and at random. Runs in a child process, for its own peak memory.
+        auto run = [](const char* name, auto vec, size_t n, auto make, auto key) {
+#ifdef __linux__
+                std::fflush(stdout);
+                if (pid_t child = fork()) {
+                        waitpid(child, nullptr, 0);
+                        return;
+                }
+#endif
+                double worst = 0;
+                auto start = Clock::now();
+                for (size_t i = 0; i < n; i++) {
+                        if (vec.size() == vec.capacity()) {
+                                auto pause = Clock::now();
+                                vec.push_back(make(i));
+                                worst = std::max(worst, seconds_since(pause));
+                        } else {
+                                vec.push_back(make(i));
+                        }
+                }
+                double fill = seconds_since(start);
+
+                long sum = 0;
+                start = Clock::now();
+                for (const auto& x : vec) sum += key(x);
+                double scan = seconds_since(start);
+
+                std::mt19937 rng(13);
+                start = Clock::now();
+                for (size_t i = 0; i < 10000000; i++) sum += key(vec[rng() % n]);
+                double random = seconds_since(start);
+
+                long peak_mb = 0;
+#ifdef __linux__
+                rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+                peak_mb = usage.ru_maxrss / 1024;
+#endif
+                std::printf("%-30s %10.1f %10.2f %10ld %10.1f %10.1f %4ld\n", name, fill * 1e3,
+                            worst * 1e3, peak_mb, scan * 1e3, random * 1e3, sum % 10);
+#ifdef __linux__
+                std::fflush(stdout);
+                _exit(0);
+#endif
+        };
+
+        auto event = [](size_t i) { return Event{long(i), long(i) * 7}; };
+        auto event_key = [](const Event& e) { return e.id; };
+        auto string = [](size_t i) { return std::string(1 + i % 15, 'x'); };
+        auto string_key = [](const std::string& s) { return long(s.size()); };
+
+        // Not powers of two: the contiguous vectors end up with a quarter of their room unused.
+        const size_t events = size_t(24) << 20, strings = size_t(6) << 20;
+
+        std::printf("%-30s %10s %10s %10s %10s %10s %4s\n", "", "fill ms", "pause ms", "peak MB",
+                    "scan ms", "rand ms", "");
+        run("24M events, std::vector", std::vector<Event>(), events, event, event_key);
+        run("24M events, alt::vector", alt::vector<Event>(), events, event, event_key);
+        run("24M events, segmented_vector", alt::segmented_vector<Event>(), events, event,
+            event_key);
+        run("6M strings, std::vector", std::vector<std::string>(), strings, string, string_key);
+        run("6M strings, alt::vector", alt::vector<std::string>(), strings, string, string_key);
+        run("6M strings, segmented_vector", alt::segmented_vector<std::string>(), strings, string,
+            string_key);
+}
+
+//! \brief 16M appends split among 1 to 64 producer threads: a mutex around alt::vector against
+//! the lock-free appends of concurrent_vector.
+void bench_concurrent(void) {
+        const size_t n = size_t(1) << 24, batch = 256;
+
+        // \brief Times threads producers, each appending its share of n with append(t, i).
+        auto run = [&](size_t threads, auto append) {
+                std::vector<std::thread> producers;
+                auto start = Clock::now();
+                for (size_t t = 0; t < threads; t++) {
+                        producers.emplace_back([&, t] {
+                                for (size_t i = t * (n / threads); i < (t + 1) * (n / threads);) {
+                                        i += append(t, i);
+                                }
+                        });
+                }
+                for (auto& producer : producers) producer.join();
+                return n / seconds_since(start) / 1e6;
+        };
+
+        std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+        std::printf("%-8s %16s %16s %16s\n", "threads", "mutex Mops/s", "push_back Mops/s",
+                    "grow_by Mops/s");
+        for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+                alt::vector<long> locked;
+                std::mutex mutex;
+                double locked_rate = run(threads, [&](size_t, size_t i) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        locked.push_back(long(i));
+                        return 1;
+                });
+
+                alt::concurrent_vector<long> pushed;
+                double pushed_rate = run(threads, [&](size_t, size_t i) {
+                        pushed.push_back(long(i));
+                        return 1;
+                });
+
+                // Each producer parses a batch of records locally, then appends it at once.
+                alt::concurrent_vector<long> grown;
+                double grown_rate = run(threads, [&](size_t, size_t i) {
+                        long records[batch];
+                        for (size_t j = 0; j < batch; j++) records[j] = long(i + j);
+                        grown.grow_by(records, records + batch);
+                        return int(batch);
+                });
+
+                if (locked.size() != n || pushed.size() != n || grown.size() != n) {
+                        std::printf("size mismatch\n");
+                }
+                std::printf("%-8zu %16.1f %16.1f %16.1f\n", threads, locked_rate, pushed_rate,
+                            grown_rate);
+        }
+}
+
+int main(int argc, char** argv) {
+        std::map<std::string, std::function<void(void)>> benchmarks{
+            {"concurrent", bench_concurrent},
+            {"erase", bench_erase},
+            {"pod", bench_pod},
+            {"range", bench_range},
+            {"segmented", bench_segmented},
+            {"small", bench_small},
+            {"static", bench_static},
+            {"strings", bench_strings},
+        };
+
+        // Run the benchmarks named in the command line, or all of them.
+        for (const auto& b : benchmarks) {
+                bool selected = argc == 1;
+                for (int i = 1; i < argc; i++) selected = selected || b.first == argv[i];
+                if (!selected) continue;
+
+                std::printf("=== %s ===\n", b.first.c_str());
+                b.second();
+                std::printf("\n");
+        }
+
+        return 0;
+}
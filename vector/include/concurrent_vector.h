@@ -0,0 +1,320 @@
+/*!
+ * \file concurrent_vector.h
+ * \n https://github.com/imns1ght/vector
+ */
+
+#ifndef CONCURRENT_VECTOR_H
+#define CONCURRENT_VECTOR_H
+
+#include <algorithm>           // std::max, std::min
+#include <atomic>              // std::atomic
+#include <cstddef>             // std::size_t
+#include <cstdint>             // std::uint64_t
+#include <iterator>            // std::distance
+#include <memory>              // std::destroy
+#include <new>                 // placement new, std::align_val_t
+#include <stdexcept>           // std::out_of_range
+#include <type_traits>         // std::is_nothrow_move_constructible
+#include <utility>             // std::move, std::forward
+#include "segmented_vector.h"  // alt::detail::segments
+
+namespace alt {
+
+//! \brief Sequence container that many threads append to at once, with no lock: elements never
+//! move, and readers use any index below size() while the appends go on.
+//!
+//! An append reserves its slots with one atomic add, constructs the elements in them, and marks
+//! them ready. size() is the published size: the length of the prefix of ready elements, which
+//! the appending threads advance together, so that a slow thread holds back the publication of
+//! the slots after its own, never the appends. The elements live in chunks of geometric sizes,
+//! as in segmented_vector; the first thread to need a chunk allocates it and installs it with a
+//! compare-and-swap.
+//!
+//! Once a slot is reserved it must be filled: elements are built before the reservation and
+//! moved into their slot (their move may not throw), and if a copy of grow_by() or the allocation
+//! of a chunk throws, std::terminate is called. clear() and the destructor need every thread to
+//! be done with the container.
+template <typename T>
+class concurrent_vector {
+        static_assert(std::is_nothrow_move_constructible<T>::value,
+                      "the elements are moved into their reserved slots, which cannot fail");
+
+        typedef detail::segments segments;        // Layout of the chunks.
+        typedef std::atomic<std::uint64_t> word;  // 64 ready bits.
+
+       public:
+        // Container common interface.
+        typedef T value_type;              //!< The value type.
+        typedef T& reference;              //!< Reference to a value.
+        typedef const T& const_reference;  //!< Const reference to a value.
+        typedef T* pointer;                //!< Pointer to a value.
+        typedef unsigned long size_type;   //!< The size type.
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Default constructor: constructs an empty container, with no memory.
+        concurrent_vector() = default;
+
+        //! \brief Constructs an empty container with room for count elements.
+        //! \param count Capacity of the container; no element is constructed.
+        explicit concurrent_vector(size_type count) { reserve(count); }
+
+        // Threads hold references to the elements and the container: it stays in place.
+        concurrent_vector(const concurrent_vector&) = delete;
+        concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+        //! \brief Desconstructor: no thread may use the container any more.
+        ~concurrent_vector(void) {
+                clear();
+                for (size_type k = 0; k < segments::MAX_CHUNKS; k++) {
+                        unsigned char* block = m_chunks[k].load(std::memory_order_relaxed);
+                        if (block != nullptr) ::operator delete(block, std::align_val_t(ALIGN));
+                }
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Capacity
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns the published size: elements [0, size()) are constructed, and visible
+        //! to the calling thread. It only grows, while appends go on.
+        size_type size(void) const { return m_published.load(std::memory_order_acquire); }
+
+        //! \brief Returns whether no element is published yet.
+        bool empty(void) const { return size() == 0; }
+
+        //! \brief Allocates the chunks for count elements up front; safe with concurrent appends.
+        //! \param count Capacity requested.
+        void reserve(size_type count) {
+                if (count == 0) return;
+                for (size_type k = 0; k <= segments::chunk_of(count - 1); k++) chunk(k);
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Element access
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns a reference to the element at position pos, with no bounds check.
+        //! \param pos Position below a size() the calling thread read, or an index an append of
+        //! the calling thread returned.
+        reference operator[](size_type pos) { return *slot(pos); }
+
+        //! \brief Returns a const reference to the element at position pos, with no bounds check.
+        //! \param pos Position below a size() the calling thread read, or an index an append of
+        //! the calling thread returned.
+        const_reference operator[](size_type pos) const { return *slot(pos); }
+
+        //! \brief Returns a reference to the element at position pos.
+        //! \param pos Position of an element; std::out_of_range if not below size().
+        reference at(size_type pos) {
+                if (pos >= size()) throw std::out_of_range("out of range!");
+                return *slot(pos);
+        }
+
+        //! \brief Returns a const reference to the element at position pos.
+        //! \param pos Position of an element; std::out_of_range if not below size().
+        const_reference at(size_type pos) const {
+                if (pos >= size()) throw std::out_of_range("out of range!");
+                return *slot(pos);
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Modifiers
+        ///////////////////////////////////////////////////////////////////////////////
+
+        // Appends return the index of their first element: other threads append too, so it is
+        // not size() - 1.
+
+        //! \brief Appends a copy of value; lock-free.
+        //! \param value Value to be copied.
+        //! \return Index of the element.
+        size_type push_back(const_reference value) { return emplace_back(value); }
+
+        //! \brief Appends value, moving it; lock-free.
+        //! \param value Value to be moved.
+        //! \return Index of the element.
+        size_type push_back(value_type&& value) { return emplace_back(std::move(value)); }
+
+        //! \brief Appends an element constructed from args; lock-free.
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Index of the element.
+        template <typename... Args>
+        size_type emplace_back(Args&&... args) {
+                T value(std::forward<Args>(args)...);  // If it throws, no slot is taken.
+                size_type index = m_reserved.fetch_add(1);
+                fill(index, 1, [&](pointer slot) { ::new (slot) T(std::move(value)); });
+                return index;
+        }
+
+        //! \brief Appends count copies of value, at consecutive indices; lock-free.
+        //! \param count Number of elements.
+        //! \param value Value to be copied.
+        //! \return Index of the first element.
+        size_type grow_by(size_type count, const_reference value = value_type()) {
+                size_type index = m_reserved.fetch_add(count);
+                fill(index, count, [&](pointer slot) { ::new (slot) T(value); });
+                return index;
+        }
+
+        //! \brief Appends the elements of [first, last), at consecutive indices; lock-free.
+        //! \param first Forward iterator for the first element.
+        //! \param last Forward iterator for the past-end element.
+        //! \return Index of the first element.
+        template <typename ForwardItr>
+        size_type grow_by(ForwardItr first, ForwardItr last) {
+                size_type count = std::distance(first, last);
+                size_type index = m_reserved.fetch_add(count);
+                fill(index, count, [&](pointer slot) { ::new (slot) T(*first++); });
+                return index;
+        }
+
+        //! \brief Removes all elements (which are destroyed); the memory is kept. No other thread
+        //! may use the container meanwhile.
+        void clear(void) {
+                size_type size = m_published.load(std::memory_order_relaxed);
+                for (size_type k = 0; size > 0 && k <= segments::chunk_of(size - 1); k++) {
+                        unsigned char* block = m_chunks[k].load(std::memory_order_relaxed);
+                        size_type start = segments::chunk_start(k);
+                        size_type live = std::min(size - start, segments::chunk_size(k));
+                        std::destroy(elements(block, k), elements(block, k) + live);
+                        for (size_type w = 0; w < words(k); w++) bits(block)[w].store(0);
+                }
+                m_reserved.store(0);
+                m_published.store(0);
+        }
+
+       private:
+        // A chunk is one block: the ready bits of its elements, then the elements, on a cache line
+        // boundary.
+        static const size_type ALIGN = alignof(T) > 64 ? alignof(T) : 64;
+
+        std::atomic<unsigned char*> m_chunks[segments::MAX_CHUNKS] = {};  //!< Index table.
+
+        // The two counters are written by every append: each has a cache line of its own.
+        alignas(64) std::atomic<size_type> m_reserved{0};   //!< Slots handed out to appends.
+        alignas(64) std::atomic<size_type> m_published{0};  //!< Ready prefix: the size.
+
+        // \brief Number of words of ready bits of chunk k.
+        static size_type words(size_type k) { return (segments::chunk_size(k) + 63) / 64; }
+
+        // \brief Offset of the elements in the block of chunk k.
+        static size_type offset(size_type k) { return (words(k) * 8 + ALIGN - 1) / ALIGN * ALIGN; }
+
+        // \brief Ready bits in a block.
+        static word* bits(unsigned char* block) { return reinterpret_cast<word*>(block); }
+
+        // \brief Elements in the block of chunk k.
+        static pointer elements(unsigned char* block, size_type k) {
+                return reinterpret_cast<pointer>(block + offset(k));
+        }
+
+        // \brief Block of chunk k, allocated and installed by the first thread that needs it.
+        unsigned char* chunk(size_type k) {
+                unsigned char* block = m_chunks[k].load(std::memory_order_acquire);
+                if (block != nullptr) return block;
+
+                size_type bytes = offset(k) + segments::chunk_size(k) * sizeof(T);
+                auto fresh =
+                    static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(ALIGN)));
+                for (size_type w = 0; w < words(k); w++) ::new (bits(fresh) + w) word(0);
+                if (m_chunks[k].compare_exchange_strong(block, fresh, std::memory_order_acq_rel)) {
+                        return fresh;
+                }
+                ::operator delete(fresh, std::align_val_t(ALIGN));  // Another thread won.
+                return block;
+        }
+
+        // \brief Slot of element i, in an installed chunk.
+        pointer slot(size_type i) const {
+                size_type k = segments::chunk_of(i);
+                unsigned char* block = m_chunks[k].load(std::memory_order_acquire);
+                return elements(block, k) + (i - segments::chunk_start(k));
+        }
+
+        // \brief Calls construct(slot) on the reserved slots [index, index + count), in order, one
+        // chunk at a time, and publishes them: at once if they come right after the published
+        // size (no other append is behind), else by marking them ready. Then it helps to advance
+        // the published size over the slots of other appends.
+        template <typename Construct>
+        void fill(size_type index, size_type count, Construct construct) noexcept {
+                for (size_type i = index, last = index + count; i < last;) {
+                        size_type k = segments::chunk_of(i);
+                        size_type start = segments::chunk_start(k);
+                        size_type end = std::min(last, start + segments::chunk_size(k));
+                        pointer first = elements(chunk(k), k);
+                        for (size_type j = i; j < end; j++) construct(first + (j - start));
+                        i = end;
+                }
+
+                size_type expected = index;
+                if (m_published.compare_exchange_strong(expected, index + count)) {
+                        // No slot reserved after these yet: the later reservations come after
+                        // this load (all of these operations are sequentially consistent), so
+                        // their appends see these slots published, and nothing is left to help.
+                        if (m_reserved.load() == index + count) return;
+                } else {
+                        for (size_type i = index, last = index + count; i < last;) {
+                                size_type k = segments::chunk_of(i);
+                                size_type start = segments::chunk_start(k);
+                                size_type end = std::min(last, start + segments::chunk_size(k));
+                                mark(chunk(k), i - start, end - start);
+                                i = end;
+                        }
+                }
+                publish();
+        }
+
+        // \brief Marks the slots [from, to) of a chunk as ready.
+        static void mark(unsigned char* block, size_type from, size_type to) {
+                while (from < to) {
+                        size_type bit = from % 64;
+                        size_type n = std::min<size_type>(to - from, 64 - bit);
+                        std::uint64_t mask = ~std::uint64_t(0) >> (64 - n);  // n ones.
+                        bits(block)[from / 64].fetch_or(mask << bit);  // Releases the elements.
+                        from += n;
+                }
+        }
+
+        // \brief Advances the published size over the ready slots that follow it. Each append
+        // calls it after publishing or marking its slots, so that the last append of a ready
+        // prefix to do so (in the single order of these sequentially consistent operations) sees
+        // the others, and publishes the whole prefix.
+        void publish(void) {
+                size_type size = m_published.load();
+                while (true) {
+                        size_type k = segments::chunk_of(size);
+                        unsigned char* block = m_chunks[k].load();
+                        if (block == nullptr) return;
+
+                        // The run of ready slots from size, in its word of ready bits.
+                        size_type at = size - segments::chunk_start(k);
+                        std::uint64_t ready = bits(block)[at / 64].load() >> (at % 64);
+                        size_type run = ~ready == 0 ? 64 : ctz(~ready);
+                        run = std::min(run, 64 - at % 64);
+                        if (run == 0) return;
+
+                        // On failure, size is reloaded: another thread published.
+                        if (m_published.compare_exchange_weak(size, size + run)) size += run;
+                }
+        }
+
+        // \brief Number of trailing zero bits of x (x != 0).
+        static size_type ctz(std::uint64_t x) {
+#if defined(__GNUC__)
+                return __builtin_ctzll(x);
+#else
+                size_type n = 0;
+                while ((x & 1) == 0) {
+                        x >>= 1;
+                        n++;
+                }
+                return n;
+#endif
+        }
+};
+
+}  // namespace alt
+
+#endif
@@ -1,90 +1,149 @@
+#ifndef ITERATOR_H
+#define ITERATOR_H
+
+#include <cstddef>      // std::ptrdiff_t
+#include <iterator>     // std::random_access_iterator_tag, std::contiguous_iterator_tag
+#include <ostream>      // std::ostream
+#include <type_traits>  // std::remove_cv_t, std::enable_if_t, std::is_convertible
+
+//! \brief Random access iterator over contiguous elements (a contiguous_iterator in C++20).
+//!
+//! It wraps a plain pointer, so every operation is O(1), and the standard algorithms can take the
+//! fast paths they have for random access, and in C++20 for contiguous, ranges. An iterator
+//! converts to a const one, and the comparisons take one of each. Everything but the stream
+//! output is constexpr, for containers usable in constant expressions.
 template <typename T>
 class vec_iterator {
        public:
         // iterator_traits common interface.
-        typedef T value_type;                    //!< Value type the vec_iterator points to.
+        typedef std::remove_cv_t<T> value_type;  //!< Value type the vec_iterator points to.
         typedef T* pointer;                      //!< Pointer to the value type.
         typedef T& reference;                    //!< Reference to the value type.
         typedef std::ptrdiff_t difference_type;  //!< Used to calculated distance between iterators.
-        typedef std::bidirectional_iterator_tag iterator_category;  //!< Iterator category.
+        typedef std::random_access_iterator_tag iterator_category;  //!< Iterator category.
+#if __cplusplus >= 202002L
+        typedef std::contiguous_iterator_tag iterator_concept;  //!< Iterator concept (C++20).
+#endif
 
-        vec_iterator(pointer ptr = nullptr) : current{ptr} {};
+        constexpr vec_iterator(pointer ptr = nullptr) : current{ptr} {};
 
-        vec_iterator(const vec_iterator<T>& l) : current(l.current){};
+        constexpr vec_iterator(const vec_iterator<T>& l) : current(l.current){};
 
-        ~vec_iterator(){};
+        //! iterator -> const_iterator
+        template <typename U,
+                  typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        constexpr vec_iterator(const vec_iterator<U>& l) : current(l.current){};
 
         //! it1 = it2;
-        vec_iterator& operator=(const vec_iterator& rhs) {
+        constexpr vec_iterator& operator=(const vec_iterator& rhs) {
                 current = rhs.current;
                 return *this;
         }
 
         //! ++it;
-        vec_iterator operator++() {
+        constexpr vec_iterator& operator++() {
                 ++current;
                 return *this;
         }
 
         //! it++;
-        vec_iterator operator++(int) {
-                ++current;
-                return vec_iterator(current - 1);
-        }
+        constexpr vec_iterator operator++(int) { return vec_iterator(current++); }
 
         //! --it;
-        vec_iterator operator--() { return vec_iterator(--current); }
+        constexpr vec_iterator& operator--() {
+                --current;
+                return *this;
+        }
 
         //! it--;
-        vec_iterator operator--(int) {
-                current--;
-                return vec_iterator(current + 1);
+        constexpr vec_iterator operator--(int) { return vec_iterator(current--); }
+
+        //! it += n;
+        constexpr vec_iterator& operator+=(difference_type n) {
+                current += n;
+                return *this;
         }
 
-        //! it = it1 - it2;
-        difference_type operator-(const vec_iterator& rhs) { return current - rhs.current; }
+        //! it -= n;
+        constexpr vec_iterator& operator-=(difference_type n) {
+                current -= n;
+                return *this;
+        }
 
-        //! *it = x;
-        reference operator*(void) { return *current; }
+        //! it = it1 - it2;
+        friend constexpr difference_type operator-(const vec_iterator& lhs,
+                                                   const vec_iterator& rhs) {
+                return lhs.current - rhs.current;
+        }
 
-        //! x = *it;
-        reference operator*(void)const { return *current; }
+        //! x = *it; *it = x;
+        constexpr reference operator*(void) const { return *current; }
 
         //! it->
-        pointer operator->(void)const {
-                assert(current != nullptr);
-                return current;
-        }
+        //! Valid on any iterator, even past-the-end or null, as std::to_address requires.
+        constexpr pointer operator->(void) const { return current; }
+
+        //! it[n]
+        constexpr reference operator[](difference_type n) const { return current[n]; }
 
         //! n + it
-        friend vec_iterator operator+(difference_type n, vec_iterator it) {
-                return vec_iterator(std::next(it, n));
+        friend constexpr vec_iterator operator+(difference_type n, vec_iterator it) {
+                return vec_iterator(it.current + n);
         }
 
         //! it + n
-        friend vec_iterator operator+(vec_iterator it, difference_type n) {
-                return vec_iterator(std::next(it, n));
+        friend constexpr vec_iterator operator+(vec_iterator it, difference_type n) {
+                return vec_iterator(it.current + n);
         }
 
-        //! n - it
-        friend vec_iterator operator-(difference_type n, vec_iterator it) {
-                return vec_iterator(std::prev(it, n));
+        //! n - it (same as it - n)
+        friend constexpr vec_iterator operator-(difference_type n, vec_iterator it) {
+                return vec_iterator(it.current - n);
         }
 
         //! it - n
-        friend vec_iterator operator-(vec_iterator it, difference_type n) {
-                return vec_iterator(std::prev(it, n));
+        friend constexpr vec_iterator operator-(vec_iterator it, difference_type n) {
+                return vec_iterator(it.current - n);
         }
 
         //! it1 == it2
-        bool operator==(const vec_iterator& it) const { return (current == it.current); }
+        friend constexpr bool operator==(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current == rhs.current;
+        }
 
         //! it1 != it2
-        bool operator!=(const vec_iterator& it) const { return (current != it.current); }
+        friend constexpr bool operator!=(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current != rhs.current;
+        }
+
+        //! it1 < it2
+        friend constexpr bool operator<(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current < rhs.current;
+        }
+
+        //! it1 > it2
+        friend constexpr bool operator>(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current > rhs.current;
+        }
+
+        //! it1 <= it2
+        friend constexpr bool operator<=(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current <= rhs.current;
+        }
+
+        //! it1 >= it2
+        friend constexpr bool operator>=(const vec_iterator& lhs, const vec_iterator& rhs) {
+                return lhs.current >= rhs.current;
+        }
 
         //! << it
         friend std::ostream& operator<<(std::ostream& os, const vec_iterator<T>& v) { return os << *v; }
 
        private:
+        template <typename U>
+        friend class vec_iterator;  // const_iterator reads the pointer of iterator.
+
         T* current;
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,532 @@
+/*!
+ * \file segmented_vector.h
+ * \n https://github.com/imns1ght/vector
+ */
+
+#ifndef SEGMENTED_VECTOR_H
+#define SEGMENTED_VECTOR_H
+
+#include <algorithm>         // std::min, std::equal
+#include <cstddef>           // std::ptrdiff_t, std::size_t
+#include <initializer_list>  // std::initializer_list
+#include <iterator>          // std::random_access_iterator_tag
+#include <memory>            // std::allocator, std::destroy
+#include <new>               // placement new
+#include <stdexcept>         // std::length_error, std::out_of_range
+#include <type_traits>       // std::remove_cv_t, std::enable_if_t, std::is_convertible
+#include <utility>           // std::move, std::forward
+
+namespace alt {
+
+namespace detail {
+
+// \brief Layout of the chunks of a segmented_vector: chunk k holds FIRST << k elements, and
+// starts at element FIRST * (2^k - 1), so that the chunk of an element is found from the top bit
+// of its index, with no search.
+struct segments {
+        static const unsigned FIRST_BITS = 4;                            // log2 of FIRST.
+        static const std::size_t FIRST = std::size_t(1) << FIRST_BITS;  // Size of chunk 0.
+        static const std::size_t MAX_CHUNKS = 64 - FIRST_BITS;           // Chunks to fill 2^64.
+
+        // \brief Index of the highest bit set in x (x > 0).
+        static std::size_t top_bit(std::size_t x) {
+#if defined(__GNUC__)
+                return 63 - __builtin_clzll(x);
+#else
+                std::size_t bit = 0;
+                while (x >>= 1) bit++;
+                return bit;
+#endif
+        }
+
+        // \brief Chunk that holds element i. The top bit of i + FIRST is at FIRST_BITS or above:
+        // setting that bit changes nothing, but tells the compiler the chunk is in the table.
+        static std::size_t chunk_of(std::size_t i) {
+                return top_bit((i + FIRST) | FIRST) - FIRST_BITS;
+        }
+
+        // \brief Index of the first element of chunk k (elements in the chunks before it).
+        static std::size_t chunk_start(std::size_t k) { return (FIRST << k) - FIRST; }
+
+        // \brief Number of elements chunk k holds.
+        static std::size_t chunk_size(std::size_t k) { return FIRST << k; }
+};
+
+}  // namespace detail
+
+//! \brief Random access iterator over the elements of a segmented_vector.
+//!
+//! It keeps the position in the current chunk, so that ++ and -- cost a pointer step, except at
+//! the chunk boundaries; jumps find their chunk in O(1). It holds a pointer to the index table of
+//! the container, so moving the container invalidates it (pointers to elements stay valid).
+template <typename T>
+class seg_iterator {
+       public:
+        // iterator_traits common interface.
+        typedef std::remove_cv_t<T> value_type;  //!< Value type the seg_iterator points to.
+        typedef T* pointer;                      //!< Pointer to the value type.
+        typedef T& reference;                    //!< Reference to the value type.
+        typedef std::ptrdiff_t difference_type;  //!< Used to calculated distance between iterators.
+        typedef std::random_access_iterator_tag iterator_category;  //!< Iterator category.
+
+        seg_iterator(void) = default;
+
+        //! \brief Iterator to element index of the chunks in table.
+        seg_iterator(T* const* table, std::size_t index) : m_table{table}, m_index{index} {
+                seat();
+        }
+
+        //! iterator -> const_iterator
+        template <typename U,
+                  typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        seg_iterator(const seg_iterator<U>& l)
+            : m_table{l.m_table},
+              m_index{l.m_index},
+              m_ptr{l.m_ptr},
+              m_chunk_begin{l.m_chunk_begin},
+              m_chunk_end{l.m_chunk_end} {}
+
+        //! ++it;
+        seg_iterator& operator++() {
+                ++m_index;
+                if (++m_ptr == m_chunk_end) seat();  // Next chunk.
+                return *this;
+        }
+
+        //! it++;
+        seg_iterator operator++(int) {
+                seg_iterator old = *this;
+                ++*this;
+                return old;
+        }
+
+        //! --it;
+        seg_iterator& operator--() {
+                --m_index;
+                if (m_ptr == m_chunk_begin) {
+                        seat();  // Previous chunk.
+                } else {
+                        --m_ptr;
+                }
+                return *this;
+        }
+
+        //! it--;
+        seg_iterator operator--(int) {
+                seg_iterator old = *this;
+                --*this;
+                return old;
+        }
+
+        //! it += n;
+        seg_iterator& operator+=(difference_type n) {
+                m_index += n;
+                seat();
+                return *this;
+        }
+
+        //! it -= n;
+        seg_iterator& operator-=(difference_type n) { return *this += -n; }
+
+        //! it = it1 - it2;
+        friend difference_type operator-(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return difference_type(lhs.m_index - rhs.m_index);
+        }
+
+        //! x = *it; *it = x;
+        reference operator*(void) const { return *m_ptr; }
+
+        //! it->
+        pointer operator->(void) const { return m_ptr; }
+
+        //! it[n]
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        //! n + it
+        friend seg_iterator operator+(difference_type n, seg_iterator it) { return it += n; }
+
+        //! it + n
+        friend seg_iterator operator+(seg_iterator it, difference_type n) { return it += n; }
+
+        //! it - n
+        friend seg_iterator operator-(seg_iterator it, difference_type n) { return it -= n; }
+
+        //! it1 == it2
+        friend bool operator==(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index == rhs.m_index;
+        }
+
+        //! it1 != it2
+        friend bool operator!=(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index != rhs.m_index;
+        }
+
+        //! it1 < it2
+        friend bool operator<(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index < rhs.m_index;
+        }
+
+        //! it1 > it2
+        friend bool operator>(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index > rhs.m_index;
+        }
+
+        //! it1 <= it2
+        friend bool operator<=(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index <= rhs.m_index;
+        }
+
+        //! it1 >= it2
+        friend bool operator>=(const seg_iterator& lhs, const seg_iterator& rhs) {
+                return lhs.m_index >= rhs.m_index;
+        }
+
+       private:
+        template <typename U>
+        friend class seg_iterator;  // const_iterator reads the position of iterator.
+
+        T* const* m_table = nullptr;  // Index table of the container.
+        std::size_t m_index = 0;      // Index of the element.
+        T* m_ptr = nullptr;           // The element (nullptr if its chunk is not allocated).
+        T* m_chunk_begin = nullptr;   // First slot of the chunk of the element.
+        T* m_chunk_end = nullptr;     // Past the last slot of the chunk of the element.
+
+        // \brief Points to element m_index, in its chunk.
+        void seat(void) {
+                std::size_t k = detail::segments::chunk_of(m_index);
+                m_chunk_begin = m_table[k];
+                if (m_chunk_begin == nullptr) {
+                        m_ptr = m_chunk_end = nullptr;  // Past the memory of the container.
+                        return;
+                }
+                m_ptr = m_chunk_begin + (m_index - detail::segments::chunk_start(k));
+                m_chunk_end = m_chunk_begin + detail::segments::chunk_size(k);
+        }
+};
+
+//! \brief Sequence container that stores its elements in chunks of geometric sizes (16, 32, 64,
+//! ...), reached through a fixed index table.
+//!
+//! Growing allocates one more chunk, as large as all the previous ones: no element is ever
+//! copied or moved, so pointers and references to the elements stay valid until they are erased,
+//! and the memory in use stays below twice the size (plus the first chunk), with no old buffer
+//! beside a new one. Access by index is O(1), from the top bit of the index. Elements are only
+//! added and removed at the end; the chunks can be walked one by one, as contiguous arrays.
+template <typename T>
+class segmented_vector {
+        typedef detail::segments segments;  // Layout of the chunks.
+
+       public:
+        // Container common interface.
+        typedef T value_type;                          //!< The value type.
+        typedef T& reference;                          //!< Reference to a value.
+        typedef const T& const_reference;              //!< Const reference to a value.
+        typedef T* pointer;                            //!< Pointer to a value.
+        typedef seg_iterator<T> iterator;              //!< Iterator.
+        typedef seg_iterator<const T> const_iterator;  //!< Const iterator.
+        typedef unsigned long size_type;               //!< The size type.
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Default constructor: constructs an empty container, with no memory.
+        segmented_vector() = default;
+
+        //! \brief Constructs an empty container with room for count elements.
+        //! \param count Capacity of the container; no element is constructed.
+        explicit segmented_vector(size_type count) { reserve(count); }
+
+        //! \brief Constructs the container with the contents of the range [first, last).
+        //! \param first Iterator for the first element for insertion.
+        //! \param last Iterator for the last element for insertion.
+        template <typename InputIt>
+        segmented_vector(InputIt first, InputIt last) {
+                try {
+                        for (; first != last; ++first) emplace_back(*first);
+                } catch (...) {
+                        release();
+                        throw;
+                }
+        }
+
+        //! \brief Constructs the container with the deep copy of the contents of other.
+        //! \param other Container for copy.
+        segmented_vector(const segmented_vector& other) {
+                try {
+                        reserve(other.size());
+                        for (const T& value : other) emplace_back(value);
+                } catch (...) {
+                        release();
+                        throw;
+                }
+        }
+
+        //! \brief Constructs the container with the contents of other, which is left empty.
+        //! \param other Container to move from.
+        segmented_vector(segmented_vector&& other) noexcept { take(other); }
+
+        //! \brief Constructs the container with the contents of the initializer list.
+        //! \param ilist Initializer list for copy.
+        segmented_vector(std::initializer_list<value_type> ilist)
+            : segmented_vector(ilist.begin(), ilist.end()) {}
+
+        //! \brief Desconstructor.
+        ~segmented_vector(void) { release(); }
+
+        //! \brief Copy assignment: copies all the elements from other into the container.
+        //! \param other Container of the same type.
+        segmented_vector& operator=(const segmented_vector& other) {
+                if (this != &other) {
+                        segmented_vector copy(other);  // If it throws, the container is untouched.
+                        *this = std::move(copy);
+                }
+                return *this;
+        }
+
+        //! \brief Move assignment: moves the elements of other into the container.
+        //! \param other Container of the same type.
+        segmented_vector& operator=(segmented_vector&& other) noexcept {
+                if (this != &other) {
+                        release();
+                        take(other);
+                }
+                return *this;
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Compare functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Checks if the contents of lhs and rhs are equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are equal, false otherwise.
+        bool operator==(const segmented_vector& rhs) const {
+                return size() == rhs.size() && std::equal(cbegin(), cend(), rhs.cbegin());
+        }
+
+        //! \brief Checks if the contents of lhs and rhs are not equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are not equal, false otherwise.
+        bool operator!=(const segmented_vector& rhs) const { return !(*this == rhs); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Iterators
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Return iterator to the beginning.
+        iterator begin(void) { return iterator(m_chunks, 0); }
+
+        //! \brief Returns iterator to the past-end.
+        iterator end(void) { return iterator(m_chunks, m_size); }
+
+        //! \brief Returns a const_iterator to the beginning.
+        const_iterator begin(void) const { return cbegin(); }
+
+        //! \brief Returns a const_iterator to the past-end.
+        const_iterator end(void) const { return cend(); }
+
+        //! \brief Returns a const_iterator to the beginning.
+        const_iterator cbegin(void) const { return const_iterator(m_chunks, 0); }
+
+        //! \brief Returns a const_iterator to the past-end.
+        const_iterator cend(void) const { return const_iterator(m_chunks, m_size); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Chunks
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns the number of chunks that hold elements.
+        size_type chunk_count(void) const {
+                return m_size == 0 ? 0 : segments::chunk_of(m_size - 1) + 1;
+        }
+
+        //! \brief Returns the elements of chunk k, an array of chunk_size(k) elements.
+        //! \param k Chunk, in [0, chunk_count()).
+        pointer chunk_data(size_type k) { return m_chunks[k]; }
+
+        //! \brief Returns the elements of chunk k, an array of chunk_size(k) elements.
+        //! \param k Chunk, in [0, chunk_count()).
+        const T* chunk_data(size_type k) const { return m_chunks[k]; }
+
+        //! \brief Returns the number of elements in chunk k (all but the last chunk are full).
+        //! \param k Chunk, in [0, chunk_count()).
+        size_type chunk_size(size_type k) const { return live(k); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Capacity
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns the number of elements in the container.
+        size_type size(void) const { return m_size; }
+
+        //! \brief Returns the number of elements the allocated chunks can hold.
+        size_type capacity(void) const { return segments::chunk_start(m_chunk_count); }
+
+        //! \brief Returns whether the container is empty
+        bool empty(void) const { return m_size == 0; }
+
+        //! \brief Allocates chunks until there is room for new_cap elements; nothing moves.
+        //! \param new_cap Capacity requested.
+        void reserve(size_type new_cap) {
+                while (capacity() < new_cap) add_chunk();
+                seat();
+        }
+
+        //! \brief Releases the chunks that hold no element.
+        void shrink_to_fit(void) {
+                while (m_chunk_count > chunk_count()) {
+                        --m_chunk_count;
+                        std::allocator<T>().deallocate(m_chunks[m_chunk_count],
+                                                       segments::chunk_size(m_chunk_count));
+                        m_chunks[m_chunk_count] = nullptr;
+                }
+                seat();
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Element access
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns a reference to the element at position pos, with no bounds check.
+        reference operator[](size_type pos) { return *locate(pos); }
+
+        //! \brief Returns a const reference to the element at position pos, with no bounds check.
+        const_reference operator[](size_type pos) const { return *locate(pos); }
+
+        //! \brief Returns a reference to the element at position pos.
+        //! \param pos Position of an element in the container; std::out_of_range if past size().
+        reference at(size_type pos) {
+                if (pos >= m_size) throw std::out_of_range("out of range!");
+                return *locate(pos);
+        }
+
+        //! \brief Returns a const reference to the element at position pos.
+        //! \param pos Position of an element in the container; std::out_of_range if past size().
+        const_reference at(size_type pos) const {
+                if (pos >= m_size) throw std::out_of_range("out of range!");
+                return *locate(pos);
+        }
+
+        //! \brief Returns a reference to the first element.
+        reference front(void) { return m_chunks[0][0]; }
+
+        //! \brief Returns a const reference to the first element.
+        const_reference front(void) const { return m_chunks[0][0]; }
+
+        //! \brief Returns a reference to the last element.
+        reference back(void) { return *locate(m_size - 1); }
+
+        //! \brief Returns a const reference to the last element.
+        const_reference back(void) const { return *locate(m_size - 1); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Modifiers
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Insert value to the end of the container.
+        //! \param value Value to be copied.
+        void push_back(const_reference value) { emplace_back(value); }
+
+        //! \brief Moves value to the end of the container.
+        //! \param value Value to be moved.
+        void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+        //! \brief Constructs an element in place at the end of the container.
+        //! \param args Arguments forwarded to the constructor of the element (they may refer to
+        //! elements: those never move).
+        //! \return Reference to the element constructed.
+        template <typename... Args>
+        reference emplace_back(Args&&... args) {
+                if (m_next == m_limit) {
+                        // The chunk is full: on to the next one, allocated if needed.
+                        if (m_size == capacity()) add_chunk();
+                        seat();
+                }
+                ::new (static_cast<void*>(m_next)) T(std::forward<Args>(args)...);
+                m_size++;
+                return *m_next++;
+        }
+
+        //! \brief Removes the last element of the container; the memory is kept.
+        void pop_back(void) {
+                --m_size;
+                locate(m_size)->~T();
+                seat();
+        }
+
+        //! \brief Removes all elements from the container (which are destroyed); the memory is
+        //! kept.
+        void clear(void) {
+                for (size_type k = 0; k < chunk_count(); k++) {
+                        std::destroy(m_chunks[k], m_chunks[k] + live(k));
+                }
+                m_size = 0;
+                seat();
+        }
+
+       private:
+        // Only the elements in [0, m_size) are alive, in the chunks [0, chunk_count()); the other
+        // slots of the m_chunk_count chunks allocated are raw memory.
+        pointer m_chunks[segments::MAX_CHUNKS] = {};  //!< Index table: chunk k, or nullptr.
+        size_type m_chunk_count = 0;                  //!< Chunks allocated.
+        size_type m_size = 0;                         //!< Number of elements.
+        pointer m_next = nullptr;                     //!< Slot of the next element appended.
+        pointer m_limit = nullptr;                    //!< End of the chunk of m_next.
+
+        // \brief Slot of element i (i < capacity()).
+        pointer locate(size_type i) const {
+                size_type k = segments::chunk_of(i);
+                return m_chunks[k] + (i - segments::chunk_start(k));
+        }
+
+        // \brief Elements alive in chunk k.
+        size_type live(size_type k) const {
+                size_type start = segments::chunk_start(k);
+                return m_size <= start ? 0 : std::min(m_size - start, segments::chunk_size(k));
+        }
+
+        // \brief Allocates the next chunk, as large as all the ones before it (plus FIRST).
+        void add_chunk(void) {
+                if (m_chunk_count == segments::MAX_CHUNKS) {
+                        throw std::length_error("segmented_vector is full!");
+                }
+                size_type count = segments::chunk_size(m_chunk_count);
+                m_chunks[m_chunk_count] = std::allocator<T>().allocate(count);
+                m_chunk_count++;
+        }
+
+        // \brief Points m_next and m_limit to the slot of element m_size, if it is allocated.
+        void seat(void) {
+                if (m_size == capacity()) {
+                        m_next = m_limit = nullptr;
+                        return;
+                }
+                size_type k = segments::chunk_of(m_size);
+                m_next = m_chunks[k] + (m_size - segments::chunk_start(k));
+                m_limit = m_chunks[k] + segments::chunk_size(k);
+        }
+
+        // \brief Takes the chunks of other (the container must have none); other is left empty.
+        void take(segmented_vector& other) {
+                std::copy(other.m_chunks, other.m_chunks + other.m_chunk_count, m_chunks);
+                std::fill(other.m_chunks, other.m_chunks + other.m_chunk_count, nullptr);
+                m_chunk_count = other.m_chunk_count;
+                m_size = other.m_size;
+                m_next = other.m_next;
+                m_limit = other.m_limit;
+
+                other.m_chunk_count = other.m_size = 0;
+                other.m_next = other.m_limit = nullptr;
+        }
+
+        // \brief Destroys the elements and releases the chunks; the container is left empty.
+        void release(void) {
+                clear();
+                shrink_to_fit();
+        }
+};
+
+}  // namespace alt
+
+#endif
@@ -0,0 +1,251 @@
+/*!
+ * \file small_vector.h
+ * \n https://github.com/imns1ght/vector
+ */
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>         // std::equal
+#include <cstddef>           // std::size_t
+#include <initializer_list>  // std::initializer_list
+#include <memory>            // std::uninitialized_move, std::destroy
+#include <type_traits>       // std::is_nothrow_move_constructible
+#include "vector.h"          // alt::vector, whose internals are shared
+
+namespace alt {
+
+namespace detail {
+
+// \brief Inline buffer of a small_vector. It is a base listed before alt::vector, so that it
+// exists when its address is handed to the vector.
+template <typename T, std::size_t N>
+struct small_buffer {
+        alignas(T) unsigned char m_buffer[N * sizeof(T)];  //!< Inline storage for N elements.
+
+        // \brief Inline buffer, as raw memory for elements.
+        T* buffer(void) { return reinterpret_cast<T*>(m_buffer); }
+        const T* buffer(void) const { return reinterpret_cast<const T*>(m_buffer); }
+};
+
+}  // namespace detail
+
+//! \brief Sequence container with the API of alt::vector, which keeps up to N elements in a
+//! buffer of its own and only goes to the heap beyond that.
+//!
+//! Short sequences cost no allocation at all. Once the elements spill to the heap, the container
+//! grows as alt::vector; shrink_to_fit() brings them back inline when they fit again. Moving a
+//! small_vector moves its elements one by one while they are inline, so iterators to them are
+//! invalidated.
+template <typename T, std::size_t N = 8>
+class small_vector : private detail::small_buffer<T, N>, private vector<T> {
+        static_assert(N > 0, "small_vector needs room for at least one inline element");
+
+        typedef vector<T> base;  // The storage and the algorithms are those of alt::vector.
+        typedef detail::small_buffer<T, N> inline_buffer;
+
+       public:
+        // Container common interface.
+        typedef typename base::value_type value_type;            //!< The value type.
+        typedef typename base::reference reference;              //!< Reference to a value.
+        typedef typename base::const_reference const_reference;  //!< Const reference to a value.
+        typedef typename base::pointer pointer;                  //!< Pointer to a value.
+        typedef typename base::iterator iterator;                //!< Iterator.
+        typedef typename base::const_iterator const_iterator;    //!< Const iterator.
+        typedef typename base::size_type size_type;              //!< The size type.
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Default constructor: constructs an empty container on the inline buffer.
+        small_vector() : base(buffer(), N) {}
+
+        //! \brief Constructs an empty container with room for count elements.
+        //! \param count Capacity of the container; no element is constructed.
+        explicit small_vector(size_type count) : base(buffer(), N) { base::reserve(count); }
+
+        //! \brief Constructs the container with the contents of the range [first, last).
+        //! \param first Iterator for the first element for insertion.
+        //! \param last Iterator for the last element for insertion.
+        template <typename InputIt>
+        small_vector(InputIt first, InputIt last) : base(buffer(), N) {
+                base::assign(first, last);
+        }
+
+        //! \brief Constructs the container with the deep copy of the contents of other.
+        //! \param other Container for copy.
+        small_vector(const small_vector& other) : base(buffer(), N) {
+                base::assign(other.cbegin(), other.cend());
+        }
+
+        //! \brief Constructs the container with the contents of other, which is left empty.
+        //! Heap memory is taken over; inline elements are moved one by one.
+        //! \param other Container to move from.
+        small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+            : base(buffer(), N) {
+                take(other);
+        }
+
+        //! \brief Constructs the container with the contents of the initializer list.
+        //! \param ilist Initializer list for copy.
+        small_vector(std::initializer_list<value_type> ilist) : base(buffer(), N) {
+                base::assign(ilist);
+        }
+
+        //! \brief Desconstructor.
+        ~small_vector(void) {
+                base::clear();  // The elements go before the buffer that holds them.
+                if (is_small()) {
+                        // Detach the buffer: the destructor of alt::vector must not free it.
+                        this->m_storage = nullptr;
+                        this->m_capacity = 0;
+                }
+        }
+
+        //! \brief Copy assignment: copies all the elements from other into the container.
+        //! \param other Container of the same type.
+        small_vector& operator=(const small_vector& other) {
+                if (this != &other) base::assign(other.cbegin(), other.cend());
+                return *this;
+        }
+
+        //! \brief Move assignment: moves the elements of other into the container.
+        //! \param other Container of the same type.
+        small_vector& operator=(small_vector&& other) noexcept(
+            std::is_nothrow_move_constructible<T>::value) {
+                if (this != &other) {
+                        base::clear();
+                        take(other);
+                }
+                return *this;
+        }
+
+        //! \brief initializer list assignment: copies the elements of il into the container.
+        //! \param ilist initializer_list object to copy content.
+        small_vector& operator=(std::initializer_list<value_type> ilist) {
+                base::assign(ilist);
+                return *this;
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Compare functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Checks if the contents of lhs and rhs are equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are equal, false otherwise.
+        bool operator==(const small_vector& rhs) const {
+                return size() == rhs.size() && std::equal(cbegin(), cend(), rhs.cbegin());
+        }
+
+        //! \brief Checks if the contents of lhs and rhs are not equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are not equal, false otherwise.
+        bool operator!=(const small_vector& rhs) const { return !(*this == rhs); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // The rest of the API is the one of alt::vector
+        ///////////////////////////////////////////////////////////////////////////////
+
+        // Iterators.
+        using base::begin;
+        using base::cbegin;
+        using base::cend;
+        using base::end;
+
+        // Capacity.
+        using base::capacity;
+        using base::empty;
+        using base::reserve;
+        using base::size;
+
+        //! \brief Requests the container to reduce its capacity to fit its size, moving the
+        //! elements back to the inline buffer if they fit there.
+        void shrink_to_fit(void) {
+                if (is_small()) return;  // The inline buffer is never released.
+                if (this->m_size > N) {
+                        base::shrink_to_fit();
+                        return;
+                }
+
+                // Back to the inline buffer.
+                pointer heap = this->m_storage;
+                base::relocate(heap, heap + this->m_size, buffer());
+                std::destroy(heap, heap + this->m_size);
+                base::deallocate(heap, this->m_capacity);
+                this->m_storage = buffer();
+                this->m_capacity = N;
+        }
+
+        //! \brief Returns whether the elements are in the inline buffer.
+        //! \return True if no heap memory is in use, false otherwise.
+        bool is_small(void) const { return this->m_storage == inline_buffer::buffer(); }
+
+        // Element access.
+        using base::operator[];
+        using base::at;
+        using base::back;
+        using base::data;
+        using base::front;
+
+        // Modifiers.
+        using base::assign;
+        using base::clear;
+        using base::emplace;
+        using base::emplace_back;
+        using base::erase;
+        using base::insert;
+        using base::pop_back;
+        using base::push_back;
+
+       private:
+        using inline_buffer::buffer;
+
+        // \brief The inline buffer is not to be freed, nor grown in place.
+        bool owns_storage(void) const override { return !is_small(); }
+
+        // \brief Takes the elements of other (the container must be empty): its heap memory if it
+        // has some, else a move of each element. Other is left empty, on its inline buffer.
+        void take(small_vector& other) {
+                if (!other.is_small()) {
+                        base::deallocate_storage();
+                        this->m_storage = other.m_storage;
+                        this->m_capacity = other.m_capacity;
+                        other.m_storage = other.buffer();
+                        other.m_capacity = N;
+                } else {
+                        std::uninitialized_move(other.m_storage, other.m_storage + other.m_size,
+                                                this->m_storage);
+                        std::destroy(other.m_storage, other.m_storage + other.m_size);
+                }
+                this->m_size = other.m_size;
+                other.m_size = 0;
+        }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Non-member functions
+///////////////////////////////////////////////////////////////////////////////
+
+//! \brief Erases every element that satisfies a predicate, in one pass over the container.
+//! \param vec Container to filter.
+//! \param pred Predicate called once per element, in order.
+//! \return Number of elements erased.
+template <typename T, std::size_t N, typename Predicate>
+typename small_vector<T, N>::size_type erase_if(small_vector<T, N>& vec, Predicate pred) {
+        return detail::erase_if(vec, pred);
+}
+
+//! \brief Erases every element equal to a value, in one pass over the container.
+//! \param vec Container to filter.
+//! \param value Value to erase.
+//! \return Number of elements erased.
+template <typename T, std::size_t N, typename U>
+typename small_vector<T, N>::size_type erase(small_vector<T, N>& vec, const U& value) {
+        return detail::erase_if(vec, [&value](const T& element) { return element == value; });
+}
+
+}  // namespace alt
+
+#endif
@@ -0,0 +1,559 @@
+/*!
+ * \file static_vector.h
+ * \n https://github.com/imns1ght/vector
+ */
+
+#ifndef STATIC_VECTOR_H
+#define STATIC_VECTOR_H
+
+#include <algorithm>         // std::rotate
+#include <cstddef>           // std::size_t
+#include <initializer_list>  // std::initializer_list
+#include <iterator>          // std::distance, std::iterator_traits
+#include <memory>            // std::destroy, std::uninitialized_copy
+#include <new>               // placement new, std::launder
+#include <stdexcept>         // std::length_error, std::out_of_range
+#include <type_traits>       // std::is_trivial, std::is_nothrow_move_constructible
+#include <utility>           // std::move, std::forward
+#include "iterator.h"        // iterator of the vector
+#include "vector.h"          // alt::detail::erase_if
+
+namespace alt {
+
+namespace detail {
+
+// \brief Storage of a static_vector: N slots, of which the first m_size hold elements.
+//
+// Trivial elements live in a plain array, so that the container is a literal type and works in
+// constant expressions; the array is zeroed on construction, as constexpr requires.
+template <typename T, std::size_t N, bool = std::is_trivial<T>::value>
+struct static_storage {
+        T m_data[N] = {};          //!< The slots.
+        unsigned long m_size = 0;  //!< Slots in use.
+
+        constexpr T* slots(void) { return m_data; }
+        constexpr const T* slots(void) const { return m_data; }
+};
+
+// Other elements are constructed in place in raw memory, and only the live ones are copied,
+// moved and destroyed.
+template <typename T, std::size_t N>
+struct static_storage<T, N, false> {
+        alignas(T) unsigned char m_buffer[N * sizeof(T)];  //!< Raw memory for the slots.
+        unsigned long m_size = 0;                          //!< Slots in use.
+
+        T* slots(void) { return std::launder(reinterpret_cast<T*>(m_buffer)); }
+        const T* slots(void) const { return std::launder(reinterpret_cast<const T*>(m_buffer)); }
+
+        static_storage() = default;
+
+        static_storage(const static_storage& other) {
+                std::uninitialized_copy(other.slots(), other.slots() + other.m_size, slots());
+                m_size = other.m_size;
+        }
+
+        // Other keeps its size, with moved-from elements (as if T were trivial and copied).
+        static_storage(static_storage&& other) noexcept(
+            std::is_nothrow_move_constructible<T>::value) {
+                std::uninitialized_move(other.slots(), other.slots() + other.m_size, slots());
+                m_size = other.m_size;
+        }
+
+        static_storage& operator=(const static_storage& other) {
+                if (this != &other) assign(other.slots(), other.slots() + other.m_size);
+                return *this;
+        }
+
+        static_storage& operator=(static_storage&& other) noexcept(
+            std::is_nothrow_move_assignable<T>::value &&
+            std::is_nothrow_move_constructible<T>::value) {
+                if (this != &other) {
+                        assign(std::make_move_iterator(other.slots()),
+                               std::make_move_iterator(other.slots() + other.m_size));
+                }
+                return *this;
+        }
+
+        ~static_storage() { std::destroy(slots(), slots() + m_size); }
+
+        // \brief Replaces the elements with the count elements of [first, ...): the common ones
+        // are assigned, the rest constructed or destroyed.
+        template <typename It>
+        void assign(It first, It last) {
+                unsigned long count = std::distance(first, last);
+                unsigned long common = std::min(count, m_size);
+                It mid = std::copy(first, first + common, slots());
+                if (count > m_size) {
+                        std::uninitialized_copy(mid, last, slots() + m_size);
+                } else {
+                        std::destroy(slots() + count, slots() + m_size);
+                }
+                m_size = count;
+        }
+};
+
+}  // namespace detail
+
+//! \brief Sequence container with the API of alt::vector on a fixed buffer of N elements, which
+//! never allocates memory.
+//!
+//! Overflow policy: an operation that would take the size past N throws std::length_error and
+//! leaves the container untouched (reserve() beyond N too). Single pass (input iterator) ranges
+//! are counted as they are read: insert() appends and drops them again on overflow, and assign()
+//! reads them into a second buffer first. The try_push_back() and try_emplace_back() variants
+//! report a full container instead, with no exception.
+//!
+//! For trivial element types (as int, or structs of them) the container is a literal type, and
+//! the whole API but erase_if() works in constant expressions; other types use it at run time.
+template <typename T, std::size_t N>
+class static_vector : private detail::static_storage<T, N> {
+        static_assert(N > 0, "static_vector needs room for at least one element");
+
+        // Iterator templates are not picked for (count, value) pairs of integers.
+        template <typename It>
+        using if_iterator = std::enable_if_t<!std::is_integral<It>::value>;
+
+       public:
+        // Container common interface.
+        typedef T value_type;                          //!< The value type.
+        typedef T& reference;                          //!< Reference to a value.
+        typedef const T& const_reference;              //!< Const reference to a value.
+        typedef T* pointer;                            //!< Pointer to a value.
+        typedef vec_iterator<T> iterator;              //!< Iterator.
+        typedef vec_iterator<const T> const_iterator;  //!< Const iterator.
+        typedef unsigned long size_type;               //!< The size type.
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Default constructor: constructs an empty container.
+        constexpr static_vector() = default;
+
+        //! \brief Constructs an empty container with room for count elements.
+        //! \param count Capacity requested; std::length_error if it is over N.
+        constexpr explicit static_vector(size_type count) { reserve(count); }
+
+        //! \brief Constructs the container with the contents of the range [first, last).
+        //! \param first Iterator for the first element for insertion.
+        //! \param last Iterator for the last element for insertion.
+        template <typename InputIt, typename = if_iterator<InputIt>>
+        constexpr static_vector(InputIt first, InputIt last) {
+                assign(first, last);
+        }
+
+        //! \brief Constructs the container with the contents of the initializer list.
+        //! \param ilist Initializer list for copy.
+        constexpr static_vector(std::initializer_list<value_type> ilist) { assign(ilist); }
+
+        //! \brief initializer list assignment: copies the elements of il into the container.
+        //! \param ilist initializer_list object to copy content.
+        constexpr static_vector& operator=(std::initializer_list<value_type> ilist) {
+                assign(ilist);
+                return *this;
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Compare functions
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Checks if the contents of lhs and rhs are equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are equal, false otherwise.
+        constexpr bool operator==(const static_vector& rhs) const {
+                if (size() != rhs.size()) return false;
+                for (size_type i = 0; i < size(); i++) {
+                        if (data()[i] != rhs[i]) return false;
+                }
+                return true;
+        }
+
+        //! \brief Checks if the contents of lhs and rhs are not equal.
+        //! \param rhs Container to compare with.
+        //! \return True if the contents of the containers are not equal, false otherwise.
+        constexpr bool operator!=(const static_vector& rhs) const { return !(*this == rhs); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Iterators
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Return iterator to the beginning.
+        //! \return Iterator to the first element.
+        constexpr iterator begin(void) { return iterator(data()); }
+
+        //! \brief Returns iterator to the past-end.
+        //! \return Iterator to the past-end.
+        constexpr iterator end(void) { return iterator(data() + size()); }
+
+        //! \brief Returns a const_iterator to the beginning.
+        //! \return Const_iterator to the first element.
+        constexpr const_iterator cbegin(void) const { return const_iterator(data()); }
+
+        //! \brief Returns a const_iterator to the past-end.
+        //! \return Iterator to the past-end.
+        constexpr const_iterator cend(void) const { return const_iterator(data() + size()); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Capacity
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns the number of elements in the container.
+        //! \return The number of elements in the container.
+        constexpr size_type size(void) const { return this->m_size; }
+
+        //! \brief Returns the number of elements the container can hold: always N.
+        //! \return N.
+        constexpr size_type capacity(void) const { return N; }
+
+        //! \brief Returns whether the container is empty
+        //! \return True if the container size is 0, false otherwise.
+        constexpr bool empty(void) const { return size() == 0; }
+
+        //! \brief Checks that the container can hold new_cap elements; nothing is allocated.
+        //! \param new_cap Capacity requested; std::length_error if it is over N.
+        constexpr void reserve(size_type new_cap) { check_room(new_cap); }
+
+        //! \brief Does nothing: the capacity is fixed.
+        constexpr void shrink_to_fit(void) {}
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Element access
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Returns a reference to the element at position pos, with no bounds check.
+        //! \return The element at the specified position.
+        constexpr reference operator[](size_type pos) { return data()[pos]; }
+
+        //! \brief Returns a const reference to the element at position pos, with no bounds check.
+        //! \return The element at the specified position.
+        constexpr const_reference operator[](size_type pos) const { return data()[pos]; }
+
+        //! \brief Returns a reference to the element at position pos.
+        //! \param pos Position of an element in the container; std::out_of_range if past size().
+        //! \return The element at the specified position in the container.
+        constexpr reference at(size_type pos) {
+                if (pos >= size()) throw std::out_of_range("out of range!");
+                return data()[pos];
+        }
+
+        //! \brief Returns a const reference to the element at position pos.
+        //! \param pos Position of an element in the container; std::out_of_range if past size().
+        //! \return The element at the specified position in the container.
+        constexpr const_reference at(size_type pos) const {
+                if (pos >= size()) throw std::out_of_range("out of range!");
+                return data()[pos];
+        }
+
+        //! \brief Returns a reference to the first element.
+        constexpr reference front(void) { return data()[0]; }
+
+        //! \brief Returns a const reference to the first element.
+        constexpr const_reference front(void) const { return data()[0]; }
+
+        //! \brief Returns a reference to the last element.
+        constexpr reference back(void) { return data()[size() - 1]; }
+
+        //! \brief Returns a const reference to the last element.
+        constexpr const_reference back(void) const { return data()[size() - 1]; }
+
+        //! \brief Returns a pointer to the underlying array of elements.
+        constexpr pointer data(void) { return this->slots(); }
+
+        //! \brief Returns a const pointer to the underlying array of elements.
+        constexpr const T* data(void) const { return this->slots(); }
+
+        ///////////////////////////////////////////////////////////////////////////////
+        // Modifiers
+        ///////////////////////////////////////////////////////////////////////////////
+
+        //! \brief Assign value count times in the container.
+        //! \param count Times of assignment; std::length_error if it is over N.
+        //! \param value Value to be assigned.
+        constexpr void assign(size_type count, const_reference value) {
+                check_room(count);
+                T copy = value;  // 'value' may be an element of the container.
+                clear();
+                for (size_type i = 0; i < count; i++) emplace_back(copy);
+        }
+
+        //! \brief Assign values from [first, last).
+        //! \param first First element of the range.
+        //! \param last Element after the last element of the range.
+        template <typename InputItr, typename = if_iterator<InputItr>>
+        constexpr void assign(InputItr first, InputItr last) {
+                using Category = typename std::iterator_traits<InputItr>::iterator_category;
+                if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value) {
+                        check_room(std::distance(first, last));
+                        clear();
+                        for (; first != last; ++first) emplace_back(*first);
+                } else if (empty()) {
+                        append(first, last);
+                } else {
+                        // The old elements stay until the whole range is known to fit.
+                        static_vector range;
+                        range.append(first, last);
+                        clear();
+                        for (auto& element : range) emplace_back(std::move(element));
+                }
+        }
+
+        //! \brief Assign initializer list content to the container.
+        //! \param ilist Initializer list for assignment.
+        constexpr void assign(std::initializer_list<value_type> ilist) {
+                assign(ilist.begin(), ilist.end());
+        }
+
+        //! \brief Insert value to the end of the container.
+        //! \param value Value to be copied.
+        constexpr void push_back(const_reference value) { emplace_back(value); }
+
+        //! \brief Moves value to the end of the container.
+        //! \param value Value to be moved.
+        constexpr void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+        //! \brief Constructs an element in place at the end of the container.
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Reference to the element constructed.
+        template <typename... Args>
+        constexpr reference emplace_back(Args&&... args) {
+                check_room(size() + 1);
+                construct(size(), std::forward<Args>(args)...);
+                return data()[this->m_size++];
+        }
+
+        //! \brief Inserts value at the end of the container, if there is room for it.
+        //! \param value Value to be copied.
+        //! \return Pointer to the element inserted, or nullptr if the container is full.
+        constexpr pointer try_push_back(const_reference value) { return try_emplace_back(value); }
+
+        //! \brief Moves value to the end of the container, if there is room for it.
+        //! \param value Value to be moved (untouched if the container is full).
+        //! \return Pointer to the element inserted, or nullptr if the container is full.
+        constexpr pointer try_push_back(value_type&& value) {
+                return try_emplace_back(std::move(value));
+        }
+
+        //! \brief Constructs an element in place at the end of the container, if there is room.
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Pointer to the element constructed, or nullptr if the container is full.
+        template <typename... Args>
+        constexpr pointer try_emplace_back(Args&&... args) {
+                if (size() == N) return nullptr;
+                return &emplace_back(std::forward<Args>(args)...);
+        }
+
+        //! \brief Removes the last element of the container.
+        constexpr void pop_back(void) {
+                --this->m_size;
+                destroy(size(), size() + 1);
+        }
+
+        //! \brief Inserts value at position pos.
+        //! \param pos Position for insertion.
+        //! \param value Value for insertion.
+        //! \return Iterator pointing to the inserted value.
+        constexpr iterator insert(const_iterator pos, const_reference value) {
+                return emplace(pos, value);
+        }
+
+        //! \brief Inserts value at position pos, moving it.
+        //! \param pos Position for insertion.
+        //! \param value Value for insertion.
+        //! \return Iterator pointing to the inserted value.
+        constexpr iterator insert(const_iterator pos, value_type&& value) {
+                return emplace(pos, std::move(value));
+        }
+
+        //! \brief Constructs an element in place before position pos.
+        //! \param pos Position for insertion, in [begin(), end()].
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Iterator pointing to the element constructed.
+        template <typename... Args>
+        constexpr iterator emplace(const_iterator pos, Args&&... args) {
+                size_type index = pos - cbegin();
+                if (index == size()) {
+                        emplace_back(std::forward<Args>(args)...);
+                } else {
+                        check_room(size() + 1);
+                        T value = T(std::forward<Args>(args)...);  // 'args' may be elements.
+                        fill_gap(index, 1, [&]() -> T&& { return std::move(value); });
+                }
+                return begin() + index;
+        }
+
+        //! \brief Inserts values from range at position pos, shifting the elements after pos
+        //! once. The range must not come from the container.
+        //! \param pos Position for insertion.
+        //! \param first First element of the range.
+        //! \param last Position after the last element of the range.
+        //! \return Iterator pointing to the first element inserted (pos if the range is empty).
+        template <typename InputItr, typename = if_iterator<InputItr>>
+        constexpr iterator insert(const_iterator pos, InputItr first, InputItr last) {
+                size_type index = pos - cbegin();
+                using Category = typename std::iterator_traits<InputItr>::iterator_category;
+                if constexpr (!std::is_base_of<std::forward_iterator_tag, Category>::value) {
+                        // Single pass: append the range, then rotate it into place.
+                        size_type old_size = size();
+                        append(first, last);
+                        std::rotate(data() + index, data() + old_size, data() + size());
+                } else {
+                        size_type count = std::distance(first, last);
+                        check_room(size() + count);
+                        fill_gap(index, count, [&]() -> decltype(auto) { return *first++; });
+                }
+                return begin() + index;
+        }
+
+        //! \brief Inserts values from an initializer list at position pos.
+        //! \param pos Position for insertion.
+        //! \param ilist List of elements.
+        //! \return Iterator pointing to the first element inserted.
+        constexpr iterator insert(const_iterator pos, std::initializer_list<value_type> ilist) {
+                return insert(pos, ilist.begin(), ilist.end());
+        }
+
+        //! \brief Removes the object at position pos.
+        //! \param pos Position to erase.
+        //! \return Iterator to the element that follows pos.
+        constexpr iterator erase(const_iterator pos) {
+                if (pos == cend()) return begin() + (pos - cbegin());
+                return erase(pos, pos + 1);
+        }
+
+        //! \brief Removes the range [first, last).
+        //! \param first Iterator for the first element of the range.
+        //! \param last Iterator for the past-end element of the range.
+        //! \return An iterator pointing to the new location of the
+        //! element that followed the last element erased by the function call.
+        constexpr iterator erase(const_iterator first, const_iterator last) {
+                size_type index = first - cbegin();
+                size_type count = last - first;
+                if (count > 0) {
+                        destroy(index, index + count);
+                        close_gap(index, count);
+                }
+                return begin() + index;
+        }
+
+        //! \brief Removes all elements from the container (which are destroyed).
+        constexpr void clear(void) {
+                destroy(0, size());
+                this->m_size = 0;
+        }
+
+       private:
+        static const bool TRIVIAL = std::is_trivial<T>::value;
+
+        // \brief Throws std::length_error if count elements do not fit.
+        constexpr void check_room(size_type count) const {
+                if (count > N) throw std::length_error("static_vector capacity exceeded!");
+        }
+
+        // \brief Appends a single pass range; on overflow, drops what it appended and throws.
+        template <typename InputItr>
+        constexpr void append(InputItr first, InputItr last) {
+                size_type old_size = size();
+                for (; first != last; ++first) {
+                        if (size() == N) {
+                                destroy(old_size, size());
+                                this->m_size = old_size;
+                                check_room(N + 1);
+                        }
+                        emplace_back(*first);
+                }
+        }
+
+        // \brief Constructs an element at slot i (assigns it, for trivial elements).
+        template <typename... Args>
+        constexpr void construct(size_type i, Args&&... args) {
+                if constexpr (TRIVIAL) {
+                        data()[i] = T(std::forward<Args>(args)...);
+                } else {
+                        ::new (static_cast<void*>(data() + i)) T(std::forward<Args>(args)...);
+                }
+        }
+
+        // \brief Destroys the elements in the slots [first, last).
+        constexpr void destroy(size_type first, size_type last) {
+                if constexpr (!TRIVIAL) std::destroy(data() + first, data() + last);
+        }
+
+        // \brief Moves the elements from index on count slots forward, leaving the count slots
+        // at index raw. The size already counts them.
+        constexpr void open_gap(size_type index, size_type count) {
+                size_type old_size = size();
+                for (size_type i = old_size; i-- > index;) {
+                        if (i + count >= old_size) {
+                                construct(i + count, std::move(data()[i]));
+                        } else {
+                                data()[i + count] = std::move(data()[i]);
+                        }
+                }
+                destroy(index, std::min(index + count, old_size));  // Moved-from elements.
+                this->m_size += count;
+        }
+
+        // \brief Moves the elements after the count raw slots at index back over them.
+        constexpr void close_gap(size_type index, size_type count) {
+                for (size_type i = index + count; i < size(); i++) {
+                        if (i - count < index + count) {
+                                construct(i - count, std::move(data()[i]));
+                        } else {
+                                data()[i - count] = std::move(data()[i]);
+                        }
+                }
+                destroy(std::max(size() - count, index + count), size());
+                this->m_size -= count;
+        }
+
+        // \brief Opens a gap of count slots at index, and constructs next() in each of them (all
+        // of them, or none if it throws).
+        template <typename Next>
+        constexpr void fill_gap(size_type index, size_type count, Next next) {
+                open_gap(index, count);
+                if constexpr (TRIVIAL) {
+                        for (size_type i = index; i < index + count; i++) data()[i] = next();
+                } else {
+                        fill_raw_gap(index, count, next);
+                }
+        }
+
+        // \brief fill_gap() for other elements: no try block may appear in a constexpr function.
+        template <typename Next>
+        void fill_raw_gap(size_type index, size_type count, Next& next) {
+                size_type i = index;
+                try {
+                        for (; i < index + count; i++) construct(i, next());
+                } catch (...) {
+                        destroy(index, i);
+                        close_gap(index, count);
+                        throw;
+                }
+        }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Non-member functions
+///////////////////////////////////////////////////////////////////////////////
+
+//! \brief Erases every element that satisfies a predicate, in one pass over the container.
+//! \param vec Container to filter.
+//! \param pred Predicate called once per element, in order.
+//! \return Number of elements erased.
+template <typename T, std::size_t N, typename Predicate>
+typename static_vector<T, N>::size_type erase_if(static_vector<T, N>& vec, Predicate pred) {
+        return detail::erase_if(vec, pred);
+}
+
+//! \brief Erases every element equal to a value, in one pass over the container.
+//! \param vec Container to filter.
+//! \param value Value to erase.
+//! \return Number of elements erased.
+template <typename T, std::size_t N, typename U>
+typename static_vector<T, N>::size_type erase(static_vector<T, N>& vec, const U& value) {
+        return detail::erase_if(vec, [&value](const T& element) { return element == value; });
+}
+
+}  // namespace alt
+
+#endif
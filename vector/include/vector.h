@@ -8,12 +8,24 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#ifdef __linux__
+#include <sys/mman.h>  // mmap, mremap, munmap
+#include <unistd.h>    // sysconf
+#endif
+
 #include <algorithm>         // std::copy, ...
 #include <cassert>           // assert
+#include <cstddef>           // std::max_align_t
+#include <cstdlib>           // std::malloc, std::realloc, std::free
+#include <cstring>           // std::memcpy, std::memmove
 #include <initializer_list>  // std::initializer_list
 #include <iostream>          // std::cout, std::endl, ...
 #include <iterator>          // std::ostream_iterator
+#include <memory>            // std::allocator, std::uninitialized_copy, std::destroy, ...
+#include <new>               // placement new, std::bad_alloc
 #include <string>            // memmove()
+#include <type_traits>       // std::is_nothrow_move_constructible, ...
+#include <utility>           // std::move, std::forward
 #include "iterator.h"        // iterator of the vector
 
 namespace alt {
@@ -37,8 +49,8 @@ class vector {
         //! \brief Default constructor: constructs an empty container, with no elements.
         vector();
 
-        //! \brief Constructs an container with count default-inserted instances.
-        //! \param count Number of instances.
+        //! \brief Constructs an empty container with room for count elements.
+        //! \param count Capacity of the container; no element is constructed.
         explicit vector(size_type count);
 
         //! \brief Constructs the container with the contents of the range [first, last).
@@ -51,6 +63,10 @@ class vector {
         //! \param other Container for copy.
         vector(const vector& other);
 
+        //! \brief Constructs the container with the contents of other, which is left empty.
+        //! \param other Container to move from.
+        vector(vector&& other) noexcept;
+
         //! \brief Constructs the container with the contents of the initializer list.
         //! \param ilist Initializer list for copy.
         vector(std::initializer_list<value_type> ilist);
@@ -64,7 +80,7 @@ class vector {
 
         //! \brief Move assignment: moves the elements of other into the container.
         //! \param other Vector object of the same type.
-        vector& operator=(vector&& other);
+        vector& operator=(vector&& other) noexcept;
 
         //! \brief initializer list assignment: copies the elements of il into the container.
         //! \param ilist initializer_list object to copy content.
@@ -171,6 +187,14 @@ class vector {
         //! \return A const reference to the last element in the vector container.
         const_reference back(void) const;
 
+        //! \brief Returns a pointer to the underlying array of elements.
+        //! \return Pointer to the first element (nullptr if the container never had memory).
+        pointer data(void);
+
+        //! \brief Returns a const pointer to the underlying array of elements.
+        //! \return Pointer to the first element (nullptr if the container never had memory).
+        const T* data(void) const;
+
         ///////////////////////////////////////////////////////////////////////////////
         // Modifiers
         ///////////////////////////////////////////////////////////////////////////////
@@ -194,6 +218,16 @@ class vector {
         //! \param value Value to be copied.
         void push_back(const_reference value);
 
+        //! \brief Moves value to the end of the container.
+        //! \param value Value to be moved.
+        void push_back(value_type&& value);
+
+        //! \brief Constructs an element in place at the end of the container.
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Reference to the element constructed.
+        template <typename... Args>
+        reference emplace_back(Args&&... args);
+
         //! \brief Removes the last element of the container.
         void pop_back(void);
 
@@ -209,19 +243,47 @@ class vector {
         //! \return Iterator pointing to the inserted value.
         iterator insert(const_iterator pos, const_reference value);
 
-        //! \brief Inserts values from range at position pos.
+        //! \brief Inserts value at position pos, moving it.
+        //! \param pos Position for insertion.
+        //! \param value Value for insertion.
+        //! \return Iterator pointing to the inserted value.
+        iterator insert(iterator pos, value_type&& value);
+
+        //! \brief Inserts value at position pos, moving it.
+        //! \param pos Position for insertion.
+        //! \param value Value for insertion.
+        //! \return Iterator pointing to the inserted value.
+        iterator insert(const_iterator pos, value_type&& value);
+
+        //! \brief Constructs an element in place before position pos.
+        //! \param pos Position for insertion, in [begin(), end()].
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Iterator pointing to the element constructed.
+        template <typename... Args>
+        iterator emplace(iterator pos, Args&&... args);
+
+        //! \brief Constructs an element in place before position pos.
+        //! \param pos Position for insertion, in [begin(), end()].
+        //! \param args Arguments forwarded to the constructor of the element.
+        //! \return Iterator pointing to the element constructed.
+        template <typename... Args>
+        iterator emplace(const_iterator pos, Args&&... args);
+
+        //! \brief Inserts values from range at position pos, growing at most once and shifting
+        //! the elements after pos once. The range must not come from the container.
         //! \param pos Position for insertion;
         //! \param first First element of the range.
         //! \param last Position after the last element of the range.
-        //! \return Iterator pointing to the first element inserted,
+        //! \return Iterator pointing to the first element inserted (pos if the range is empty).
         template <typename InputItr>
         iterator insert(iterator pos, InputItr first, InputItr last);
 
-        //! \brief Inserts values from range at position pos.
+        //! \brief Inserts values from range at position pos, growing at most once and shifting
+        //! the elements after pos once. The range must not come from the container.
         //! \param pos Position for insertion;
         //! \param first First element of the range.
         //! \param last Position after the last element of the range.
-        //! \return Iterator pointing to the first element inserted,
+        //! \return Iterator pointing to the first element inserted (pos if the range is empty).
         template <typename InputItr>
         iterator insert(const_iterator pos, InputItr first, InputItr last);
 
@@ -265,25 +327,308 @@ class vector {
         //! container with a size of 0.
         void clear(void);
 
-       private:
+       protected:
+        // The internals are shared with small_vector, which starts on a buffer of its own.
+
+        //! \brief Constructs an empty container on an inline buffer. The derived class owns the
+        //! buffer: it overrides owns_storage(), and detaches the buffer before this destructor.
+        //! \param buffer Raw memory for capacity elements.
+        //! \param capacity Capacity of the buffer.
+        vector(pointer buffer, size_type capacity);
+
+        // Trivially copyable elements are moved as bytes. Their memory comes from malloc, so
+        // that realloc can grow it in place; on Linux, blocks of MAP_THRESHOLD bytes or more come
+        // from mmap, and mremap grows them by moving pages, without copying the elements.
+        static const bool TRIVIAL =
+            std::is_trivially_copyable<T>::value && alignof(T) <= alignof(std::max_align_t);
+        static const size_type MAP_THRESHOLD = 1 << 20;  //!< Smallest block from mmap, in bytes.
+
+        // Only the elements in [0, m_size) are alive: the slots after them are raw memory, and
+        // elements are constructed there in place, when inserted.
         pointer m_storage;     //!< Data storage area for the dynamic array.
         size_type m_size;      //!< Current list size (or index past-last valid element).
         size_type m_capacity;  //!< List’s storage capacity.
+
+        // \brief Checks whether m_storage came from allocate(); false for the inline buffer of a
+        // small_vector. Only the reallocations ask, so the call stays off the fast paths.
+        virtual bool owns_storage(void) const { return true; }
+
+        // \brief Allocates raw memory for count elements (nullptr for none).
+        static pointer allocate(size_type count);
+
+        // \brief Releases memory from allocate().
+        static void deallocate(pointer storage, size_type count);
+
+        // \brief Releases the memory of the elements, unless it is the inline buffer.
+        void deallocate_storage(void);
+
+        // \brief Checks whether a block for count elements comes from mmap.
+        static bool mapped(size_type count);
+
+        // \brief Bytes of a block for count elements (whole pages if it comes from mmap).
+        static size_type block_bytes(size_type count);
+
+        // \brief Moves the elements to raw memory for new_cap elements (new_cap >= m_size).
+        void reallocate(size_type new_cap);
+
+        // \brief reallocate() for trivially copyable elements: realloc, mremap or memcpy.
+        void reallocate_bytes(size_type new_cap);
+
+        // \brief Moves the elements to a larger block, constructing a new one at index on the way.
+        template <typename... Args>
+        void reallocate_insert(size_type index, Args&&... args);
+
+        // \brief Moves the elements to a block for new_cap elements, leaving a gap of count
+        // elements at index, which fill(gap) constructs (all of them, or none if it throws).
+        template <typename Fill>
+        void reallocate_gap(size_type index, size_type count, size_type new_cap, Fill fill);
+
+        // \brief Inserts the count elements of [first, last) at index, with no growth needed.
+        template <typename ForwardItr>
+        void insert_gap(size_type index, size_type count, ForwardItr first, ForwardItr last);
+
+        // \brief Checks whether pos is in [begin(), end()], where an element can be inserted.
+        bool in_range(iterator pos);
+
+        // \brief Capacity after the next growth.
+        size_type grown_capacity(void) const;
+
+        // \brief Constructs [first, last) at dest, in raw memory, and destroys nothing. Elements
+        // are moved, unless moving may throw and copying is possible: if a copy throws, the
+        // source is still intact (as std::move_if_noexcept).
+        static void relocate(pointer first, pointer last, pointer dest);
+
+        // \brief Destroys the elements and releases the memory; the container is left empty.
+        void release(void);
 };
 
 template <typename T>
-vector<T>::vector() : m_storage{new T[0]}, m_size{0}, m_capacity{0} {};
+bool vector<T>::mapped(typename vector<T>::size_type count) {
+#ifdef __linux__
+        return TRIVIAL && count >= size_type(MAP_THRESHOLD) / sizeof(T);
+#else
+        (void)count;
+        return false;
+#endif
+}
+
+template <typename T>
+typename vector<T>::size_type vector<T>::block_bytes(typename vector<T>::size_type count) {
+        size_type bytes = count * sizeof(T);
+#ifdef __linux__
+        if (mapped(count)) {
+                size_type page = ::sysconf(_SC_PAGESIZE);
+                bytes = (bytes + page - 1) / page * page;
+        }
+#endif
+        return bytes;
+}
+
+template <typename T>
+typename vector<T>::pointer vector<T>::allocate(typename vector<T>::size_type count) {
+        if (count == 0) return nullptr;
+        if constexpr (!TRIVIAL) return std::allocator<T>().allocate(count);
+
+        if (count > size_type(-1) / 2 / sizeof(T)) throw std::bad_alloc();  // Too many bytes.
+#ifdef __linux__
+        if (mapped(count)) {
+                void* block = ::mmap(nullptr, block_bytes(count), PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (block == MAP_FAILED) throw std::bad_alloc();
+                return static_cast<pointer>(block);
+        }
+#endif
+        void* block = std::malloc(block_bytes(count));
+        if (block == nullptr) throw std::bad_alloc();
+        return static_cast<pointer>(block);
+}
+
+template <typename T>
+void vector<T>::deallocate(typename vector<T>::pointer storage,
+                           typename vector<T>::size_type count) {
+        if (storage == nullptr) return;
+        if constexpr (!TRIVIAL) {
+                std::allocator<T>().deallocate(storage, count);
+                return;
+        }
+
+#ifdef __linux__
+        if (mapped(count)) {
+                ::munmap(storage, block_bytes(count));
+                return;
+        }
+#endif
+        std::free(storage);
+}
+
+template <typename T>
+void vector<T>::relocate(typename vector<T>::pointer first, typename vector<T>::pointer last,
+                         typename vector<T>::pointer dest) {
+        if constexpr (std::is_nothrow_move_constructible<T>::value ||
+                      !std::is_copy_constructible<T>::value) {
+                std::uninitialized_move(first, last, dest);
+        } else {
+                std::uninitialized_copy(first, last, dest);
+        }
+}
+
+template <typename T>
+bool vector<T>::in_range(typename vector<T>::iterator pos) {
+        auto index = pos - begin();
+        return index >= 0 && size_type(index) <= m_size;
+}
+
+template <typename T>
+typename vector<T>::size_type vector<T>::grown_capacity(void) const {
+        return m_capacity == 0 ? 1 : m_capacity * 2;
+}
+
+template <typename T>
+void vector<T>::deallocate_storage(void) {
+        if (owns_storage()) deallocate(m_storage, m_capacity);
+}
+
+template <typename T>
+void vector<T>::reallocate_bytes(typename vector<T>::size_type new_cap) {
+        pointer new_storage = nullptr;
+        if (new_cap == 0 || m_capacity == 0 || !owns_storage() ||
+            mapped(new_cap) != mapped(m_capacity)) {
+                // No block to grow, or the new one comes from elsewhere: copy the bytes over.
+                new_storage = allocate(new_cap);
+                if (m_size > 0) std::memcpy(new_storage, m_storage, m_size * sizeof(T));
+                deallocate_storage();
+        } else if (mapped(new_cap)) {
+#ifdef __linux__
+                // The kernel moves (or extends) the pages: nothing is copied.
+                void* block = ::mremap(m_storage, block_bytes(m_capacity), block_bytes(new_cap),
+                                       MREMAP_MAYMOVE);
+                if (block == MAP_FAILED) throw std::bad_alloc();
+                new_storage = static_cast<pointer>(block);
+#endif
+        } else {
+                // In place if the heap has room after the block, else malloc + memcpy.
+                void* block = std::realloc(m_storage, block_bytes(new_cap));
+                if (block == nullptr) throw std::bad_alloc();
+                new_storage = static_cast<pointer>(block);
+        }
+
+        m_capacity = new_cap;     // Update the capacity of the new array.
+        m_storage = new_storage;  // Points to the new memory.
+}
+
+template <typename T>
+void vector<T>::reallocate(typename vector<T>::size_type new_cap) {
+        if constexpr (TRIVIAL) {
+                reallocate_bytes(new_cap);
+                return;
+        }
+
+        pointer new_storage = allocate(new_cap);  // Raw memory: nothing is constructed yet.
+        try {
+                relocate(m_storage, m_storage + m_size, new_storage);
+        } catch (...) {
+                deallocate(new_storage, new_cap);  // The old elements are left untouched.
+                throw;
+        }
+
+        std::destroy(m_storage, m_storage + m_size);  // Destroy the old elements.
+        deallocate_storage();                         // Deallocate the old array.
+
+        m_capacity = new_cap;     // Update the capacity of the new array.
+        m_storage = new_storage;  // Points to the new memory.
+}
+
+template <typename T>
+template <typename... Args>
+void vector<T>::reallocate_insert(typename vector<T>::size_type index, Args&&... args) {
+        if constexpr (TRIVIAL) {
+                T value(std::forward<Args>(args)...);  // Before the block moves: args may be in it.
+                reallocate_bytes(grown_capacity());
+
+                pointer slot = m_storage + index;
+                std::memmove(slot + 1, slot, (m_size - index) * sizeof(T));
+                ::new (static_cast<void*>(slot)) T(value);
+                m_size++;
+                return;
+        }
+
+        reallocate_gap(index, 1, grown_capacity(), [&](pointer slot) {
+                ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+        });
+}
+
+template <typename T>
+template <typename Fill>
+void vector<T>::reallocate_gap(typename vector<T>::size_type index,
+                               typename vector<T>::size_type count,
+                               typename vector<T>::size_type new_cap, Fill fill) {
+        pointer new_storage = allocate(new_cap);
+
+        // The new elements first, while they may still come from the old ones.
+        pointer gap = new_storage + index;
+        try {
+                fill(gap);
+        } catch (...) {
+                deallocate(new_storage, new_cap);
+                throw;
+        }
+
+        // Then the elements before and after them.
+        try {
+                relocate(m_storage, m_storage + index, new_storage);
+                try {
+                        relocate(m_storage + index, m_storage + m_size, gap + count);
+                } catch (...) {
+                        std::destroy(new_storage, gap);
+                        throw;
+                }
+        } catch (...) {
+                std::destroy(gap, gap + count);
+                deallocate(new_storage, new_cap);
+                throw;
+        }
+
+        std::destroy(m_storage, m_storage + m_size);  // Destroy the old elements.
+        deallocate_storage();                         // Deallocate the old array.
+
+        m_storage = new_storage;
+        m_capacity = new_cap;
+        m_size += count;
+}
+
+template <typename T>
+void vector<T>::release(void) {
+        std::destroy(m_storage, m_storage + m_size);  // Destroy the elements.
+        deallocate_storage();                         // Deallocate the memory block.
+
+        m_storage = nullptr;
+        m_size = m_capacity = 0;
+}
+
+template <typename T>
+vector<T>::vector() : m_storage{nullptr}, m_size{0}, m_capacity{0} {};
 
 template <typename T>
 vector<T>::vector(typename vector<T>::size_type count)
-    : m_storage{new T[count]}, m_size{0}, m_capacity{count} {};
+    : m_storage{allocate(count)}, m_size{0}, m_capacity{count} {};
+
+template <typename T>
+vector<T>::vector(typename vector<T>::pointer buffer, typename vector<T>::size_type capacity)
+    : m_storage{buffer}, m_size{0}, m_capacity{capacity} {};
 
 template <typename T>
 template <typename InputIt>
 vector<T>::vector(InputIt first, InputIt last) {
-        m_capacity = m_size = std::distance(first, last);  // Update size/capacity of the container.
-        m_storage = new T[m_capacity];                     // Allocate the memory needed.
-        std::copy(first, last, m_storage);                 // Copy elements to the container.
+        m_capacity = std::distance(first, last);  // Update capacity of the container.
+        m_storage = allocate(m_capacity);         // Allocate the memory needed.
+        try {
+                // Copy elements to the container.
+                std::uninitialized_copy(first, last, m_storage);
+        } catch (...) {
+                deallocate(m_storage, m_capacity);
+                throw;
+        }
+        m_size = m_capacity;
 }
 
 template <typename T>
@@ -292,52 +637,65 @@ vector<T>::vector(const vector& other) {
         m_size = other.m_size;
         m_capacity = other.m_capacity;
 
-        m_storage = new T[m_capacity];  // Allocate the memory needed.
+        m_storage = allocate(m_capacity);  // Allocate the memory needed.
+        if constexpr (TRIVIAL) {
+                if (m_size > 0) std::memcpy(m_storage, other.m_storage, m_size * sizeof(T));
+                return;
+        }
 
-        // Copy elements to the container.
-        std::copy(&other.m_storage[0], &other.m_storage[m_size], m_storage);
+        try {
+                // Copy elements to the container.
+                std::uninitialized_copy(other.m_storage, other.m_storage + m_size, m_storage);
+        } catch (...) {
+                deallocate(m_storage, m_capacity);
+                throw;
+        }
 }
 
 template <typename T>
-vector<T>::vector(std::initializer_list<T> ilist) {
-        m_capacity = m_size = ilist.size();  // Update size/capacity of the container.
-        m_storage = new T[m_capacity];       // Allocate the memory needed.
-
-        // Copy elements from ilist to the container.
-        int i = 0;
-        for (auto& value : ilist) {
-                m_storage[i++] = value;
-        }
+vector<T>::vector(vector&& other) noexcept
+    : m_storage{other.m_storage}, m_size{other.m_size}, m_capacity{other.m_capacity} {
+        // Update 'other' container.
+        other.m_storage = nullptr;
+        other.m_size = other.m_capacity = 0;
 }
 
+template <typename T>
+vector<T>::vector(std::initializer_list<T> ilist) : vector(ilist.begin(), ilist.end()) {}
+
 template <typename T>
 vector<T>::~vector(void) {
-        delete[] m_storage;  // Deallocate the memory block.
+        release();  // Destroy the elements and deallocate the memory block.
 }
 
 template <typename T>
 vector<T>& vector<T>::operator=(const vector& other) {
-        // Update size/capacity of the container.
-        m_size = other.m_size;
-        m_capacity = other.m_capacity;
+        if (this == &other) return *this;
+
+        vector copy(other);  // Copy first: if it throws, the container is untouched.
+        release();           // Destroy the old elements and memory.
 
-        delete[] m_storage;             // Delete old memory.
-        m_storage = new T[m_capacity];  // Allocate the memory needed.
+        m_storage = copy.m_storage;
+        m_size = copy.m_size;
+        m_capacity = copy.m_capacity;
 
-        // Copy elements to the container.
-        std::copy(&other.m_storage[0], &other.m_storage[m_size], m_storage);
+        // The copy gives its memory away.
+        copy.m_storage = nullptr;
+        copy.m_size = copy.m_capacity = 0;
 
         return *this;
 }
 
 template <typename T>
-vector<T>& vector<T>::operator=(vector&& other) {
+vector<T>& vector<T>::operator=(vector&& other) noexcept {
+        if (this == &other) return *this;
+
+        release();  // Destroy the old elements and memory.
+
         // Update size/capacity of the container.
         m_size = other.m_size;
         m_capacity = other.m_capacity;
-
-        delete[] m_storage;                      // Delete old memory.
-        m_storage = std::move(other.m_storage);  // Move elements to the container.
+        m_storage = other.m_storage;  // Take the elements of 'other'.
 
         // Update 'other' container.
         other.m_size = 0;
@@ -349,18 +707,7 @@ vector<T>& vector<T>::operator=(vector&& other) {
 
 template <typename T>
 vector<T>& vector<T>::operator=(std::initializer_list<T> ilist) {
-        m_capacity = m_size = ilist.size();  // Update size/capacity of the container.
-
-        delete[] m_storage;             // Delete old memory.
-        m_storage = new T[m_capacity];  // Allocate the memory needed.
-
-        // Copy elements from ilist to the container.
-        int i = 0;
-        for (auto& value : ilist) {
-                m_storage[i++] = value;
-        }
-
-        return *this;
+        return *this = vector(ilist);
 }
 
 template <typename T>
@@ -395,22 +742,22 @@ bool vector<T>::operator!=(const vector& rhs) const {
 
 template <typename T>
 typename vector<T>::iterator vector<T>::begin(void) {
-        return typename vector<T>::iterator(&m_storage[0]);
+        return typename vector<T>::iterator(m_storage);
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::end(void) {
-        return typename vector<T>::iterator(&m_storage[m_size]);
+        return typename vector<T>::iterator(m_storage + m_size);
 }
 
 template <typename T>
 typename vector<T>::const_iterator vector<T>::cbegin(void) const {
-        return typename vector<T>::const_iterator(&m_storage[0]);
+        return typename vector<T>::const_iterator(m_storage);
 }
 
 template <typename T>
 typename vector<T>::const_iterator vector<T>::cend(void) const {
-        return typename vector<T>::const_iterator(&m_storage[m_size]);
+        return typename vector<T>::const_iterator(m_storage + m_size);
 }
 
 template <typename T>
@@ -430,28 +777,14 @@ bool vector<T>::empty(void) const {
 
 template <typename T>
 void vector<T>::reserve(typename vector<T>::size_type new_cap) {
-        // If we need more space.
-        if (new_cap > m_capacity) {
-                T* new_storage = new T[new_cap];         // Initialize array with the needed memory.
-                std::copy(begin(), end(), new_storage);  // Copy elements from old -> new.
-                delete[] m_storage;                      // Deallocate the old array.
-
-                m_capacity = new_cap;     // Update the capacity of the new array.
-                m_storage = new_storage;  // Points to the new memory.
-        }
+        // If we need more space; only the live elements are copied.
+        if (new_cap > m_capacity) reallocate(new_cap);
 }
 
 template <typename T>
 void vector<T>::shrink_to_fit(void) {
         // If we don't need more space.
-        if (m_capacity > m_size) {
-                T* new_storage = new T[m_size];          // Initialize array with the needed memory.
-                std::copy(begin(), end(), new_storage);  // Copy elements from old -> new.
-                delete[] m_storage;                      // Deallocate the old array.
-
-                m_capacity = m_size;      // Update the capacity of the new array.
-                m_storage = new_storage;  // Points to the new memory.
-        }
+        if (m_capacity > m_size) reallocate(m_size);
 }
 
 template <typename T>
@@ -503,16 +836,25 @@ typename vector<T>::const_reference vector<T>::back(void) const {
         return m_storage[m_size - 1];
 }
 
+template <typename T>
+typename vector<T>::pointer vector<T>::data(void) {
+        return m_storage;
+}
+
+template <typename T>
+const T* vector<T>::data(void) const {
+        return m_storage;
+}
+
 template <typename T>
 void vector<T>::assign(typename vector<T>::size_type count,
                        typename vector<T>::const_reference value) {
+        T copy(value);   // 'value' may be an element of the container.
+        clear();         // Destroy the old elements.
         reserve(count);  // Allocate more memory if needed.
 
-        // Assign 'count' instances of 'value'.
-        for (size_t i = 0; i < count; i++) {
-                m_storage[i] = value;
-        }
-
+        // Construct 'count' instances of 'value'.
+        std::uninitialized_fill_n(m_storage, count, copy);
         m_size = count;  // Update container size.
 }
 
@@ -520,37 +862,41 @@ template <typename T>
 template <typename InputItr>
 void vector<T>::assign(InputItr first, InputItr last) {
         size_t num_elements = std::distance(first, last);  // Number of elements in the range.
+        clear();                                           // Destroy the old elements.
         reserve(num_elements);                             // Allocate more memory if needed.
 
-        // Assign values from the range.
-        for (size_t i = 0; i < num_elements; i++) {
-                m_storage[i] = *first++;
-        }
-
+        // Construct values from the range.
+        std::uninitialized_copy(first, last, m_storage);
         m_size = num_elements;  // Update container size.
 }
 
 template <typename T>
 void vector<T>::assign(const std::initializer_list<T> ilist) {
-        size_t num_elements = ilist.size();  // Number of elements in the list.
-        reserve(num_elements);               // Allocate more memory if needed.
+        assign(ilist.begin(), ilist.end());
+}
 
-        // Assign values from the list.
-        size_t i = 0;
-        for (auto& value : ilist) {
-                m_storage[i++] = value;
-        }
+template <typename T>
+void vector<T>::push_back(typename vector<T>::const_reference value) {
+        emplace_back(value);
+}
 
-        m_size = num_elements;  // Update container size.
+template <typename T>
+void vector<T>::push_back(T&& value) {
+        emplace_back(std::move(value));
 }
 
 template <typename T>
-void vector<T>::push_back(typename vector<T>::const_reference value) {
+template <typename... Args>
+typename vector<T>::reference vector<T>::emplace_back(Args&&... args) {
         // Verify if the array is full
         if (m_size == m_capacity) {
-                reserve(m_capacity * 2);
+                reallocate_insert(m_size, std::forward<Args>(args)...);
+        } else {
+                ::new (static_cast<void*>(m_storage + m_size)) T(std::forward<Args>(args)...);
+                m_size++;
         }
-        m_storage[m_size++] = value;
+
+        return m_storage[m_size - 1];
 }
 
 template <typename T>
@@ -562,164 +908,274 @@ void vector<T>::pop_back(void) {
 template <typename T>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::iterator pos,
                                                typename vector<T>::const_reference value) {
-        bool is_valid = false;
-
-        // Check if pos is valid.
-        for (auto i = begin(); i != end() + 1; i++) {
-                if (i == pos) {
-                        is_valid = true;
-                        break;
-                }
-        }
-
-        if (!is_valid) {
+        if (!in_range(pos)) {
                 return nullptr;  // If not valid.
         }
 
-        int size_first = std::distance(begin(), pos);  // Elements before pos.
-        int size_second = std::distance(pos, end());   // Elements after pos.
-
-        if (m_size >= m_capacity) {
-                m_size = m_size + 1;  // Update to one more element if necessary (value).
-        }
-
-        T* tmp = new T[m_size * 2];  // New array with the capacity updated.
+        return emplace(pos, value);
+}
 
-        std::copy_n(begin(), size_first, tmp);                  // Copy elements before pos.
-        tmp[size_first] = value;                                // Copy value to pos.
-        std::copy_n(pos, size_second, (tmp + size_first + 1));  // Copy elements after pos.
+template <typename T>
+typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator pos,
+                                               typename vector<T>::const_reference value) {
+        return insert(begin() + (pos - cbegin()), value);
+}
 
-        delete[] m_storage;   // Delete old array.
-        m_storage = tmp;      // Update array to "array with value".
-        m_capacity = m_size;  // Update capacity
+template <typename T>
+typename vector<T>::iterator vector<T>::insert(typename vector<T>::iterator pos, T&& value) {
+        if (!in_range(pos)) {
+                return nullptr;  // If not valid.
+        }
 
-        return typename vector<T>::iterator(&m_storage[size_first]);
+        return emplace(pos, std::move(value));
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator pos,
-                                               typename vector<T>::const_reference value) {
-        int size_first = std::distance(begin(), pos);  // Elements before pos.
-        int size_second = std::distance(pos, end());   // Elements after pos.
-        m_size = m_size + 1;                           // Update to one more element (value).
+                                               T&& value) {
+        return insert(begin() + (pos - cbegin()), std::move(value));
+}
 
-        T* tmp = new T[m_size * 2];  // New array with the capacity updated.
+template <typename T>
+template <typename... Args>
+typename vector<T>::iterator vector<T>::emplace(typename vector<T>::iterator pos,
+                                                Args&&... args) {
+        size_type index = std::distance(begin(), pos);  // Elements before pos.
 
-        std::copy_n(begin(), size_first, tmp);                  // Copy elements before pos.
-        tmp[size_first] = value;                                // Copy value to pos.
-        std::copy_n(pos, size_second, (tmp + size_first + 1));  // Copy elements after pos.
+        // Verify if the array is full
+        if (m_size == m_capacity) {
+                reallocate_insert(index, std::forward<Args>(args)...);
+                return typename vector<T>::iterator(m_storage + index);
+        }
+
+        pointer slot = m_storage + index;
+        if (index == m_size) {
+                // Construct the element at the end.
+                ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+        } else if constexpr (TRIVIAL) {
+                T value(std::forward<Args>(args)...);  // 'args' may refer to the elements.
+
+                // Shift the elements after pos in one go.
+                std::memmove(slot + 1, slot, (m_size - index) * sizeof(T));
+                ::new (static_cast<void*>(slot)) T(value);
+        } else {
+                T value(std::forward<Args>(args)...);  // 'args' may refer to the elements.
+
+                // The last element moves to the raw slot past the end, the others shift over it.
+                ::new (static_cast<void*>(m_storage + m_size)) T(std::move(m_storage[m_size - 1]));
+                std::move_backward(slot, m_storage + m_size - 1, m_storage + m_size);
+                *slot = std::move(value);
+        }
+        m_size++;
 
-        delete[] m_storage;   // Delete old array.
-        m_storage = tmp;      // Update array to "array with value".
-        m_capacity = m_size;  // Update capacity
+        return typename vector<T>::iterator(slot);
+}
 
-        return pos;
+template <typename T>
+template <typename... Args>
+typename vector<T>::iterator vector<T>::emplace(typename vector<T>::const_iterator pos,
+                                                Args&&... args) {
+        return emplace(begin() + (pos - cbegin()), std::forward<Args>(args)...);
 }
 
 template <typename T>
 template <typename InputItr>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::iterator pos, InputItr first,
                                                InputItr last) {
-        int size = std::distance(first, last);  // Number of elements.
+        if (!in_range(pos)) {
+                return nullptr;  // If not valid.
+        }
+
+        size_type index = pos - begin();  // Elements before pos.
+        using Category = typename std::iterator_traits<InputItr>::iterator_category;
+        if constexpr (!std::is_base_of<std::forward_iterator_tag, Category>::value) {
+                // Single pass: append the range, then rotate it into place.
+                size_type old_size = m_size;
+                for (; first != last; ++first) emplace_back(*first);
+                std::rotate(m_storage + index, m_storage + old_size, m_storage + m_size);
+                return typename vector<T>::iterator(m_storage + index);
+        } else {
+                size_type count = std::distance(first, last);  // Number of elements.
+                if (count == 0) return pos;
+
+                // Grow once, if needed.
+                size_type new_cap = std::max(m_capacity * 2, m_size + count);
+                if (m_size + count > m_capacity) {
+                        if constexpr (TRIVIAL) {
+                                reallocate_bytes(new_cap);
+                        } else {
+                                // The range is copied straight into the new block.
+                                reallocate_gap(index, count, new_cap, [&](pointer gap) {
+                                        std::uninitialized_copy(first, last, gap);
+                                });
+                                return typename vector<T>::iterator(m_storage + index);
+                        }
+                }
 
-        last--;  // Decrease to a position with element valid.
-        for (int i = 0; i < size; i++, last--) {
-                pos = insert(pos, *last);
+                insert_gap(index, count, first, last);
+                return typename vector<T>::iterator(m_storage + index);
         }
+}
 
-        return pos;
+template <typename T>
+template <typename ForwardItr>
+void vector<T>::insert_gap(typename vector<T>::size_type index,
+                           typename vector<T>::size_type count, ForwardItr first,
+                           ForwardItr last) {
+        pointer slot = m_storage + index;
+        pointer old_end = m_storage + m_size;
+        size_type after = m_size - index;  // Elements after pos.
+
+        if constexpr (TRIVIAL) {
+                // Shift the tail once, and copy the range into the gap.
+                std::memmove(slot + count, slot, after * sizeof(T));
+                try {
+                        std::uninitialized_copy(first, last, slot);
+                } catch (...) {
+                        std::memmove(slot, slot + count, after * sizeof(T));  // Close the gap.
+                        throw;
+                }
+                m_size += count;
+        } else if (after > count) {
+                // The last count elements move to raw memory, the others shift over live ones.
+                std::uninitialized_move(old_end - count, old_end, old_end);
+                m_size += count;
+                std::move_backward(slot, old_end - count, old_end);
+                std::copy(first, last, slot);
+        } else {
+                // The range overflows the old end: its tail is constructed in raw memory.
+                ForwardItr mid = first;
+                std::advance(mid, after);
+                std::uninitialized_copy(mid, last, old_end);
+                m_size += count - after;
+                std::uninitialized_move(slot, old_end, slot + count);
+                m_size += after;
+                std::copy(first, mid, slot);
+        }
 }
 
 template <typename T>
 template <typename InputItr>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator pos,
                                                InputItr first, InputItr last) {
-        int size = std::distance(first, last);  // Number of elements.
-
-        last--;  // Decrease to a position with element valid.
-        for (int i = 0; i < size; i++, last--) {
-                pos = insert(pos, *last);
-        }
-
-        return pos;
+        return insert(begin() + (pos - cbegin()), first, last);
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::iterator pos,
                                                const std::initializer_list<T> ilist) {
-        for (auto i = ilist.end() - 1; i != ilist.begin() - 1; i--) {
-                pos = insert(pos, *i);
-        }
-
-        return pos;
+        return insert(pos, ilist.begin(), ilist.end());
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::insert(typename vector<T>::const_iterator pos,
                                                const std::initializer_list<T> ilist) {
-        for (auto i = ilist.end() - 1; i != ilist.begin() - 1; i--) {
-                pos = insert(pos, *i);
-        }
-
-        return pos;
+        return insert(begin() + (pos - cbegin()), ilist.begin(), ilist.end());
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::erase(typename vector<T>::iterator pos) {
         // 'pos' must be valid and dereferenceable.
-        if (pos != end()) {
-                m_size--;  // Update container size.
+        if (pos == end()) return pos;
 
-                // Move elements after pos.
-                for (auto it = pos; it != end(); it++) {
-                        *it = *(it + 1);
-                }
-        }
-
-        return pos;
+        return erase(pos, pos + 1);
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::erase(typename vector<T>::const_iterator pos) {
-        // 'pos' must be valid and dereferenceable.
-        if (pos != end()) {
-                m_size--;  // Update container size.
-
-                // Move elements after pos.
-                for (auto it = pos; it != end(); it++) {
-                        *it = *(it + 1);
-                }
-        }
-
-        return pos;
+        return erase(begin() + (pos - cbegin()));
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::erase(typename vector<T>::iterator first,
                                               typename vector<T>::iterator last) {
-        // Delete elements of the range.
-        for (int i = 0; i < std::distance(first, last); i++) {
-                first = erase(first);
+        if (first == last) return first;
+
+        pointer from = m_storage + (first - begin());  // First element erased.
+        pointer to = m_storage + (last - begin());     // First element kept after them.
+        pointer old_end = m_storage + m_size;
+
+        // Shift the tail over the range once.
+        if constexpr (TRIVIAL) {
+                std::memmove(from, to, (old_end - to) * sizeof(T));
+        } else {
+                std::move(to, old_end, from);
         }
 
+        pointer new_end = from + (old_end - to);
+        std::destroy(new_end, old_end);  // Destroy the moved-from tail.
+        m_size = new_end - m_storage;    // Update container size.
+
         return first;
 }
 
 template <typename T>
 typename vector<T>::iterator vector<T>::erase(typename vector<T>::const_iterator first,
                                               typename vector<T>::const_iterator last) {
-        // Delete elements of the range.
-        for (int i = 0; i < std::distance(first, last); i++) {
-                first = erase(first);
-        }
-
-        return first;
+        return erase(begin() + (first - cbegin()), begin() + (last - cbegin()));
 }
 
 template <typename T>
 void vector<T>::clear(void) {
-        for (size_t i = 0; i < m_capacity; i++) m_storage[i].~T();  // Destroy elements
-        m_size = 0;                                                 // Update the size.
+        std::destroy(m_storage, m_storage + m_size);  // Destroy elements; the memory is kept.
+        m_size = 0;                                   // Update the size.
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Non-member functions
+///////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// \brief erase_if() for any container with contiguous elements: data(), size() and erase().
+//
+// The elements kept are compacted toward the front, in order. Trivially copyable elements are
+// compacted without branches: each one is written to the next free slot, and the slot is taken
+// only if the element is kept, so that the predicate costs no mispredictions.
+template <typename Container, typename Predicate>
+typename Container::size_type erase_if(Container& vec, Predicate pred) {
+        typedef typename Container::value_type T;
+        T* first = vec.data();
+        T* last = first + vec.size();
+
+        T* kept = first;  // Past the last element kept.
+        if constexpr (std::is_trivially_copyable<T>::value) {
+                for (T* it = first; it != last; ++it) {
+                        T value = *it;
+                        *kept = value;
+                        kept += !pred(value);
+                }
+        } else {
+                kept = std::remove_if(first, last, pred);
+        }
+
+        typename Container::size_type erased = last - kept;
+        vec.erase(typename Container::iterator(kept), vec.end());
+        return erased;
+}
+
+}  // namespace detail
+
+//! \brief Erases every element that satisfies a predicate, in one pass over the container.
+//!
+//! The elements kept are compacted toward the front, in order. Trivially copyable elements are
+//! compacted without branches: each one is written to the next free slot, and the slot is taken
+//! only if the element is kept, so that the predicate costs no mispredictions.
+//! \param vec Container to filter.
+//! \param pred Predicate called once per element, in order.
+//! \return Number of elements erased.
+template <typename T, typename Predicate>
+typename vector<T>::size_type erase_if(vector<T>& vec, Predicate pred) {
+        return detail::erase_if(vec, pred);
+}
+
+//! \brief Erases every element equal to a value, in one pass over the container.
+//! \param vec Container to filter.
+//! \param value Value to erase.
+//! \return Number of elements erased.
+template <typename T, typename U>
+typename vector<T>::size_type erase(vector<T>& vec, const U& value) {
+        return erase_if(vec, [&value](const T& element) { return element == value; });
 }
 
 }  // namespace alt
@@ -1,9 +1,23 @@
-#include <algorithm>            // std::min_element
-#include <functional>           // std::function
-#include <iterator>             // std::ostream_iterator
-#include <utility>              // std::move()
-#include "../include/vector.h"  // header file for tested functions
-#include "gtest/gtest.h"        // gtest lib
+#include <algorithm>                       // std::min_element
+#include <atomic>                          // std::atomic
+#include <cstdint>                         // uintptr_t
+#include <functional>                      // std::function
+#include <iterator>                        // std::ostream_iterator
+#include <memory>                          // std::unique_ptr
+#include <random>                          // std::mt19937
+#include <sstream>                         // std::istringstream
+#include <string>                          // std::string
+#include <thread>                          // std::thread
+#include <tuple>                           // std::forward_as_tuple
+#include <type_traits>                     // std::is_same
+#include <utility>                         // std::move()
+#include <vector>                          // std::vector
+#include "../include/concurrent_vector.h"  // header file for tested functions
+#include "../include/segmented_vector.h"   // header file for tested functions
+#include "../include/small_vector.h"       // header file for tested functions
+#include "../include/static_vector.h"      // header file for tested functions
+#include "../include/vector.h"             // header file for tested functions
+#include "gtest/gtest.h"                   // gtest lib
 
 // ============================================================================
 // TESTING VECTOR AS A CONTAINER OF INTEGERS
@@ -533,6 +547,955 @@ TEST(IntVector, EraseRange) {
         ASSERT_TRUE(vec.empty());
 }
 
+// ============================================================================
+// TESTING VECTOR STORAGE: ONLY THE ELEMENTS IN [0, size) ARE ALIVE
+// ============================================================================
+//! Element that counts the live instances of its type.
+struct Tracked {
+        static int alive;  //!< Instances constructed and not destroyed yet.
+        int value;         //!< Payload.
+
+        Tracked(int v = 0) : value{v} { alive++; }
+        Tracked(const Tracked& other) : value{other.value} { alive++; }
+        Tracked& operator=(const Tracked& other) = default;
+        ~Tracked() { alive--; }
+
+        bool operator!=(const Tracked& other) const { return value != other.value; }
+};
+
+int Tracked::alive = 0;
+
+TEST(VectorStorage, ReserveConstructsNothing) {
+        {
+                alt::vector<Tracked> vec(1000);
+                EXPECT_EQ(Tracked::alive, 0);
+
+                vec.reserve(100000);
+                EXPECT_EQ(vec.capacity(), 100000);
+                EXPECT_EQ(Tracked::alive, 0);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(VectorStorage, SlotsPastSizeHoldNoElement) {
+        {
+                alt::vector<Tracked> vec;
+                for (int i = 0; i < 100; i++) {
+                        vec.push_back(Tracked(i));
+                        ASSERT_EQ(Tracked::alive, (int)vec.size());
+                }
+                for (int i = 0; i < 100; i++) ASSERT_EQ(vec[i].value, i);
+
+                vec.insert(vec.begin() + 10, Tracked(-1));
+                EXPECT_EQ(Tracked::alive, 101);
+                EXPECT_EQ(vec[10].value, -1);
+                EXPECT_EQ(vec[11].value, 10);
+
+                vec.erase(vec.begin());
+                vec.pop_back();
+                EXPECT_EQ(Tracked::alive, 99);
+
+                vec.shrink_to_fit();
+                EXPECT_EQ(vec.capacity(), 99);
+                EXPECT_EQ(Tracked::alive, 99);
+
+                vec.assign(5, Tracked(7));
+                EXPECT_EQ(Tracked::alive, 5);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(VectorStorage, ClearDestroysOnlyLiveElements) {
+        alt::vector<Tracked> vec(10);
+        vec.push_back(Tracked(1));
+        vec.push_back(Tracked(2));
+        ASSERT_EQ(Tracked::alive, 2);
+
+        vec.clear();
+        EXPECT_EQ(Tracked::alive, 0);
+        EXPECT_EQ(vec.capacity(), 10);
+}
+
+TEST(VectorStorage, PushBackOwnElement) {
+        alt::vector<std::string> vec{"first"};
+        for (int i = 0; i < 10; i++) vec.push_back(vec[0]);  // Grows while copying from itself.
+
+        EXPECT_EQ(vec.size(), 11);
+        for (auto i = 0u; i < vec.size(); ++i) ASSERT_EQ(vec[i], "first");
+}
+
+// ============================================================================
+// TESTING VECTOR MOVE SEMANTICS
+// ============================================================================
+//! Element that counts its copies and moves; its move may throw unless NoexceptMove.
+template <bool NoexceptMove>
+struct Counted {
+        static int copies;  //!< Copy constructions and assignments.
+        static int moves;   //!< Move constructions and assignments.
+        int value;          //!< Payload.
+
+        Counted(int v = 0) : value{v} {}
+        Counted(const Counted& other) : value{other.value} { copies++; }
+        Counted(Counted&& other) noexcept(NoexceptMove) : value{other.value} { moves++; }
+        Counted& operator=(const Counted& other) {
+                value = other.value;
+                copies++;
+                return *this;
+        }
+        Counted& operator=(Counted&& other) noexcept(NoexceptMove) {
+                value = other.value;
+                moves++;
+                return *this;
+        }
+};
+
+template <bool NoexceptMove>
+int Counted<NoexceptMove>::copies = 0;
+template <bool NoexceptMove>
+int Counted<NoexceptMove>::moves = 0;
+
+TEST(VectorMove, MoveConstructorStealsStorage) {
+        alt::vector<std::string> vec{"a", "b", "c"};
+        const std::string* data = &vec[0];
+
+        alt::vector<std::string> vec2(std::move(vec));
+        EXPECT_EQ(&vec2[0], data);
+        EXPECT_EQ(vec2, (alt::vector<std::string>{"a", "b", "c"}));
+        EXPECT_EQ(vec.size(), 0);
+        EXPECT_EQ(vec.capacity(), 0);
+}
+
+TEST(VectorMove, PushBackMoveOnly) {
+        alt::vector<std::unique_ptr<int>> vec;
+        for (int i = 0; i < 20; i++) vec.push_back(std::make_unique<int>(i));
+
+        ASSERT_EQ(vec.size(), 20);
+        for (int i = 0; i < 20; i++) ASSERT_EQ(*vec[i], i);
+
+        vec.insert(vec.begin(), std::make_unique<int>(-1));
+        vec.emplace(vec.begin() + 5, new int(-5));
+        vec.shrink_to_fit();
+        EXPECT_EQ(*vec[0], -1);
+        EXPECT_EQ(*vec[5], -5);
+        EXPECT_EQ(*vec[6], 4);
+        EXPECT_EQ(vec.size(), 22);
+}
+
+TEST(VectorMove, EmplaceBack) {
+        alt::vector<std::pair<int, std::string>> vec;
+        auto& back = vec.emplace_back(1, "one");
+        EXPECT_EQ(back.second, "one");
+
+        vec.emplace_back(std::piecewise_construct, std::forward_as_tuple(2),
+                         std::forward_as_tuple(3, 'x'));
+        EXPECT_EQ(vec.back().second, "xxx");
+
+        // The argument is an element that moves during the growth.
+        while (vec.size() < vec.capacity()) vec.emplace_back(0, "");
+        vec.emplace_back(vec[0]);
+        EXPECT_EQ(vec.back(), (std::pair<int, std::string>(1, "one")));
+}
+
+TEST(VectorMove, EmplaceMiddle) {
+        alt::vector<std::string> vec{"a", "c"};
+        vec.reserve(10);
+
+        auto it = vec.emplace(vec.begin() + 1, 1, 'b');
+        EXPECT_EQ(*it, "b");
+        vec.emplace(vec.begin(), vec[2]);  // From an element that shifts.
+        EXPECT_EQ(vec, (alt::vector<std::string>{"c", "a", "b", "c"}));
+}
+
+TEST(VectorMove, GrowthMovesNoexceptElements) {
+        using Element = Counted<true>;
+        alt::vector<Element> vec;
+        for (int i = 0; i < 100; i++) vec.emplace_back(i);
+        vec.reserve(1000);
+        vec.insert(vec.begin(), Element(-1));
+        vec.shrink_to_fit();
+
+        EXPECT_EQ(Element::copies, 0);
+        for (int i = 0; i < 100; i++) ASSERT_EQ(vec[i + 1].value, i);
+}
+
+TEST(VectorMove, GrowthCopiesThrowingMoves) {
+        // Copies keep the old elements intact if the growth throws.
+        using Element = Counted<false>;
+        alt::vector<Element> vec;
+        for (int i = 0; i < 100; i++) vec.emplace_back(i);
+
+        Element::copies = 0;
+        vec.reserve(1000);
+        EXPECT_EQ(Element::copies, 100);
+}
+
+// ============================================================================
+// TESTING VECTOR OF TRIVIALLY COPYABLE ELEMENTS (MOVED AS BYTES)
+// ============================================================================
+TEST(TrivialVector, GrowsPastMappedThreshold) {
+        // 4 MB of ints: the last growths go through mremap on Linux.
+        alt::vector<int> vec;
+        for (int i = 0; i < 1000000; i++) vec.push_back(i);
+        for (int i = 0; i < 1000000; i++) ASSERT_EQ(vec[i], i);
+
+        alt::vector<int> copy(vec);
+        EXPECT_EQ(copy, vec);
+
+        vec.reserve(3000000);
+        EXPECT_EQ(vec.capacity(), 3000000);
+        EXPECT_EQ(vec, copy);
+
+        // Back under the threshold, to the heap.
+        while (vec.size() > 1000) vec.pop_back();
+        vec.shrink_to_fit();
+        EXPECT_EQ(vec.capacity(), 1000);
+        for (int i = 0; i < 1000; i++) ASSERT_EQ(vec[i], i);
+
+        vec.clear();
+        vec.shrink_to_fit();
+        EXPECT_EQ(vec.capacity(), 0);
+}
+
+TEST(TrivialVector, InsertEraseShiftBytes) {
+        alt::vector<int> vec;
+        for (int i = 0; i < 300000; i++) vec.push_back(i);
+
+        vec.insert(vec.begin() + 5, -1);
+        vec.insert(vec.begin(), vec[vec.size() - 1]);  // From an element that shifts.
+        EXPECT_EQ(vec.size(), 300002);
+        EXPECT_EQ(vec[0], 299999);
+        EXPECT_EQ(vec[6], -1);
+        EXPECT_EQ(vec[7], 5);
+        EXPECT_EQ(vec.back(), 299999);
+
+        vec.erase(vec.begin() + 6);
+        vec.erase(vec.begin());
+        for (int i = 0; i < 300000; i++) ASSERT_EQ(vec[i], i);
+}
+
+TEST(TrivialVector, PlainStruct) {
+        struct Point {
+                int x;
+                double y;
+        };
+
+        alt::vector<Point> vec;
+        for (int i = 0; i < 100; i++) vec.push_back(Point{i, i / 2.0});
+        vec.emplace(vec.begin() + 50, Point{-1, -1.0});
+        vec.erase(vec.begin());
+
+        EXPECT_EQ(vec.size(), 100);
+        EXPECT_EQ(vec[49].x, -1);
+        EXPECT_EQ(vec[50].x, 50);
+        EXPECT_EQ(vec[50].y, 25.0);
+}
+
+TEST(TrivialVector, OveralignedElements) {
+        struct alignas(64) Line {
+                char bytes[64];
+        };
+
+        alt::vector<Line> vec;
+        for (int i = 0; i < 100; i++) {
+                vec.push_back(Line{{char(i)}});
+                ASSERT_EQ(reinterpret_cast<uintptr_t>(&vec[0]) % 64, 0u);
+        }
+        for (int i = 0; i < 100; i++) ASSERT_EQ(vec[i].bytes[0], char(i));
+}
+
+// ============================================================================
+// TESTING VECTOR RANGE INSERT
+// ============================================================================
+TEST(RangeInsert, GrowsOnce) {
+        alt::vector<int> vec{1, 2, 3, 4};
+        std::vector<int> source(1000, 7);
+
+        auto it = vec.insert(vec.begin() + 2, source.begin(), source.end());
+        EXPECT_EQ(vec.size(), 1004);
+        EXPECT_EQ(vec.capacity(), 1004);  // Grown once, to fit.
+        EXPECT_EQ(*it, 7);
+        EXPECT_EQ(vec[1], 2);
+        EXPECT_EQ(vec[1001], 7);
+        EXPECT_EQ(vec[1002], 3);
+
+        // Empty range: nothing happens.
+        it = vec.insert(vec.begin() + 3, source.end(), source.end());
+        EXPECT_EQ(it, vec.begin() + 3);
+        EXPECT_EQ(vec.size(), 1004);
+}
+
+TEST(RangeInsert, InPlaceStrings) {
+        // Short range before a long tail, and long range before a short tail.
+        alt::vector<std::string> vec{"a", "b", "c", "d", "e"};
+        vec.reserve(20);
+        std::vector<std::string> source{"x", "y"};
+
+        vec.insert(vec.begin() + 1, source.begin(), source.end());
+        EXPECT_EQ(vec, (alt::vector<std::string>{"a", "x", "y", "b", "c", "d", "e"}));
+
+        vec.insert(vec.begin() + 6, {"p", "q", "r", "s"});
+        EXPECT_EQ(vec, (alt::vector<std::string>{"a", "x", "y", "b", "c", "d", "p", "q", "r",
+                                                 "s", "e"}));
+        EXPECT_EQ(vec.capacity(), 20);
+}
+
+TEST(RangeInsert, ElementsAlive) {
+        {
+                alt::vector<Tracked> vec;
+                vec.reserve(10);
+                for (int i = 0; i < 5; i++) vec.push_back(Tracked(i));
+                std::vector<Tracked> source(3, Tracked(9));
+
+                vec.insert(vec.begin() + 4, source.begin(), source.end());  // In place.
+                vec.insert(vec.begin(), source.begin(), source.end());      // Grows.
+                EXPECT_EQ(Tracked::alive, 14);
+                EXPECT_EQ(vec.size(), 11);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(RangeInsert, InputIterators) {
+        alt::vector<int> vec{1, 2, 3};
+        std::istringstream in("10 20 30 40");
+
+        auto it = vec.insert(vec.begin() + 1, std::istream_iterator<int>(in),
+                             std::istream_iterator<int>());
+        EXPECT_EQ(*it, 10);
+        EXPECT_EQ(vec, (alt::vector<int>{1, 10, 20, 30, 40, 2, 3}));
+}
+
+TEST(RangeInsert, MatchesStdVector) {
+        std::mt19937 rng(42);
+        alt::vector<int> vec;
+        std::vector<int> expected;
+        for (int round = 0; round < 200; round++) {
+                std::vector<int> source(rng() % 50);
+                for (auto& x : source) x = rng();
+
+                size_t index = rng() % (expected.size() + 1);
+                vec.insert(vec.begin() + index, source.begin(), source.end());
+                expected.insert(expected.begin() + index, source.begin(), source.end());
+        }
+
+        ASSERT_EQ(vec.size(), expected.size());
+        for (auto i = 0u; i < vec.size(); ++i) ASSERT_EQ(vec[i], expected[i]);
+}
+
+// ============================================================================
+// TESTING VECTOR ERASE AND ERASE_IF
+// ============================================================================
+TEST(VectorErase, RangeShiftsOnce) {
+        {
+                alt::vector<Tracked> vec;
+                for (int i = 0; i < 10; i++) vec.push_back(Tracked(i));
+
+                auto it = vec.erase(vec.begin() + 2, vec.begin() + 5);
+                EXPECT_EQ(it->value, 5);
+                EXPECT_EQ(vec.size(), 7);
+                EXPECT_EQ(Tracked::alive, 7);
+                for (int i = 0; i < 2; i++) ASSERT_EQ(vec[i].value, i);
+                for (int i = 2; i < 7; i++) ASSERT_EQ(vec[i].value, i + 3);
+
+                vec.erase(vec.begin() + 3, vec.begin() + 3);  // Empty range.
+                EXPECT_EQ(vec.size(), 7);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(VectorErase, ConstIterators) {
+        alt::vector<std::string> vec{"a", "b", "c", "d", "e"};
+
+        vec.erase(vec.cbegin() + 1);
+        EXPECT_EQ(vec, (alt::vector<std::string>{"a", "c", "d", "e"}));
+        vec.erase(vec.cbegin() + 1, vec.cend());
+        EXPECT_EQ(vec, (alt::vector<std::string>{"a"}));
+}
+
+TEST(VectorErase, EraseIfTrivial) {
+        std::mt19937 rng(7);
+        alt::vector<int> vec;
+        std::vector<int> expected;
+        for (int i = 0; i < 100000; i++) {
+                int x = rng() % 1000;
+                vec.push_back(x);
+                if (x % 3 != 0) expected.push_back(x);
+        }
+
+        auto erased = alt::erase_if(vec, [](int x) { return x % 3 == 0; });
+        EXPECT_EQ(erased, 100000 - expected.size());
+        ASSERT_EQ(vec.size(), expected.size());
+        for (auto i = 0u; i < vec.size(); ++i) ASSERT_EQ(vec[i], expected[i]);
+}
+
+TEST(VectorErase, EraseIfStrings) {
+        alt::vector<std::string> vec{"apple", "kiwi", "banana", "fig", "cherry"};
+
+        EXPECT_EQ(alt::erase_if(vec, [](const std::string& s) { return s.size() <= 4; }), 2);
+        EXPECT_EQ(vec, (alt::vector<std::string>{"apple", "banana", "cherry"}));
+
+        EXPECT_EQ(alt::erase(vec, "banana"), 1);
+        EXPECT_EQ(alt::erase(vec, "durian"), 0);
+        EXPECT_EQ(vec, (alt::vector<std::string>{"apple", "cherry"}));
+}
+
+TEST(VectorErase, EraseIfEmpty) {
+        alt::vector<int> vec;
+        EXPECT_EQ(alt::erase_if(vec, [](int) { return true; }), 0);
+
+        vec = {1, 2, 3};
+        EXPECT_EQ(alt::erase_if(vec, [](int) { return true; }), 3);
+        EXPECT_TRUE(vec.empty());
+}
+
+// ============================================================================
+// TESTING VECTOR ITERATORS
+// ============================================================================
+TEST(VectorIterator, RandomAccess) {
+        using Iterator = alt::vector<int>::iterator;
+        static_assert(std::is_same<std::iterator_traits<Iterator>::iterator_category,
+                                   std::random_access_iterator_tag>::value,
+                      "random access");
+#if __cplusplus >= 202002L
+        static_assert(std::contiguous_iterator<Iterator>);
+        static_assert(std::contiguous_iterator<alt::vector<int>::const_iterator>);
+#endif
+
+        alt::vector<int> vec{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        auto it = vec.begin();
+
+        EXPECT_EQ(*(it + 3), 3);
+        EXPECT_EQ(*(3 + it), 3);
+        EXPECT_EQ(it[7], 7);
+        it += 5;
+        EXPECT_EQ(*it, 5);
+        it -= 2;
+        EXPECT_EQ(*it, 3);
+        EXPECT_EQ(*(it - 1), 2);
+        EXPECT_EQ(*it++, 3);
+        EXPECT_EQ(*it--, 4);
+        EXPECT_EQ(*--it, 2);
+        EXPECT_EQ(*++it, 3);
+
+        EXPECT_EQ(vec.end() - vec.begin(), 10);
+        EXPECT_EQ(std::distance(vec.begin(), vec.end()), 10);
+        EXPECT_TRUE(vec.begin() < vec.end());
+        EXPECT_TRUE(vec.end() > it);
+        EXPECT_TRUE(it <= it && it >= it);
+        EXPECT_FALSE(it < it);
+}
+
+TEST(VectorIterator, ConstConversion) {
+        alt::vector<int> vec{1, 2, 3};
+        alt::vector<int>::const_iterator it = vec.begin();
+
+        EXPECT_EQ(*it, 1);
+        EXPECT_TRUE(it == vec.begin());
+        EXPECT_TRUE(vec.begin() == it);
+        EXPECT_TRUE(vec.end() != it);
+        EXPECT_EQ(vec.cend() - vec.begin(), 3);
+        EXPECT_TRUE(it < vec.end());
+}
+
+TEST(VectorIterator, StandardAlgorithms) {
+        alt::vector<int> vec;
+        std::mt19937 rng(3);
+        for (int i = 0; i < 1000; i++) vec.push_back(rng() % 100);
+
+        std::sort(vec.begin(), vec.end());
+        EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+
+        auto lower = std::lower_bound(vec.begin(), vec.end(), 50);
+        EXPECT_TRUE(lower == vec.end() || *lower >= 50);
+        EXPECT_TRUE(lower == vec.begin() || *(lower - 1) < 50);
+
+        std::reverse(vec.begin(), vec.end());
+        EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end(), std::greater<int>()));
+
+        alt::vector<int> copy(vec.size());
+        for (auto i = 0u; i < vec.size(); ++i) copy.push_back(0);
+        std::copy(vec.cbegin(), vec.cend(), copy.begin());
+        EXPECT_EQ(copy, vec);
+}
+
+// ============================================================================
+// TESTING SMALL VECTOR: UP TO N ELEMENTS INLINE, THE REST ON THE HEAP
+// ============================================================================
+TEST(SmallVector, StaysInlineUpToN) {
+        alt::small_vector<int, 4> vec;
+        EXPECT_TRUE(vec.is_small());
+        EXPECT_EQ(vec.capacity(), 4);
+
+        for (int i = 0; i < 4; i++) vec.push_back(i);
+        EXPECT_TRUE(vec.is_small());
+        EXPECT_EQ(vec.capacity(), 4);
+
+        // The inline buffer is part of the container itself.
+        auto address = reinterpret_cast<uintptr_t>(vec.data());
+        auto object = reinterpret_cast<uintptr_t>(&vec);
+        EXPECT_TRUE(address >= object && address < object + sizeof(vec));
+
+        vec.push_back(4);
+        EXPECT_FALSE(vec.is_small());
+        EXPECT_EQ(vec.capacity(), 8);
+        for (int i = 0; i < 5; i++) ASSERT_EQ(vec[i], i);
+
+        // alt::vector itself pays nothing for it: its vtable pointer and three words.
+        EXPECT_EQ(sizeof(alt::vector<int>), sizeof(void*) + sizeof(int*) + 2 * sizeof(size_t));
+}
+
+TEST(SmallVector, SameApiAsVector) {
+        alt::small_vector<std::string, 2> vec{"b", "d"};
+        vec.insert(vec.begin(), "a");
+        vec.emplace(vec.cbegin() + 2, 1, 'c');
+        vec.emplace_back("e");
+        EXPECT_EQ(vec, (alt::small_vector<std::string, 2>{"a", "b", "c", "d", "e"}));
+
+        vec.erase(vec.begin() + 1, vec.begin() + 3);
+        vec.pop_back();
+        EXPECT_EQ(vec.front(), "a");
+        EXPECT_EQ(vec.back(), "d");
+        EXPECT_THROW(vec.at(2), std::out_of_range);
+
+        std::vector<std::string> source{"x", "y", "z"};
+        vec.insert(vec.end(), source.begin(), source.end());
+        EXPECT_EQ(alt::erase(vec, "y"), 1);
+        EXPECT_EQ(alt::erase_if(vec, [](const std::string& s) { return s < "b"; }), 1);
+        EXPECT_EQ(vec, (alt::small_vector<std::string, 2>{"d", "x", "z"}));
+
+        vec.assign(2, "w");
+        EXPECT_EQ(vec.size(), 2);
+        EXPECT_NE(vec, (alt::small_vector<std::string, 2>{"w"}));
+}
+
+TEST(SmallVector, MoveInlineAndHeap) {
+        alt::small_vector<std::string, 4> small{"a", "b"};
+        alt::small_vector<std::string, 4> moved(std::move(small));
+        EXPECT_TRUE(moved.is_small());
+        EXPECT_EQ(moved, (alt::small_vector<std::string, 4>{"a", "b"}));
+        EXPECT_TRUE(small.empty());
+
+        alt::small_vector<std::string, 4> large{"a", "b", "c", "d", "e"};
+        const std::string* data = large.data();
+        moved = std::move(large);
+        EXPECT_FALSE(moved.is_small());
+        EXPECT_EQ(moved.data(), data);  // The heap memory changes hands.
+        EXPECT_TRUE(large.empty());
+        EXPECT_TRUE(large.is_small());
+
+        large.push_back("f");  // The moved-from container is still usable.
+        moved = std::move(large);
+        EXPECT_FALSE(moved.is_small());  // The elements move into the heap memory it has.
+        EXPECT_EQ(moved, (alt::small_vector<std::string, 4>{"f"}));
+}
+
+TEST(SmallVector, ShrinkBackInline) {
+        alt::small_vector<std::unique_ptr<int>, 4> vec;
+        for (int i = 0; i < 10; i++) vec.push_back(std::make_unique<int>(i));
+        EXPECT_FALSE(vec.is_small());
+
+        vec.erase(vec.begin() + 3, vec.end());
+        vec.shrink_to_fit();
+        EXPECT_TRUE(vec.is_small());
+        EXPECT_EQ(vec.capacity(), 4);
+        for (int i = 0; i < 3; i++) ASSERT_EQ(*vec[i], i);
+}
+
+TEST(SmallVector, InlineHeapSwitchKeepsElements) {
+        {
+                alt::small_vector<Tracked, 4> vec;
+                for (int i = 0; i < 4; i++) vec.push_back(Tracked(i));
+                EXPECT_TRUE(vec.is_small());
+
+                vec.push_back(Tracked(4));  // The elements move out of the inline buffer.
+                EXPECT_FALSE(vec.is_small());
+                EXPECT_EQ(Tracked::alive, 5);
+
+                vec.pop_back();
+                vec.shrink_to_fit();  // And back in.
+                EXPECT_TRUE(vec.is_small());
+                EXPECT_EQ(Tracked::alive, 4);
+                for (int i = 0; i < 4; i++) ASSERT_EQ(vec[i].value, i);
+
+                // A heap container copied into an inline one, and the other way around.
+                alt::small_vector<Tracked, 4> large(6);
+                for (int i = 0; i < 6; i++) large.push_back(Tracked(10 + i));
+                vec = large;
+                EXPECT_FALSE(vec.is_small());
+                large = alt::small_vector<Tracked, 4>{Tracked(1)};
+                EXPECT_EQ(Tracked::alive, 6 + 1);
+                EXPECT_EQ(vec[5].value, 15);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+// ============================================================================
+// TESTING STATIC VECTOR: FIXED CAPACITY, NO HEAP
+// ============================================================================
+//! Builds a static_vector at compile time.
+constexpr alt::static_vector<int, 8> make_static(void) {
+        alt::static_vector<int, 8> vec{3, 1};
+        vec.push_back(4);
+        vec.insert(vec.begin() + 1, 9);
+        vec.emplace_back(5);
+        vec.erase(vec.begin());
+        vec.insert(vec.cend(), {2, 6});
+        return vec;
+}
+
+TEST(StaticVector, Constexpr) {
+        constexpr alt::static_vector<int, 8> vec = make_static();
+        static_assert(vec.size() == 6, "size");
+        static_assert(vec.capacity() == 8, "capacity");
+        static_assert(vec[0] == 9 && vec[1] == 1 && vec.back() == 6, "elements");
+        static_assert(vec == alt::static_vector<int, 8>{9, 1, 4, 5, 2, 6}, "equality");
+
+        EXPECT_EQ(vec, (alt::static_vector<int, 8>{9, 1, 4, 5, 2, 6}));
+        EXPECT_EQ(*std::max_element(vec.cbegin(), vec.cend()), 9);
+}
+
+TEST(StaticVector, NoHeap) {
+        alt::static_vector<std::string, 4> vec;
+        vec.push_back("a");
+
+        // The elements are part of the container itself.
+        auto address = reinterpret_cast<uintptr_t>(vec.data());
+        auto object = reinterpret_cast<uintptr_t>(&vec);
+        EXPECT_TRUE(address >= object && address < object + sizeof(vec));
+        EXPECT_EQ(vec.capacity(), 4);
+}
+
+TEST(StaticVector, OverflowThrows) {
+        alt::static_vector<int, 4> vec{1, 2, 3};
+        vec.push_back(4);
+        EXPECT_THROW(vec.push_back(5), std::length_error);
+        EXPECT_THROW(vec.insert(vec.begin(), 0), std::length_error);
+        EXPECT_THROW(vec.reserve(5), std::length_error);
+        EXPECT_EQ(vec, (alt::static_vector<int, 4>{1, 2, 3, 4}));  // Untouched.
+
+        EXPECT_EQ(vec.try_push_back(5), nullptr);
+        vec.pop_back();
+        int* slot = vec.try_emplace_back(7);
+        ASSERT_NE(slot, nullptr);
+        EXPECT_EQ(*slot, 7);
+
+        vec.erase(vec.begin(), vec.begin() + 2);
+        std::vector<int> source{8, 9, 10};
+        EXPECT_THROW(vec.insert(vec.begin(), source.begin(), source.end()), std::length_error);
+        EXPECT_THROW(vec.assign(5, 0), std::length_error);
+        EXPECT_EQ(vec, (alt::static_vector<int, 4>{3, 7}));
+
+        EXPECT_THROW((alt::static_vector<int, 2>{1, 2, 3}), std::length_error);
+}
+
+TEST(StaticVector, SinglePassRangeOverflow) {
+        // The size of an input iterator range is only known once it is read.
+        alt::static_vector<std::string, 4> vec{"a", "b"};
+        std::istringstream in("x y z");
+        using Input = std::istream_iterator<std::string>;
+        EXPECT_THROW(vec.insert(vec.begin(), Input(in), Input()), std::length_error);
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 4>{"a", "b"}));
+
+        std::istringstream five("v w x y z");
+        EXPECT_THROW(vec.assign(Input(five), Input()), std::length_error);
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 4>{"a", "b"}));
+
+        std::istringstream four("w x y z");
+        vec.assign(Input(four), Input());
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 4>{"w", "x", "y", "z"}));
+
+        std::istringstream two("1 2");
+        vec.erase(vec.begin() + 1, vec.end() - 1);
+        vec.insert(vec.begin() + 1, Input(two), Input());
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 4>{"w", "1", "2", "z"}));
+}
+
+TEST(StaticVector, SameApiAsVector) {
+        alt::static_vector<std::string, 8> vec{"b", "d"};
+        vec.insert(vec.begin(), "a");
+        vec.emplace(vec.cbegin() + 2, 1, 'c');
+        vec.emplace_back("e");
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 8>{"a", "b", "c", "d", "e"}));
+
+        std::vector<std::string> source{"x", "y"};
+        vec.insert(vec.begin() + 1, source.begin(), source.end());
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 8>{"a", "x", "y", "b", "c", "d", "e"}));
+
+        vec.erase(vec.begin() + 1, vec.begin() + 3);
+        EXPECT_EQ(alt::erase(vec, "c"), 1);
+        EXPECT_EQ(alt::erase_if(vec, [](const std::string& s) { return s > "c"; }), 2);
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 8>{"a", "b"}));
+        EXPECT_THROW(vec.at(2), std::out_of_range);
+
+        std::istringstream words("p q r");
+        vec.insert(vec.cbegin() + 1, std::istream_iterator<std::string>(words),
+                   std::istream_iterator<std::string>());
+        EXPECT_EQ(vec, (alt::static_vector<std::string, 8>{"a", "p", "q", "r", "b"}));
+}
+
+TEST(StaticVector, FullContainerEdges) {
+        {
+                alt::static_vector<Tracked, 4> vec{Tracked(0), Tracked(1), Tracked(3)};
+                vec.insert(vec.begin() + 2, Tracked(2));  // Fills the last slot.
+                EXPECT_EQ(Tracked::alive, 4);
+                for (int i = 0; i < 4; i++) ASSERT_EQ(vec[i].value, i);
+
+                // Rejected while full: nothing is constructed, nothing moves.
+                EXPECT_THROW(vec.insert(vec.begin(), Tracked(-1)), std::length_error);
+                EXPECT_EQ(vec.try_emplace_back(-1), nullptr);
+                EXPECT_EQ(Tracked::alive, 4);
+                EXPECT_EQ(vec[0].value, 0);
+
+                vec.erase(vec.begin(), vec.begin() + 3);
+                EXPECT_EQ(Tracked::alive, 1);
+                EXPECT_EQ(vec[0].value, 3);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+// ============================================================================
+// TESTING SEGMENTED VECTOR: CHUNKS OF GEOMETRIC SIZES, STABLE ELEMENTS
+// ============================================================================
+TEST(SegmentedVector, StableAddresses) {
+        alt::segmented_vector<int> vec;
+        std::vector<const int*> addresses;
+        for (int i = 0; i < 100000; i++) {
+                vec.push_back(i);
+                addresses.push_back(&vec.back());
+        }
+
+        // Growth never moves an element.
+        for (int i = 0; i < 100000; i++) ASSERT_EQ(&vec[i], addresses[i]);
+        for (int i = 0; i < 100000; i++) ASSERT_EQ(vec[i], i);
+
+        vec.reserve(1000000);
+        EXPECT_GE(vec.capacity(), 1000000);
+        EXPECT_EQ(&vec[99999], addresses[99999]);
+}
+
+TEST(SegmentedVector, GeometricChunks) {
+        alt::segmented_vector<int> vec;
+        EXPECT_EQ(vec.capacity(), 0);
+        EXPECT_EQ(vec.chunk_count(), 0);
+
+        for (int i = 0; i < 100; i++) vec.push_back(i);
+        EXPECT_EQ(vec.chunk_count(), 3);  // 16 + 32 + 64 slots.
+        EXPECT_EQ(vec.capacity(), 112);
+        EXPECT_EQ(vec.chunk_size(0), 16);
+        EXPECT_EQ(vec.chunk_size(1), 32);
+        EXPECT_EQ(vec.chunk_size(2), 52);
+
+        // Each chunk is a contiguous array, in order.
+        int expected = 0;
+        for (auto k = 0u; k < vec.chunk_count(); ++k) {
+                const int* chunk = vec.chunk_data(k);
+                for (auto i = 0u; i < vec.chunk_size(k); ++i) ASSERT_EQ(chunk[i], expected++);
+        }
+        EXPECT_EQ(expected, 100);
+
+        while (vec.size() > 20) vec.pop_back();
+        vec.shrink_to_fit();
+        EXPECT_EQ(vec.capacity(), 48);
+        EXPECT_EQ(vec.back(), 19);
+}
+
+TEST(SegmentedVector, RandomAccessIterators) {
+        alt::segmented_vector<int> vec;
+        std::vector<int> expected;
+        std::mt19937 rng(5);
+        for (int i = 0; i < 5000; i++) {
+                vec.push_back(rng() % 1000);
+                expected.push_back(vec.back());
+        }
+
+        std::sort(vec.begin(), vec.end());
+        std::sort(expected.begin(), expected.end());
+        EXPECT_TRUE(std::equal(vec.cbegin(), vec.cend(), expected.begin()));
+
+        auto it = std::lower_bound(vec.cbegin(), vec.cend(), 500);
+        EXPECT_EQ(it - vec.cbegin(), std::lower_bound(expected.begin(), expected.end(), 500) -
+                                             expected.begin());
+
+        auto last = vec.end();
+        --last;
+        EXPECT_EQ(*last, expected.back());
+        EXPECT_EQ(vec.begin()[4000], expected[4000]);
+        EXPECT_EQ(*(vec.end() - 1), expected.back());
+        EXPECT_EQ(std::distance(vec.begin(), vec.end()), 5000);
+        EXPECT_THROW(vec.at(5000), std::out_of_range);
+}
+
+TEST(SegmentedVector, CopyAndMove) {
+        alt::segmented_vector<std::string> vec{"a", "b", "c"};
+        for (int i = 0; i < 50; i++) vec.emplace_back(std::string(40, char('a' + i % 26)));
+
+        alt::segmented_vector<std::string> copy(vec);
+        EXPECT_EQ(copy, vec);
+
+        const std::string* first = &vec[0];
+        alt::segmented_vector<std::string> moved(std::move(vec));
+        EXPECT_EQ(&moved[0], first);  // The chunks change hands.
+        EXPECT_TRUE(vec.empty());
+
+        vec = moved;
+        EXPECT_EQ(vec, copy);
+        vec.push_back(vec[0]);  // From an element: it stays put.
+        EXPECT_EQ(vec.back(), "a");
+        EXPECT_NE(vec, copy);
+}
+
+TEST(SegmentedVector, ChunkBoundary) {
+        {
+                // The first chunk holds 16 elements, the second the next 32.
+                alt::segmented_vector<Tracked> vec;
+                for (int i = 0; i < 16; i++) vec.push_back(Tracked(i));
+                const Tracked* last_of_first = &vec[15];
+
+                vec.push_back(Tracked(16));
+                EXPECT_EQ(&vec[15], last_of_first);
+                EXPECT_EQ(Tracked::alive, 17);
+                EXPECT_EQ((*(vec.begin() + 16)).value, 16);  // Iterators step into the next chunk.
+
+                vec.pop_back();  // Back to a full first chunk, the second one kept.
+                EXPECT_EQ(Tracked::alive, 16);
+                EXPECT_EQ(vec.capacity(), 48);
+                vec.push_back(Tracked(-16));
+                EXPECT_EQ(vec.back().value, -16);
+
+                alt::segmented_vector<Tracked> copy(vec);
+                EXPECT_EQ(Tracked::alive, 34);
+                EXPECT_EQ(copy[16].value, -16);
+                vec.shrink_to_fit();
+                EXPECT_EQ(vec.capacity(), 48);
+        }
+        EXPECT_EQ(Tracked::alive, 0);
+}
+
+// ============================================================================
+// TESTING CONCURRENT VECTOR: LOCK-FREE APPENDS FROM MANY THREADS
+// ============================================================================
+//! Record appended by a thread: check is derived from the other fields.
+struct Record {
+        int thread;  //!< Thread that appended it.
+        int seq;     //!< Sequence number in the thread.
+        long check;  //!< thread * 1000003 + seq.
+
+        Record(int t = 0, int s = 0) : thread{t}, seq{s}, check{t * 1000003L + s} {}
+};
+
+TEST(ConcurrentVector, SingleThread) {
+        alt::concurrent_vector<std::string> vec;
+        EXPECT_TRUE(vec.empty());
+
+        EXPECT_EQ(vec.push_back("a"), 0);
+        EXPECT_EQ(vec.emplace_back(3, 'b'), 1);
+        EXPECT_EQ(vec.grow_by(100, "c"), 2);
+        std::vector<std::string> source{"x", "y"};
+        EXPECT_EQ(vec.grow_by(source.begin(), source.end()), 102);
+
+        ASSERT_EQ(vec.size(), 104);
+        EXPECT_EQ(vec[0], "a");
+        EXPECT_EQ(vec[1], "bbb");
+        EXPECT_EQ(vec[101], "c");
+        EXPECT_EQ(vec.at(103), "y");
+        EXPECT_THROW(vec.at(104), std::out_of_range);
+
+        const std::string* first = &vec[0];
+        for (int i = 0; i < 10000; i++) vec.push_back("d");
+        EXPECT_EQ(&vec[0], first);  // Elements never move.
+
+        vec.clear();
+        EXPECT_EQ(vec.size(), 0);
+        EXPECT_EQ(vec.push_back("e"), 0);
+        EXPECT_EQ(vec[0], "e");
+}
+
+TEST(ConcurrentVector, ManyWriters) {
+        const int threads = 8, per_thread = 20000;
+        alt::concurrent_vector<Record> vec;
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; t++) {
+                writers.emplace_back([&vec, t] {
+                        for (int i = 0; i < per_thread; i += 2) {
+                                if (i % 10 == 0) {
+                                        Record pair[2] = {Record(t, i), Record(t, i + 1)};
+                                        vec.grow_by(pair, pair + 2);
+                                } else {
+                                        vec.push_back(Record(t, i));
+                                        vec.emplace_back(t, i + 1);
+                                }
+                        }
+                });
+        }
+        for (auto& writer : writers) writer.join();
+
+        // Every record is there once, and each thread's records are in order.
+        ASSERT_EQ(vec.size(), threads * per_thread);
+        std::vector<int> next(threads, 0);
+        for (size_t i = 0; i < vec.size(); i++) {
+                const Record& record = vec[i];
+                ASSERT_EQ(record.check, record.thread * 1000003L + record.seq);
+                ASSERT_EQ(record.seq, next[record.thread]++);
+        }
+        for (int t = 0; t < threads; t++) EXPECT_EQ(next[t], per_thread);
+}
+
+TEST(ConcurrentVector, ReadersSeePublishedElements) {
+        const int threads = 4, per_thread = 50000;
+        alt::concurrent_vector<Record> vec;
+        std::atomic<bool> done{false};
+
+        // The reader checks every element below the size it reads, while the writers append.
+        std::atomic<long> checked{0};
+        std::thread reader([&] {
+                size_t seen = 0;
+                while (!done.load() || seen < vec.size()) {
+                        size_t size = vec.size();
+                        ASSERT_GE(size, seen);  // The size only grows.
+                        for (; seen < size; seen++) {
+                                const Record& record = vec[seen];
+                                ASSERT_EQ(record.check, record.thread * 1000003L + record.seq);
+                        }
+                        checked.store(seen);
+                }
+        });
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; t++) {
+                writers.emplace_back([&vec, t] {
+                        for (int i = 0; i < per_thread; i++) vec.push_back(Record(t, i));
+                });
+        }
+        for (auto& writer : writers) writer.join();
+        done.store(true);
+        reader.join();
+
+        EXPECT_EQ(checked.load(), threads * per_thread);
+}
+
+TEST(ConcurrentVector, GrowBySpansChunks) {
+        // Each element holds a copy of token: its use count is 1 + the live elements.
+        auto token = std::make_shared<int>(0);
+        {
+                // Chunks hold 16, 32 and 64 elements: [10, 60) spans three of them.
+                alt::concurrent_vector<std::shared_ptr<int>> vec;
+                for (int i = 0; i < 10; i++) vec.push_back(nullptr);
+                EXPECT_EQ(vec.grow_by(50, token), 10);
+                EXPECT_EQ(vec.size(), 60);
+                EXPECT_EQ(token.use_count(), 1 + 50);
+                EXPECT_EQ(vec[9], nullptr);
+                EXPECT_EQ(vec[15], token);
+                EXPECT_EQ(vec[16], token);
+                EXPECT_EQ(vec[59], token);
+
+                vec.clear();
+                EXPECT_EQ(token.use_count(), 1);
+                EXPECT_EQ(vec.grow_by(17, token), 0);
+                EXPECT_EQ(token.use_count(), 1 + 17);
+        }
+        EXPECT_EQ(token.use_count(), 1);
+}
+
 int main(int argc, char** argv) {
         ::testing::InitGoogleTest(&argc, argv);
         return RUN_ALL_TESTS();